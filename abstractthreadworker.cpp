@@ -9,8 +9,34 @@ int CAbstractThreadWorker::workerWeight()
     return 0;
 }
 
+CAbstractThreadWorker::WorkerCategory CAbstractThreadWorker::workerCategory() const
+{
+    return wcGeneric;
+}
+
+CAbstractThreadWorker::WorkerPriority CAbstractThreadWorker::workerPriority() const
+{
+    return m_priority;
+}
+
+void CAbstractThreadWorker::setWorkerPriority(WorkerPriority priority)
+{
+    m_priority = priority;
+}
+
+bool CAbstractThreadWorker::isQueued() const
+{
+    return m_queued.loadAcquire();
+}
+
 void CAbstractThreadWorker::start()
 {
+    // Queued worker is started by executor after dispatching to its thread
+    if (m_queued.loadAcquire()) {
+        m_startRequested.storeRelease(true);
+        return;
+    }
+
     resetAbortFlag();
     Q_EMIT started();
     m_started = true;
@@ -8,10 +8,32 @@ class CAbstractTranslator;
 class CAbstractThreadWorker : public QObject
 {
     friend class CAbstractTranslator;
+    friend class CWorkerExecutor;
 
     Q_OBJECT
+public:
+    enum WorkerCategory {
+        wcGeneric,
+        wcTranslator,
+        wcExtractor,
+        wcWriter,
+        wcScheduler,
+        wcIndexer
+    };
+    Q_ENUM(WorkerCategory)
+
+    enum WorkerPriority {
+        wpLow = -1,
+        wpNormal = 0,
+        wpHigh = 1
+    };
+    Q_ENUM(WorkerPriority)
+
 private:
     QAtomicInteger<bool> m_started;
+    QAtomicInteger<bool> m_queued;
+    QAtomicInteger<bool> m_startRequested;
+    WorkerPriority m_priority { wpNormal };
     QAtomicInteger<bool> m_abortFlag;
     QAtomicInteger<bool> m_abortedFinished;
     qint64 m_loadedTotalSize { 0L };
@@ -28,6 +50,11 @@ public:
     explicit CAbstractThreadWorker(QObject *parent = nullptr);
     virtual QString workerDescription() const = 0;
     virtual int workerWeight();
+    virtual WorkerCategory workerCategory() const;
+
+    WorkerPriority workerPriority() const;
+    void setWorkerPriority(WorkerPriority priority);
+    bool isQueued() const;
 
     qint64 loadedTotalSize() const;
     qint64 loadedRequestCount() const;
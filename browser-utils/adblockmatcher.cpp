@@ -0,0 +1,267 @@
+#include <QUrl>
+#include <QQueue>
+#include <QMutexLocker>
+#include <limits>
+#include "adblockmatcher.h"
+#include "global/structures.h"
+
+namespace CDefaults {
+const int adblockMinTokenLength = 2;
+}
+
+void CAdBlockMatcher::invalidate()
+{
+    m_valid.storeRelease(false);
+}
+
+bool CAdBlockMatcher::isValid() const
+{
+    return m_valid.loadAcquire();
+}
+
+bool CAdBlockMatcher::isTokenChar(QChar ch)
+{
+    return ch.isLetterOrNumber();
+}
+
+bool CAdBlockMatcher::canMatch(const CAdBlockRule &rule)
+{
+    if (rule.isCSSRule() || !rule.isEnabled())
+        return false;
+
+    // CAdBlockRule::networkMatch supports only single 'domain=' option, other rules never match
+    const QStringList options = rule.options();
+    if (options.isEmpty())
+        return true;
+
+    return ((options.count() == 1) && options.first().startsWith(QSL("domain=")));
+}
+
+QString CAdBlockMatcher::ruleToken(const CAdBlockRule &rule)
+{
+    QString pattern = rule.filter();
+    if (pattern.startsWith(QSL("@@")))
+        pattern = pattern.mid(2);
+    const int options = pattern.indexOf(u'$');
+    if (options >= 0)
+        pattern.truncate(options);
+    if (pattern.startsWith(u'/') && pattern.endsWith(u'/'))
+        return QString(); // regexp rule
+
+    // Select longest literal run, which is guaranteed to form a whole token in the matched URL:
+    // bounded by separator, anchor or literal non-token char on both sides, not by wildcard.
+    QString res;
+    const int length = pattern.length();
+    int pos = 0;
+    while (pos < length) {
+        if (!isTokenChar(pattern.at(pos))) {
+            pos++;
+            continue;
+        }
+        const int start = pos;
+        while (pos < length && isTokenChar(pattern.at(pos)))
+            pos++;
+
+        const bool leftBound = (start > 0) && (pattern.at(start - 1) != u'*');
+        const bool rightBound = (pos < length) && (pattern.at(pos) != u'*');
+        if (leftBound && rightBound && (pos - start) > res.length())
+            res = pattern.mid(start, pos - start);
+    }
+
+    if (res.length() < CDefaults::adblockMinTokenLength)
+        return QString();
+
+    return res.toLower();
+}
+
+QStringList CAdBlockMatcher::ruleDomains(const CAdBlockRule &rule)
+{
+    QStringList res;
+    const QStringList options = rule.options();
+    if (options.count() != 1 || !options.first().startsWith(QSL("domain=")))
+        return res;
+
+    const QStringList domainOptions = options.first().mid(7).split(u'|');
+    for (const QString &domain : domainOptions) {
+        if (domain.isEmpty() || domain.startsWith(u'~')) // negated domain can match any host
+            return QStringList();
+        res.append(domain);
+    }
+    return res;
+}
+
+void CAdBlockMatcher::buildAutomaton(Index &index, const QVector<QPair<QString, int> > &patterns)
+{
+    index.transitions.clear();
+    index.fail.assign(1,0);
+    index.output.assign(1,-1);
+    std::vector<QVector<int> > children(1);
+
+    for (const auto &pattern : patterns) {
+        int state = 0;
+        for (const QChar &ch : pattern.first) {
+            const quint64 key = transitionKey(state,ch);
+            auto it = index.transitions.constFind(key);
+            if (it == index.transitions.constEnd()) {
+                const int node = static_cast<int>(index.fail.size());
+                index.fail.push_back(0);
+                index.output.push_back(-1);
+                children.emplace_back();
+                children[state].append(node);
+                index.transitions.insert(key,node);
+                state = node;
+            } else {
+                state = it.value();
+            }
+        }
+        if (index.output[state] < 0 || pattern.second < index.output[state])
+            index.output[state] = pattern.second;
+    }
+
+    // Failure links in BFS order, propagate lowest rule index through dictionary suffixes
+    QHash<int,QChar> edgeChar;
+    edgeChar.reserve(index.transitions.count());
+    for (auto it = index.transitions.constBegin(), end = index.transitions.constEnd(); it != end; ++it)
+        edgeChar.insert(it.value(),QChar(static_cast<char16_t>(it.key() & 0xffff)));
+
+    QQueue<int> queue;
+    for (const int child : qAsConst(children.front()))
+        queue.enqueue(child);
+
+    while (!queue.isEmpty()) {
+        const int node = queue.dequeue();
+        for (const int child : qAsConst(children[node])) {
+            const QChar ch = edgeChar.value(child);
+            int state = index.fail[node];
+            while (state > 0 && !index.transitions.contains(transitionKey(state,ch)))
+                state = index.fail[state];
+            const int target = index.transitions.value(transitionKey(state,ch),0);
+            index.fail[child] = (target == child) ? 0 : target;
+
+            const int inherited = index.output[index.fail[child]];
+            if (inherited >= 0 && (index.output[child] < 0 || inherited < index.output[child]))
+                index.output[child] = inherited;
+
+            queue.enqueue(child);
+        }
+    }
+}
+
+int CAdBlockMatcher::matchAutomaton(const Index &index, const QString &lowerUrl)
+{
+    int res = -1;
+    if (index.fail.size() < 2) return res;
+
+    int state = 0;
+    for (const QChar &ch : lowerUrl) {
+        while (state > 0 && !index.transitions.contains(transitionKey(state,ch)))
+            state = index.fail[state];
+        state = index.transitions.value(transitionKey(state,ch),0);
+
+        const int out = index.output[state];
+        if (out >= 0 && (res < 0 || out < res))
+            res = out;
+    }
+    return res;
+}
+
+void CAdBlockMatcher::rebuild(const CAdBlockVector &rules)
+{
+    m_valid.storeRelease(true);
+
+    auto index = QSharedPointer<Index>::create();
+    QVector<QPair<QString,int> > plainPatterns;
+
+    for (const auto &rule : rules) {
+        if (!canMatch(rule)) continue;
+
+        const int idx = static_cast<int>(index->rules.size());
+        index->rules.push_back(rule);
+
+        // Plain rules without anchors are decided by substring search alone
+        const QString plain = rule.plainRule();
+        if (!plain.isEmpty() && !plain.contains(u'|')) {
+            plainPatterns.append(qMakePair(plain.toLower(),idx));
+            continue;
+        }
+
+        const QString token = ruleToken(rule);
+        if (!token.isEmpty()) {
+            index->tokens[token].append(idx);
+            continue;
+        }
+
+        const QStringList domains = ruleDomains(rule);
+        if (!domains.isEmpty()) {
+            for (const auto &domain : domains)
+                index->domains[domain].append(idx);
+            continue;
+        }
+
+        index->generic.append(idx);
+    }
+
+    buildAutomaton(*index,plainPatterns);
+
+    const QMutexLocker locker(&m_indexMutex);
+    m_index = index;
+}
+
+bool CAdBlockMatcher::match(const QString &encodedUrl, QString &filter) const
+{
+    QSharedPointer<const Index> index;
+    {
+        const QMutexLocker locker(&m_indexMutex);
+        index = m_index;
+    }
+    if (index.isNull()) return false;
+
+    // Rule order is preserved, so the first rule from the list is always reported
+    const int notFound = std::numeric_limits<int>::max();
+    int best = notFound;
+    const auto checkCandidates = [&index,&best,&encodedUrl](const QVector<int> &candidates){
+        for (const int idx : candidates) {
+            if (idx >= best) break;
+            if (index->rules.at(idx).networkMatch(encodedUrl)) {
+                best = idx;
+                break;
+            }
+        }
+    };
+
+    const QString lowerUrl = encodedUrl.toLower();
+    const int plainMatch = matchAutomaton(*index,lowerUrl);
+    if (plainMatch >= 0)
+        best = plainMatch;
+
+    const int length = lowerUrl.length();
+    int pos = 0;
+    while (pos < length) {
+        if (!isTokenChar(lowerUrl.at(pos))) {
+            pos++;
+            continue;
+        }
+        const int start = pos;
+        while (pos < length && isTokenChar(lowerUrl.at(pos)))
+            pos++;
+
+        auto it = index->tokens.constFind(lowerUrl.mid(start, pos - start));
+        if (it != index->tokens.constEnd())
+            checkCandidates(it.value());
+    }
+
+    if (!index->domains.isEmpty()) {
+        const QString host = QUrl::fromEncoded(encodedUrl.toUtf8()).host();
+        auto it = index->domains.constFind(host);
+        if (it != index->domains.constEnd())
+            checkCandidates(it.value());
+    }
+
+    checkCandidates(index->generic);
+
+    if (best == notFound)
+        return false;
+
+    filter = index->rules.at(best).filter();
+    return true;
+}
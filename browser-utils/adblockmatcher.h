@@ -0,0 +1,54 @@
+#ifndef CADBLOCKMATCHER_H
+#define CADBLOCKMATCHER_H
+
+#include <QString>
+#include <QHash>
+#include <QVector>
+#include <QMutex>
+#include <QAtomicInteger>
+#include <QSharedPointer>
+#include <vector>
+#include "adblockrule.h"
+
+class CAdBlockMatcher
+{
+    Q_DISABLE_COPY(CAdBlockMatcher)
+public:
+    CAdBlockMatcher() = default;
+    ~CAdBlockMatcher() = default;
+
+    void invalidate();
+    bool isValid() const;
+    void rebuild(const CAdBlockVector &rules);
+    bool match(const QString &encodedUrl, QString &filter) const;
+
+private:
+    struct Index {
+        CAdBlockVector rules;
+
+        // Aho-Corasick automaton for plain substring rules
+        QHash<quint64,int> transitions;
+        std::vector<int> fail;
+        std::vector<int> output;
+
+        QHash<QString,QVector<int> > tokens;
+        QHash<QString,QVector<int> > domains;
+        QVector<int> generic;
+    };
+
+    QSharedPointer<const Index> m_index;
+    mutable QMutex m_indexMutex;
+    QAtomicInteger<bool> m_valid { false };
+
+    static inline quint64 transitionKey(int state, QChar ch) {
+        return ((static_cast<quint64>(state) << 16) | ch.unicode());
+    }
+    static bool isTokenChar(QChar ch);
+    static bool canMatch(const CAdBlockRule &rule);
+    static QString ruleToken(const CAdBlockRule &rule);
+    static QStringList ruleDomains(const CAdBlockRule &rule);
+    static void buildAutomaton(Index &index, const QVector<QPair<QString,int> > &patterns);
+    static int matchAutomaton(const Index &index, const QString &lowerUrl);
+};
+
+#endif // CADBLOCKMATCHER_H
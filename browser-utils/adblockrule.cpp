@@ -204,6 +204,16 @@ QString CAdBlockRule::regExpPattern() const
     return m_regExp.pattern();
 }
 
+QString CAdBlockRule::plainRule() const
+{
+    return m_plainRule;
+}
+
+QStringList CAdBlockRule::options() const
+{
+    return m_options;
+}
+
 void CAdBlockRule::setPattern(const QString &pattern, bool isRegExp)
 {
     m_regExp = QRegularExpression(isRegExp ? pattern : CGenericFuncs::convertPatternToRegExp(pattern),
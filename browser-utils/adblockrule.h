@@ -49,6 +49,9 @@ public:
     QString regExpPattern() const;
     void setPattern(const QString &pattern, bool isRegExp);
 
+    QString plainRule() const;
+    QStringList options() const;
+
 private:
     QString m_filter;
 
@@ -0,0 +1,180 @@
+#include <QFile>
+#include <QDebug>
+
+extern "C" {
+#include <unistd.h>
+}
+
+#include "domworkerpool.h"
+#include "global/control.h"
+#include "global/structures.h"
+
+namespace CDefaults {
+const int domWorkerEvalMinDelayMS = 100;
+const int domWorkerEvalMaxDelayMS = 1000;
+const int domWorkerMaxRequestsPerPage = 200;
+const qint64 domWorkerPageMemoryBudget = 384L * 1024L * 1024L;
+}
+
+CDOMWorkerPool::CDOMWorkerPool(QWebEngineProfile *profile, int poolSize, QObject *parent)
+    : QObject(parent),
+      m_profile(profile),
+      m_poolSize(qMax(1,poolSize))
+{
+}
+
+CDOMWorkerPool::~CDOMWorkerPool()
+{
+    // Release all waiting callers
+    for (auto *slot : qAsConst(m_slots)) {
+        if (slot->request)
+            slot->request->doneFunc();
+        delete slot->page.data();
+        delete slot;
+    }
+    m_slots.clear();
+
+    while (!m_queue.isEmpty())
+        m_queue.dequeue()->doneFunc();
+}
+
+void CDOMWorkerPool::evaluate(const QUrl &url, const QString &javaScript,
+                              const std::function<bool (const QVariant &)> &matchFunc,
+                              const std::function<void ()> &doneFunc)
+{
+    auto request = QSharedPointer<Request>::create();
+    request->url = url;
+    request->javaScript = javaScript;
+    request->matchFunc = matchFunc;
+    request->doneFunc = doneFunc;
+
+    QMetaObject::invokeMethod(this,[this,request](){
+        request->id = ++m_requestCounter;
+        m_queue.enqueue(request);
+        dispatchPending();
+    },Qt::QueuedConnection);
+}
+
+CDOMWorkerPool::Slot *CDOMWorkerPool::idleSlot()
+{
+    for (auto *slot : qAsConst(m_slots)) {
+        if (slot->request.isNull())
+            return slot;
+    }
+
+    if (m_slots.count() >= m_poolSize)
+        return nullptr;
+
+    auto *slot = new Slot();
+    slot->evalTimer.setSingleShot(true);
+    slot->failTimer.setSingleShot(true);
+    connect(&(slot->evalTimer),&QTimer::timeout,this,[this,slot](){
+        evaluateSlot(slot);
+    });
+    connect(&(slot->failTimer),&QTimer::timeout,this,[this,slot](){
+        if (slot->request) {
+            qWarning() << QSL("Failed to load page '%1' in DOM worker, aborting.")
+                          .arg(slot->request->url.toString());
+        }
+        finishRequest(slot,true);
+    });
+    m_slots.append(slot);
+    return slot;
+}
+
+void CDOMWorkerPool::createPage(Slot *slot)
+{
+    slot->servedRequests = 0;
+    slot->page = new QWebEnginePage(m_profile,this);
+
+    // Evaluation starts as soon as page is loaded, with short retries for scripted content
+    connect(slot->page.data(),&QWebEnginePage::loadFinished,this,[this,slot](bool ok){
+        Q_UNUSED(ok)
+        if (slot->request.isNull()) return;
+        slot->evalDelay = CDefaults::domWorkerEvalMinDelayMS;
+        slot->evalTimer.start(0);
+    });
+}
+
+void CDOMWorkerPool::dispatchPending()
+{
+    while (!m_queue.isEmpty()) {
+        Slot *slot = idleSlot();
+        if (slot == nullptr) return;
+
+        startRequest(slot,m_queue.dequeue());
+    }
+}
+
+void CDOMWorkerPool::startRequest(Slot *slot, const QSharedPointer<Request> &request)
+{
+    if (slot->page.isNull())
+        createPage(slot);
+
+    slot->request = request;
+    slot->evalDelay = CDefaults::domWorkerEvalMaxDelayMS;
+
+    slot->failTimer.start(1000 * gSet->settings()->domWorkerReplyTimeoutSec);
+    // Fallback for navigations without loadFinished (e.g. fragment change only)
+    slot->evalTimer.start(CDefaults::domWorkerEvalMaxDelayMS);
+
+    slot->page->load(request->url);
+}
+
+void CDOMWorkerPool::evaluateSlot(Slot *slot)
+{
+    if (slot->request.isNull() || slot->page.isNull()) return;
+
+    const quint64 requestId = slot->request->id;
+    slot->page->runJavaScript(slot->request->javaScript,[this,slot,requestId](const QVariant &result){
+        if (slot->request.isNull() || slot->request->id != requestId) return;
+
+        if (slot->request->matchFunc(result)) {
+            finishRequest(slot,false);
+            return;
+        }
+
+        slot->evalTimer.start(slot->evalDelay);
+        slot->evalDelay = qMin(slot->evalDelay * 2,CDefaults::domWorkerEvalMaxDelayMS);
+    });
+}
+
+void CDOMWorkerPool::finishRequest(Slot *slot, bool recyclePage)
+{
+    slot->evalTimer.stop();
+    slot->failTimer.stop();
+
+    if (slot->request) {
+        slot->request->doneFunc();
+        slot->request.clear();
+    }
+
+    slot->servedRequests++;
+    if (!recyclePage && !slot->page.isNull()) {
+        recyclePage = (slot->servedRequests >= CDefaults::domWorkerMaxRequestsPerPage ||
+                       rendererMemoryUsage(slot->page.data()) > CDefaults::domWorkerPageMemoryBudget);
+    }
+
+    if (recyclePage && !slot->page.isNull()) {
+        slot->page->triggerAction(QWebEnginePage::Stop);
+        slot->page->deleteLater();
+        slot->page.clear();
+    }
+
+    dispatchPending();
+}
+
+qint64 CDOMWorkerPool::rendererMemoryUsage(QWebEnginePage *page)
+{
+    const qint64 pid = page->renderProcessPid();
+    if (pid <= 0) return 0L;
+
+    QFile f(QSL("/proc/%1/statm").arg(pid));
+    if (!f.open(QIODevice::ReadOnly)) return 0L;
+
+    // Second field is resident set size in pages
+    const QList<QByteArray> fields = f.readAll().split(' ');
+    if (fields.count() < 2) return 0L;
+
+    return fields.at(1).toLongLong() * static_cast<qint64>(sysconf(_SC_PAGESIZE));
+}
@@ -0,0 +1,62 @@
+#ifndef CDOMWORKERPOOL_H
+#define CDOMWORKERPOOL_H
+
+#include <QObject>
+#include <QUrl>
+#include <QTimer>
+#include <QQueue>
+#include <QVector>
+#include <QPointer>
+#include <QSharedPointer>
+#include <QWebEngineProfile>
+#include <QWebEnginePage>
+#include <functional>
+
+class CDOMWorkerPool : public QObject
+{
+    Q_OBJECT
+    Q_DISABLE_COPY(CDOMWorkerPool)
+public:
+    CDOMWorkerPool(QWebEngineProfile *profile, int poolSize, QObject *parent = nullptr);
+    ~CDOMWorkerPool() override;
+
+    // Thread-safe. matchFunc and doneFunc are called from the pool thread.
+    void evaluate(const QUrl &url, const QString &javaScript,
+                  const std::function<bool (const QVariant &)> &matchFunc,
+                  const std::function<void ()> &doneFunc);
+
+private:
+    struct Request {
+        quint64 id { 0UL };
+        QUrl url;
+        QString javaScript;
+        std::function<bool (const QVariant &)> matchFunc;
+        std::function<void ()> doneFunc;
+    };
+
+    struct Slot {
+        QPointer<QWebEnginePage> page;
+        QSharedPointer<Request> request;
+        QTimer evalTimer;
+        QTimer failTimer;
+        int evalDelay { 0 };
+        int servedRequests { 0 };
+    };
+
+    QWebEngineProfile *m_profile;
+    int m_poolSize;
+    quint64 m_requestCounter { 0UL };
+    QQueue<QSharedPointer<Request> > m_queue;
+    QVector<Slot *> m_slots;
+
+    Slot *idleSlot();
+    void createPage(Slot *slot);
+    void dispatchPending();
+    void startRequest(Slot *slot, const QSharedPointer<Request> &request);
+    void evaluateSlot(Slot *slot);
+    void finishRequest(Slot *slot, bool recyclePage);
+    static qint64 rendererMemoryUsage(QWebEnginePage *page);
+
+};
+
+#endif // CDOMWORKERPOOL_H
@@ -4,7 +4,13 @@
 #include <QNetworkReply>
 #include <QPointer>
 #include <QThread>
+#include <QDateTime>
+#include <QMimeDatabase>
+#include <QSet>
+#include <QtEndian>
 #include <QDebug>
+#include <algorithm>
+#include <zlib.h>
 #include "utils/genericfuncs.h"
 #include "downloadwriter.h"
 #include "global/structures.h"
@@ -15,12 +21,25 @@ extern "C" {
 }
 
 namespace CDefaults {
-const int zipThreadMicrosleep = 10000;
-const auto zipTempFilePtr = "zipTempFilePtr";
+const int zipArchiveIdleTimeout = 3000;
+const qint64 zipStreamChunkSize = 256*1024L;
+const qint64 zipMaxEOCDSearch = 0xffff + 22;
+const qint64 zip32Limit = 0xffffffffL;
+const int zip32MaxEntries = 0xffff;
+const quint32 zipLocalHeaderSignature = 0x04034b50;
+const quint32 zipCentralHeaderSignature = 0x02014b50;
+const quint32 zipEOCDSignature = 0x06054b50;
+const quint16 zipVersion = 20;
+const quint16 zipFlagUTF8 = 0x0800;
+const quint16 zipMethodStored = 0;
+const quint16 zipMethodDeflated = 8;
+const int zipLocalHeaderSize = 30;
+const int zipCentralHeaderSize = 46;
+const int zipEOCDSize = 22;
 }
 
 QAtomicInteger<int> CDownloadWriter::m_workCount;
-QAtomicInteger<int> CZipWriter::m_zipWorkerCount;
+QAtomicInteger<int> CZipWriter::m_busyCount;
 QAtomicInteger<bool> CZipWriter::m_abort;
 
 QUuid CDownloadWriter::getAuxId() const
@@ -60,6 +79,11 @@ int CDownloadWriter::getWorkCount()
     return m_workCount.loadAcquire();
 }
 
+CAbstractThreadWorker::WorkerCategory CDownloadWriter::workerCategory() const
+{
+    return wcWriter;
+}
+
 QString CDownloadWriter::workerDescription() const
 {
     QFileInfo fi(m_fileName);
@@ -150,87 +174,438 @@ void CDownloadWriter::finalizeFile(bool success, bool forceDelete)
     Q_EMIT finished();
 }
 
-void CZipWriter::appendFileToZip(const QString &fileName, const QString &zipFile,
-                                 const QSharedPointer<QTemporaryFile> &data)
+/* Append-only ZIP archive kept open for the lifetime of a batch job.
+ * Local headers with data are streamed at the end of the data area, the central directory
+ * is kept in memory and rewritten with EOCD after every added file, so the archive on disk
+ * stays readable between files. Reopened archives are continued from the start of their
+ * central directory, so no existing entry data is rewritten. */
+class CZipArchiveStream
 {
-    if (CZipWriter::m_abort.loadAcquire()) return;
-    if (gSet == nullptr) return;
-    if (gSet->zipWriter() == nullptr) return;
+public:
+    explicit CZipArchiveStream(const QString &zipFile);
+    ~CZipArchiveStream();
+    bool open(QString &error);
+    bool isLegacy() const { return m_legacy; }
+    bool addFile(const CZipWriterFileItem &item, QString &error);
+    bool finalize(QString &error);
+
+private:
+    QFile m_file;
+    QByteArray m_centralDirectory;
+    QSet<QString> m_names;
+    qint64 m_dataEnd { 0L };
+    int m_entriesCount { 0 };
+    bool m_legacy { false };
+
+    Q_DISABLE_COPY(CZipArchiveStream)
+
+    static void appendLE16(QByteArray &buf, quint16 value);
+    static void appendLE32(QByteArray &buf, quint32 value);
+    static bool isCompressedContent(const QString &fileName);
+    bool readCentralDirectory();
+    bool writeCentralDirectory(QString &error);
+    bool copyData(QIODevice *source, bool deflate, quint32 &crc, qint64 &compressedSize);
+};
+
+CZipArchiveStream::CZipArchiveStream(const QString &zipFile)
+    : m_file(zipFile)
+{
+}
 
-    QMutexLocker locker(&m_dataMutex);
+CZipArchiveStream::~CZipArchiveStream()
+{
+    if (m_file.isOpen())
+        m_file.close();
+}
 
-    CZipWriterFileItem item;
-    item.fileName = fileName;
-    item.data = data;
-    m_data[zipFile].files.append(item);
+void CZipArchiveStream::appendLE16(QByteArray &buf, quint16 value)
+{
+    const quint16 le = qToLittleEndian(value);
+    buf.append(reinterpret_cast<const char *>(&le),sizeof(le));
+}
 
-    QMetaObject::invokeMethod(gSet->zipWriter(),&CZipWriter::zipProcessing);
+void CZipArchiveStream::appendLE32(QByteArray &buf, quint32 value)
+{
+    const quint32 le = qToLittleEndian(value);
+    buf.append(reinterpret_cast<const char *>(&le),sizeof(le));
 }
 
-bool CZipWriter::isBusy()
+bool CZipArchiveStream::isCompressedContent(const QString &fileName)
 {
-    return (CZipWriter::m_zipWorkerCount.loadAcquire()>0);
+    static const QStringList compressedMimes( { QSL("image/jpeg"), QSL("image/png"), QSL("image/gif"),
+                                                QSL("image/webp"), QSL("image/avif"), QSL("image/jxl"),
+                                                QSL("application/zip"), QSL("application/gzip"),
+                                                QSL("application/x-7z-compressed"), QSL("application/x-rar"),
+                                                QSL("application/x-xz"), QSL("application/x-bzip2"),
+                                                QSL("application/zstd"), QSL("application/pdf") } );
+
+    QMimeDatabase db;
+    const QMimeType mime = db.mimeTypeForFile(fileName,QMimeDatabase::MatchExtension);
+    if (mime.name().startsWith(QSL("video/")) || mime.name().startsWith(QSL("audio/")))
+        return true;
+
+    return std::any_of(compressedMimes.constBegin(),compressedMimes.constEnd(),[&mime](const QString& name){
+        return mime.inherits(name);
+    });
 }
 
-void CZipWriter::abortAllWorkers()
+bool CZipArchiveStream::readCentralDirectory()
 {
-    CZipWriter::m_abort.storeRelease(true);
+    const qint64 fileSize = m_file.size();
+    const qint64 tailSize = qMin(fileSize,CDefaults::zipMaxEOCDSearch);
+    if (tailSize < CDefaults::zipEOCDSize) return false;
+    if (!m_file.seek(fileSize - tailSize)) return false;
+    const QByteArray tail = m_file.read(tailSize);
+    if (tail.size() != tailSize) return false;
+
+    const auto le16 = [](const QByteArray &buf, qint64 pos) {
+        return qFromLittleEndian<quint16>(buf.constData() + pos);
+    };
+    const auto le32 = [](const QByteArray &buf, qint64 pos) {
+        return qFromLittleEndian<quint32>(buf.constData() + pos);
+    };
+
+    qint64 eocd = -1;
+    for (qint64 pos = tailSize - CDefaults::zipEOCDSize; pos >= 0; pos--) {
+        if (le32(tail,pos) == CDefaults::zipEOCDSignature) {
+            eocd = pos;
+            break;
+        }
+    }
+    if (eocd < 0) return false;
+
+    const quint16 diskNumber = le16(tail,eocd + 4);
+    const quint16 cdDisk = le16(tail,eocd + 6);
+    const quint16 diskEntries = le16(tail,eocd + 8);
+    const quint16 totalEntries = le16(tail,eocd + 10);
+    const quint32 cdSize = le32(tail,eocd + 12);
+    const quint32 cdOffset = le32(tail,eocd + 16);
+    const qint64 eocdOffset = fileSize - tailSize + eocd;
+
+    // Multi-disk and ZIP64 archives are left to libzip
+    if (diskNumber != 0 || cdDisk != 0 || diskEntries != totalEntries ||
+            totalEntries == CDefaults::zip32MaxEntries ||
+            cdSize == CDefaults::zip32Limit || cdOffset == CDefaults::zip32Limit)
+        return false;
+    if (static_cast<qint64>(cdOffset) + cdSize > eocdOffset) return false;
+
+    if (!m_file.seek(cdOffset)) return false;
+    const QByteArray cd = m_file.read(cdSize);
+    if (cd.size() != static_cast<int>(cdSize)) return false;
+
+    QSet<QString> names;
+    qint64 pos = 0;
+    for (int i = 0; i < totalEntries; i++) {
+        if (pos + CDefaults::zipCentralHeaderSize > cd.size()) return false;
+        if (le32(cd,pos) != CDefaults::zipCentralHeaderSignature) return false;
+        const quint16 flags = le16(cd,pos + 8);
+        const quint16 nameLength = le16(cd,pos + 28);
+        const quint16 extraLength = le16(cd,pos + 30);
+        const quint16 commentLength = le16(cd,pos + 32);
+        const qint64 recordSize = CDefaults::zipCentralHeaderSize + nameLength + extraLength + commentLength;
+        if (pos + recordSize > cd.size()) return false;
+
+        const QByteArray name = cd.mid(pos + CDefaults::zipCentralHeaderSize,nameLength);
+        if ((flags & CDefaults::zipFlagUTF8) > 0) {
+            names.insert(QString::fromUtf8(name));
+        } else {
+            names.insert(QString::fromLatin1(name));
+        }
+        pos += recordSize;
+    }
+
+    m_centralDirectory = cd.left(pos);
+    m_entriesCount = totalEntries;
+    m_names = names;
+    m_dataEnd = cdOffset;
+    return true;
 }
 
-void CZipWriter::terminateAllWorkers()
+bool CZipArchiveStream::open(QString &error)
 {
-    Q_EMIT terminateWorkers();
+    if (!m_file.open(QIODevice::ReadWrite)) {
+        error = QSL("Unable to open zip file: %1 %2").arg(m_file.fileName(),m_file.errorString());
+        return false;
+    }
+
+    if (m_file.size() > 0 && !readCentralDirectory()) {
+        m_legacy = true;
+        m_file.close();
+    }
+
+    return true;
 }
 
-CZipWriter::CZipWriter(QObject *parent)
-    : QObject(parent)
+bool CZipArchiveStream::copyData(QIODevice *source, bool deflate, quint32 &crc, qint64 &compressedSize)
+{
+    crc = crc32(0L,Z_NULL,0);
+    compressedSize = 0L;
+    if (!source->seek(0)) return false;
+
+    z_stream zs {};
+    if (deflate && deflateInit2(&zs,Z_DEFAULT_COMPRESSION,Z_DEFLATED,-MAX_WBITS,
+                                MAX_MEM_LEVEL,Z_DEFAULT_STRATEGY) != Z_OK)
+        return false;
+
+    QByteArray out(static_cast<int>(CDefaults::zipStreamChunkSize),'\0');
+    bool res = true;
+    for (;;) {
+        if (CZipWriter::m_abort.loadAcquire()) {
+            res = false;
+            break;
+        }
+
+        const QByteArray chunk = source->read(CDefaults::zipStreamChunkSize);
+        const bool atEnd = chunk.isEmpty();
+        if (!atEnd) {
+            crc = crc32(crc,reinterpret_cast<const Bytef *>(chunk.constData()),
+                        static_cast<uInt>(chunk.size()));
+        }
+
+        if (!deflate) {
+            if (atEnd) break;
+            if (m_file.write(chunk) != chunk.size()) {
+                res = false;
+                break;
+            }
+            compressedSize += chunk.size();
+            continue;
+        }
+
+        zs.next_in = reinterpret_cast<Bytef *>(const_cast<char *>(chunk.constData()));
+        zs.avail_in = static_cast<uInt>(chunk.size());
+        int ret = Z_OK;
+        do {
+            zs.next_out = reinterpret_cast<Bytef *>(out.data());
+            zs.avail_out = static_cast<uInt>(out.size());
+            ret = ::deflate(&zs,atEnd ? Z_FINISH : Z_NO_FLUSH);
+            const qint64 produced = out.size() - zs.avail_out;
+            if (m_file.write(out.constData(),produced) != produced) {
+                res = false;
+                break;
+            }
+            compressedSize += produced;
+        } while (res && zs.avail_out == 0);
+
+        if (!res || atEnd || ret == Z_STREAM_END) break;
+    }
+
+    if (deflate)
+        deflateEnd(&zs);
+
+    return res;
+}
+
+bool CZipArchiveStream::addFile(const CZipWriterFileItem &item, QString &error)
+{
+    Q_ASSERT(!item.fileName.isEmpty());
+    Q_ASSERT(item.data->isOpen());
+
+    if (m_names.contains(item.fileName)) {
+        error = QSL("Error adding file to zip: %1 %2 File already exists")
+                .arg(m_file.fileName(),item.fileName);
+        return false;
+    }
+
+    const qint64 size = item.data->size();
+    if (m_dataEnd + size + CDefaults::zipStreamChunkSize >= CDefaults::zip32Limit ||
+            m_entriesCount + 1 >= CDefaults::zip32MaxEntries) {
+        error = QSL("Error adding file to zip: %1 %2 Archive size limit reached")
+                .arg(m_file.fileName(),item.fileName);
+        return false;
+    }
+
+    const QByteArray name = item.fileName.toUtf8();
+    const QDateTime now = QDateTime::currentDateTime();
+    const quint16 dosTime = static_cast<quint16>((now.time().hour() << 11) | (now.time().minute() << 5) |
+                                                 (now.time().second() / 2));
+    const quint16 dosDate = static_cast<quint16>(((qMax(now.date().year(),1980) - 1980) << 9) |
+                                                 (now.date().month() << 5) | now.date().day());
+
+    const qint64 headerOffset = m_dataEnd;
+    const qint64 dataOffset = headerOffset + CDefaults::zipLocalHeaderSize + name.size();
+    quint16 method = CDefaults::zipMethodDeflated;
+    if (isCompressedContent(item.fileName))
+        method = CDefaults::zipMethodStored;
+
+    quint32 crc = 0;
+    qint64 compressedSize = 0L;
+    bool res = m_file.seek(dataOffset) &&
+               copyData(item.data.data(),(method == CDefaults::zipMethodDeflated),crc,compressedSize);
+    if (res && method == CDefaults::zipMethodDeflated && compressedSize >= size) {
+        // Incompressible data, rewrite as stored
+        method = CDefaults::zipMethodStored;
+        res = m_file.seek(dataOffset) && copyData(item.data.data(),false,crc,compressedSize);
+    }
+
+    QByteArray header;
+    appendLE32(header,CDefaults::zipLocalHeaderSignature);
+    appendLE16(header,CDefaults::zipVersion);
+    appendLE16(header,CDefaults::zipFlagUTF8);
+    appendLE16(header,method);
+    appendLE16(header,dosTime);
+    appendLE16(header,dosDate);
+    appendLE32(header,crc);
+    appendLE32(header,static_cast<quint32>(compressedSize));
+    appendLE32(header,static_cast<quint32>(size));
+    appendLE16(header,static_cast<quint16>(name.size()));
+    appendLE16(header,0);
+    header.append(name);
+
+    res = res && m_file.seek(headerOffset) && (m_file.write(header) == header.size());
+    if (!res) {
+        if (!CZipWriter::m_abort.loadAcquire()) {
+            error = QSL("Error adding file to zip: %1 %2 %3")
+                    .arg(m_file.fileName(),item.fileName,m_file.errorString());
+        }
+        // Partial entry may overwrite old central directory, restore it without this file
+        QString cdError;
+        writeCentralDirectory(cdError);
+        return false;
+    }
+
+    QByteArray central;
+    appendLE32(central,CDefaults::zipCentralHeaderSignature);
+    appendLE16(central,CDefaults::zipVersion);
+    appendLE16(central,CDefaults::zipVersion);
+    appendLE16(central,CDefaults::zipFlagUTF8);
+    appendLE16(central,method);
+    appendLE16(central,dosTime);
+    appendLE16(central,dosDate);
+    appendLE32(central,crc);
+    appendLE32(central,static_cast<quint32>(compressedSize));
+    appendLE32(central,static_cast<quint32>(size));
+    appendLE16(central,static_cast<quint16>(name.size()));
+    appendLE16(central,0); // extra field
+    appendLE16(central,0); // comment
+    appendLE16(central,0); // disk number
+    appendLE16(central,0); // internal attributes
+    appendLE32(central,0); // external attributes
+    appendLE32(central,static_cast<quint32>(headerOffset));
+    central.append(name);
+
+    m_centralDirectory.append(central);
+    m_names.insert(item.fileName);
+    m_entriesCount++;
+    m_dataEnd = dataOffset + compressedSize;
+    return writeCentralDirectory(error);
+}
+
+bool CZipArchiveStream::finalize(QString &error)
+{
+    if (!m_file.isOpen()) return true;
+
+    const bool res = writeCentralDirectory(error);
+    m_file.close();
+    return res;
+}
+
+bool CZipArchiveStream::writeCentralDirectory(QString &error)
 {
+    if (!m_file.isOpen()) return false;
+
+    QByteArray eocd;
+    appendLE32(eocd,CDefaults::zipEOCDSignature);
+    appendLE16(eocd,0);
+    appendLE16(eocd,0);
+    appendLE16(eocd,static_cast<quint16>(m_entriesCount));
+    appendLE16(eocd,static_cast<quint16>(m_entriesCount));
+    appendLE32(eocd,static_cast<quint32>(m_centralDirectory.size()));
+    appendLE32(eocd,static_cast<quint32>(m_dataEnd));
+    appendLE16(eocd,0);
+
+    const bool res = m_file.seek(m_dataEnd) &&
+                     (m_file.write(m_centralDirectory) == m_centralDirectory.size()) &&
+                     (m_file.write(eocd) == eocd.size()) &&
+                     m_file.resize(m_dataEnd + m_centralDirectory.size() + eocd.size()) &&
+                     m_file.flush();
+    if (!res) {
+        error = QSL("Unable to write zip central directory: %1 %2")
+                .arg(m_file.fileName(),m_file.errorString());
+    }
+    return res;
 }
 
-CZipWriter::~CZipWriter() = default;
+CZipWriterWorker::CZipWriterWorker(QObject *parent)
+    : QObject(parent)
+{
+}
 
-void CZipWriter::zipProcessing()
+CZipWriterWorker::~CZipWriterWorker()
 {
-    QMutexLocker locker(&m_dataMutex);
+    finalizeAll();
+}
 
-    for (auto it = m_data.keyValueBegin(), end = m_data.keyValueEnd(); it != end; ++it) {
-        if (!(*it).second.files.isEmpty() && (*it).second.thread.isNull()) {
+void CZipWriterWorker::addFile(const QString &zipFile, const CZipWriterFileItem &item)
+{
+    if (CZipWriter::m_abort.loadAcquire()) {
+        item.data->close();
+        CZipWriter::m_busyCount--;
+        return;
+    }
 
-            const QString zipFile = (*it).first;
-            QThread* th = QThread::create([this,zipFile](){
-                m_zipWorkerCount++;
+    QString error;
+    QSharedPointer<CZipArchiveStream> archive = m_archives.value(zipFile);
+    if (archive.isNull()) {
+        archive.reset(new CZipArchiveStream(zipFile));
+        if (archive->open(error)) {
+            m_archives.insert(zipFile,archive);
+        } else {
+            archive.clear();
+        }
+    }
 
-                for (;;) {
-                    QThread::usleep(CDefaults::zipThreadMicrosleep);
-                    if (m_abort.loadAcquire()) break;
+    if (archive && archive->isLegacy()) {
+        appendWithLibzip(zipFile,item);
+    } else if (archive && !archive->addFile(item,error) && error.isEmpty()) {
+        error = QSL("Error adding file to zip: %1 %2").arg(zipFile,item.fileName);
+    }
+    item.data->close();
 
-                    m_dataMutex.lock();
-                    if (!m_data.contains(zipFile) || m_data.value(zipFile).files.isEmpty()) {
-                        m_dataMutex.unlock();
-                        break;
-                    }
-                    const QVector<CZipWriterFileItem> items = m_data.value(zipFile).files;
-                    m_data[zipFile].files.clear();
-                    m_dataMutex.unlock();
-                    writeZipData(zipFile,items);
-                }
+    if (!error.isEmpty() && !CZipWriter::m_abort.loadAcquire())
+        Q_EMIT zipError(error);
 
-                m_zipWorkerCount--;
+    if (archive) {
+        // Archive is consistent after each file, idle timer only releases the file handle
+        QTimer* timer = m_idleTimers.value(zipFile);
+        if (timer == nullptr) {
+            timer = new QTimer(this);
+            timer->setSingleShot(true);
+            timer->setInterval(CDefaults::zipArchiveIdleTimeout);
+            connect(timer,&QTimer::timeout,this,[this,zipFile](){
+                finalizeArchive(zipFile);
             });
-            connect(th,&QThread::finished,th,&QThread::deleteLater);
-            connect(this,&CZipWriter::terminateWorkers,th,&QThread::terminate);
-
-            th->setObjectName(QSL("ZIP_packer"));
-            th->start();
-            (*it).second.thread = th;
+            m_idleTimers.insert(zipFile,timer);
         }
+        timer->start();
     }
+
+    CZipWriter::m_busyCount--;
+}
+
+void CZipWriterWorker::finalizeArchive(const QString &zipFile)
+{
+    if (QTimer* timer = m_idleTimers.take(zipFile))
+        timer->deleteLater();
+
+    const QSharedPointer<CZipArchiveStream> archive = m_archives.take(zipFile);
+    if (archive.isNull()) return;
+
+    QString error;
+    if (!archive->finalize(error))
+        Q_EMIT zipError(error);
 }
 
-void CZipWriter::writeZipData(const QString& zipFile, const QVector<CZipWriterFileItem> &items)
+void CZipWriterWorker::finalizeAll()
 {
-    if (m_abort.loadAcquire()) return;
+    const QStringList zipFiles = m_archives.keys();
+    for (const auto &zipFile : zipFiles)
+        finalizeArchive(zipFile);
+}
 
+void CZipWriterWorker::appendWithLibzip(const QString &zipFile, const CZipWriterFileItem &item)
+{
+    // Fallback for ZIP64 or unrecognized existing archives
     int errorp = 0;
     zip_t* zip = zip_open(zipFile.toUtf8().constData(),ZIP_CREATE,&errorp);
     if (zip == nullptr) {
@@ -243,39 +618,97 @@ void CZipWriter::writeZipData(const QString& zipFile, const QVector<CZipWriterFi
     }
 
     QString error;
-    for (const auto& file : items) {
-        if (m_abort.loadAcquire()) break;
-        Q_ASSERT(!file.fileName.isEmpty());
-        Q_ASSERT(file.data->isOpen());
-
-        qint64 size = file.data->size();
-        uchar* ptr = file.data->map(0,size);
-        Q_ASSERT(ptr != nullptr);
-        file.data->setProperty(CDefaults::zipTempFilePtr,reinterpret_cast<qulonglong>(ptr));
-
-        zip_source_t* src = nullptr;
-        if ((src = zip_source_buffer(zip, ptr, static_cast<uint64_t>(size), 0)) == nullptr ||
-                zip_file_add(zip, file.fileName.toUtf8().constData(), src, ZIP_FL_ENC_UTF_8) < 0) {
-            zip_source_free(src);
-            error = QSL("Error adding file to zip: %1 %2 %3")
-                    .arg(zipFile,file.fileName,QString::fromUtf8(zip_strerror(zip)));
-            break;
-        }
+    const qint64 size = item.data->size();
+    uchar* ptr = item.data->map(0,size);
+    zip_source_t* src = nullptr;
+    if (ptr == nullptr ||
+            (src = zip_source_buffer(zip, ptr, static_cast<uint64_t>(size), 0)) == nullptr ||
+            zip_file_add(zip, item.fileName.toUtf8().constData(), src, ZIP_FL_ENC_UTF_8) < 0) {
+        zip_source_free(src);
+        error = QSL("Error adding file to zip: %1 %2 %3")
+                .arg(zipFile,item.fileName,QString::fromUtf8(zip_strerror(zip)));
     }
 
-    if (m_abort.loadAcquire()) {
+    if (CZipWriter::m_abort.loadAcquire()) {
         zip_discard(zip);
     } else {
         zip_close(zip);
     }
 
-    for (const auto& file : items) {
-        uchar* ptr = reinterpret_cast<uchar *>(file.data->property(CDefaults::zipTempFilePtr).toULongLong());
-        file.data->unmap(ptr);
-        file.data->close();
-    }
+    if (ptr != nullptr)
+        item.data->unmap(ptr);
 
-    if (!error.isEmpty()) {
+    if (!error.isEmpty())
         Q_EMIT zipError(error);
+}
+
+CZipWriter::CZipWriter(QObject *parent)
+    : QObject(parent)
+{
+    m_thread = new QThread();
+    m_worker = new CZipWriterWorker();
+    m_worker->moveToThread(m_thread);
+
+    connect(m_worker,&CZipWriterWorker::zipError,this,&CZipWriter::zipError);
+    connect(m_thread,&QThread::finished,m_worker,&QObject::deleteLater);
+    connect(m_thread,&QThread::finished,m_thread,&QThread::deleteLater);
+    connect(this,&CZipWriter::terminateWorkers,m_thread,&QThread::terminate);
+
+    m_thread->setObjectName(QSL("ZIP_packer"));
+    m_thread->start();
+}
+
+CZipWriter::~CZipWriter()
+{
+    stopWorker();
+    if (m_thread) {
+        m_thread->quit();
+        m_thread->wait();
     }
 }
+
+void CZipWriter::appendFileToZip(const QString &fileName, const QString &zipFile,
+                                 const QSharedPointer<QTemporaryFile> &data)
+{
+    if (CZipWriter::m_abort.loadAcquire()) return;
+
+    CZipWriterFileItem item;
+    item.fileName = fileName;
+    item.data = data;
+
+    // Worker is deleted only after its thread finishes, queued call is dropped with it
+    const QMutexLocker locker(&m_workerMutex);
+    if (m_workerStopped.loadAcquire() || m_worker == nullptr) return;
+    m_busyCount++;
+    CZipWriterWorker* worker = m_worker;
+    QMetaObject::invokeMethod(worker,[worker,zipFile,item](){
+        worker->addFile(zipFile,item);
+    },Qt::QueuedConnection);
+}
+
+bool CZipWriter::isBusy()
+{
+    return (CZipWriter::m_busyCount.loadAcquire()>0);
+}
+
+void CZipWriter::abortAllWorkers()
+{
+    CZipWriter::m_abort.storeRelease(true);
+
+    // Pending files are dropped, open archives are closed
+    const QMutexLocker locker(&m_workerMutex);
+    if (!m_workerStopped.loadAcquire() && m_worker != nullptr)
+        QMetaObject::invokeMethod(m_worker,&CZipWriterWorker::finalizeAll,Qt::QueuedConnection);
+}
+
+void CZipWriter::terminateAllWorkers()
+{
+    stopWorker();
+    Q_EMIT terminateWorkers();
+}
+
+void CZipWriter::stopWorker()
+{
+    const QMutexLocker locker(&m_workerMutex);
+    m_workerStopped.storeRelease(true);
+}
@@ -12,6 +12,7 @@
 #include <QPointer>
 #include <QTemporaryFile>
 #include <QTimer>
+#include <QThread>
 #include "abstractthreadworker.h"
 
 namespace CDefaults {
@@ -41,6 +42,7 @@ public:
     ~CDownloadWriter() override;
     static int getWorkCount();
     QString workerDescription() const override;
+    WorkerCategory workerCategory() const override;
     QUuid getAuxId() const;
 
 protected:
@@ -62,25 +64,51 @@ struct CZipWriterFileItem
     QSharedPointer<QTemporaryFile> data;
 };
 
-struct CZipWriterWorkerItem
+class CZipArchiveStream;
+
+class CZipWriterWorker : public QObject
 {
-    QPointer<QThread> thread;
-    QVector<CZipWriterFileItem> files;
+    Q_OBJECT
+    Q_DISABLE_COPY(CZipWriterWorker)
+private:
+    QHash<QString, QSharedPointer<CZipArchiveStream> > m_archives;
+    QHash<QString, QTimer*> m_idleTimers;
+
+    void appendWithLibzip(const QString &zipFile, const CZipWriterFileItem &item);
+
+public:
+    explicit CZipWriterWorker(QObject *parent = nullptr);
+    ~CZipWriterWorker() override;
+
+public Q_SLOTS:
+    void addFile(const QString &zipFile, const CZipWriterFileItem &item);
+    void finalizeArchive(const QString &zipFile);
+    void finalizeAll();
+
+Q_SIGNALS:
+    void zipError(const QString& message);
+
 };
 
 class CZipWriter : public QObject
 {
     Q_OBJECT
 private:
-    QMutex m_dataMutex;
-    QHash<QString, CZipWriterWorkerItem> m_data;
-    static QAtomicInteger<int> m_zipWorkerCount;
+    QPointer<QThread> m_thread;
+    // Worker receives queued calls from GUI and download writer threads until it is stopped,
+    // mutex keeps the stop from racing with a call that is being posted
+    CZipWriterWorker* m_worker { nullptr };
+    QAtomicInteger<bool> m_workerStopped { false };
+    QMutex m_workerMutex;
+    static QAtomicInteger<int> m_busyCount;
     static QAtomicInteger<bool> m_abort;
 
     Q_DISABLE_COPY(CZipWriter)
 
-    void zipProcessing();
-    void writeZipData(const QString &zipFile, const QVector<CZipWriterFileItem>& items);
+    friend class CZipWriterWorker;
+    friend class CZipArchiveStream;
+
+    void stopWorker();
 
 public:
     explicit CZipWriter(QObject *parent = nullptr);
@@ -173,6 +173,8 @@ void CUserScript::setSource(const QString &src)
     if (m_title.isEmpty())
         m_title = m_name;
 
+    compileRules();
+
     if (!hasHeader)
         qWarning() << "Failed to locate header of user script file";
 }
@@ -207,43 +209,70 @@ CUserScript::InjectionTime CUserScript::getInjectionTime() const
     return m_injectionTime;
 }
 
+const QVector<QRegularExpression> &CUserScript::getIncludeRegExps() const
+{
+    return m_includeRegExps;
+}
+
+QString CUserScript::encodeUrlForMatching(const QUrl &url)
+{
+    return url.toString(QUrl::RemoveUserInfo | QUrl::RemovePort |
+                        QUrl::RemoveFragment | QUrl::StripTrailingSlash);
+}
+
+bool CUserScript::isSupportedScheme(const QString &scheme)
+{
+    return (scheme == QSL("http") ||
+            scheme == QSL("https") ||
+            scheme == QSL("file") ||
+            scheme == QSL("ftp") ||
+            scheme == CMagicFileSchemeHandler::getScheme().toLower());
+}
+
 bool CUserScript::isEnabledForUrl(const QUrl &url) const
 {
-    if (url.scheme() != QSL("http") &&
-            url.scheme() != QSL("https") &&
-            url.scheme() != QSL("file") &&
-            url.scheme() != QSL("ftp") &&
-            url.scheme() != CMagicFileSchemeHandler::getScheme().toLower())
-    {
+    if (!isSupportedScheme(url.scheme()))
         return false;
-    }
-
-    bool isEnabled(!(m_includeRules.length() > 0 || m_matchRules.length() > 0));
 
-    if (checkUrl(url, m_matchRules))
-        isEnabled = true;
+    const QString uenc = encodeUrlForMatching(url);
 
-    if (!isEnabled && checkUrl(url, m_includeRules))
-        isEnabled = true;
+    bool isEnabled = (m_includeRegExps.isEmpty() || checkUrl(uenc, m_includeRegExps));
 
-    if (checkUrl(url, m_excludeRules))
+    if (isEnabled && isExcludedForEncodedUrl(uenc))
         isEnabled = false;
 
     return isEnabled;
 }
 
-bool CUserScript::checkUrl(const QUrl &url, const QStringList &rules) const
+bool CUserScript::isExcludedForEncodedUrl(const QString &encodedUrl) const
 {
-    const QString uenc = url.toString(QUrl::RemoveUserInfo | QUrl::RemovePort |
-                                      QUrl::RemoveFragment | QUrl::StripTrailingSlash);
+    return checkUrl(encodedUrl, m_excludeRegExps);
+}
 
-    return std::any_of(rules.constBegin(),rules.constEnd(),[uenc](const QString& rule){
-        QRegularExpression regexp(CGenericFuncs::convertPatternToRegExp(rule),
-                                    QRegularExpression::CaseInsensitiveOption);
-        return uenc.contains(regexp);
+bool CUserScript::checkUrl(const QString &encodedUrl, const QVector<QRegularExpression> &rules)
+{
+    return std::any_of(rules.constBegin(),rules.constEnd(),[encodedUrl](const QRegularExpression& regexp){
+        return encodedUrl.contains(regexp);
     });
 }
 
+void CUserScript::compileRules()
+{
+    const auto compile = [](const QStringList& rules, QVector<QRegularExpression>& res){
+        res.clear();
+        res.reserve(rules.count());
+        for (const auto& rule : rules) {
+            QRegularExpression regexp(CGenericFuncs::convertPatternToRegExp(rule),
+                                      QRegularExpression::CaseInsensitiveOption);
+            regexp.optimize();
+            res.append(regexp);
+        }
+    };
+
+    compile(m_matchRules + m_includeRules, m_includeRegExps);
+    compile(m_excludeRules, m_excludeRegExps);
+}
+
 bool CUserScript::shouldRunOnSubFrames() const
 {
     return m_shouldRunOnSubFrames;
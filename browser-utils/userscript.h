@@ -24,6 +24,8 @@
 #include <QObject>
 #include <QString>
 #include <QUrl>
+#include <QVector>
+#include <QRegularExpression>
 
 class CUserScript
 {
@@ -54,12 +56,17 @@ public:
     QStringList getMatchRules() const;
     InjectionTime getInjectionTime() const;
     bool isEnabledForUrl(const QUrl &url) const;
+    bool isExcludedForEncodedUrl(const QString &encodedUrl) const;
+    const QVector<QRegularExpression> &getIncludeRegExps() const;
+    static QString encodeUrlForMatching(const QUrl &url);
+    static bool isSupportedScheme(const QString &scheme);
     bool shouldRunOnSubFrames() const;
     bool shouldRunFromContextMenu() const;
     bool shouldRunByTranslator() const;
 
 protected:
-    bool checkUrl(const QUrl &url, const QStringList &rules) const;
+    static bool checkUrl(const QString &encodedUrl, const QVector<QRegularExpression> &rules);
+    void compileRules();
 
 private:
     QString m_name;
@@ -72,6 +79,8 @@ private:
     QStringList m_excludeRules;
     QStringList m_includeRules;
     QStringList m_matchRules;
+    QVector<QRegularExpression> m_includeRegExps; // match rules first, then include rules
+    QVector<QRegularExpression> m_excludeRegExps;
     InjectionTime m_injectionTime { DocumentReadyTime };
     bool m_shouldRunOnSubFrames { true };
     bool m_runFromContextMenu { false };
@@ -0,0 +1,128 @@
+#include <atomic>
+#include <algorithm>
+#include "userscriptmatcher.h"
+#include "global/structures.h"
+
+QString CUserScriptMatcher::ruleHost(const QString &rule, bool *isSuffix)
+{
+    *isSuffix = false;
+
+    const int schemeEnd = rule.indexOf(QSL("://"));
+    if (schemeEnd < 0) return QString();
+
+    QString host = rule.mid(schemeEnd + 3);
+    const int pathStart = host.indexOf(u'/');
+    if (pathStart >= 0)
+        host.truncate(pathStart);
+
+    if (host.startsWith(QSL("*."))) {
+        *isSuffix = true;
+        host.remove(0,2);
+    }
+
+    // Wildcards and ports inside host part are matched with generic rules
+    if (host.isEmpty() || host.contains(u'*') || host.contains(u':') || host.contains(u'@'))
+        return QString();
+
+    return host.toLower();
+}
+
+bool CUserScriptMatcher::isApplicable(const CUserScript &script, bool isMainFrame, bool isContextMenu,
+                                      bool isTranslator)
+{
+    return ((isMainFrame || script.shouldRunOnSubFrames()) &&
+            (isContextMenu == script.shouldRunFromContextMenu()) &&
+            (isTranslator == script.shouldRunByTranslator()));
+}
+
+void CUserScriptMatcher::rebuild(const QHash<QString, CUserScript> &scripts)
+{
+    auto index = std::make_shared<Index>();
+    index->scripts.reserve(scripts.count());
+
+    for (auto it = scripts.constBegin(), end = scripts.constEnd(); it != end; ++it) {
+        const int scriptIdx = index->scripts.count();
+        index->scripts.append(it.value());
+
+        const QStringList rules = it.value().getMatchRules() + it.value().getIncludeRules();
+        if (rules.isEmpty()) {
+            index->unconditional.append(scriptIdx);
+            continue;
+        }
+
+        for (int i = 0; i < rules.count(); i++) {
+            RuleRef ref;
+            ref.script = scriptIdx;
+            ref.rule = i;
+
+            bool isSuffix = false;
+            const QString host = ruleHost(rules.at(i),&isSuffix);
+            if (host.isEmpty()) {
+                index->generic.append(ref);
+            } else if (isSuffix) {
+                index->domainSuffixes[host].append(ref);
+            } else {
+                index->hosts[host].append(ref);
+            }
+        }
+    }
+
+    std::atomic_store(&m_index,std::shared_ptr<const Index>(index));
+}
+
+QVector<CUserScript> CUserScriptMatcher::match(const QUrl &url, bool isMainFrame, bool isContextMenu,
+                                               bool isTranslator) const
+{
+    QVector<CUserScript> res;
+
+    const std::shared_ptr<const Index> index = std::atomic_load(&m_index);
+    if (!index) return res;
+    if (!CUserScript::isSupportedScheme(url.scheme())) return res;
+
+    const QString uenc = CUserScript::encodeUrlForMatching(url);
+    QVector<bool> matched(index->scripts.count(),false);
+
+    const auto checkRules = [&index,&matched,&uenc,isMainFrame,isContextMenu,isTranslator]
+                            (const QVector<RuleRef>& refs){
+        for (const auto& ref : refs) {
+            if (matched.at(ref.script)) continue;
+
+            const CUserScript &script = index->scripts.at(ref.script);
+            if (!isApplicable(script,isMainFrame,isContextMenu,isTranslator)) continue;
+
+            if (uenc.contains(script.getIncludeRegExps().at(ref.rule)))
+                matched[ref.script] = true;
+        }
+    };
+
+    for (const int scriptIdx : qAsConst(index->unconditional)) {
+        if (isApplicable(index->scripts.at(scriptIdx),isMainFrame,isContextMenu,isTranslator))
+            matched[scriptIdx] = true;
+    }
+
+    const QString host = url.host().toLower();
+    if (!host.isEmpty()) {
+        auto it = index->hosts.constFind(host);
+        if (it != index->hosts.constEnd())
+            checkRules(it.value());
+
+        if (!index->domainSuffixes.isEmpty()) {
+            int dot = host.indexOf(u'.');
+            while (dot >= 0) {
+                auto sit = index->domainSuffixes.constFind(host.mid(dot + 1));
+                if (sit != index->domainSuffixes.constEnd())
+                    checkRules(sit.value());
+                dot = host.indexOf(u'.',dot + 1);
+            }
+        }
+    }
+
+    checkRules(index->generic);
+
+    for (int i = 0; i < matched.count(); i++) {
+        if (matched.at(i) && !index->scripts.at(i).isExcludedForEncodedUrl(uenc))
+            res.append(index->scripts.at(i));
+    }
+
+    return res;
+}
@@ -0,0 +1,44 @@
+#ifndef CUSERSCRIPTMATCHER_H
+#define CUSERSCRIPTMATCHER_H
+
+#include <QString>
+#include <QHash>
+#include <QVector>
+#include <QUrl>
+#include <memory>
+#include "userscript.h"
+
+class CUserScriptMatcher
+{
+    Q_DISABLE_COPY(CUserScriptMatcher)
+public:
+    CUserScriptMatcher() = default;
+    ~CUserScriptMatcher() = default;
+
+    void rebuild(const QHash<QString,CUserScript> &scripts);
+    QVector<CUserScript> match(const QUrl &url, bool isMainFrame, bool isContextMenu,
+                               bool isTranslator) const;
+
+private:
+    struct RuleRef {
+        int script { 0 };
+        int rule { 0 };
+    };
+
+    struct Index {
+        QVector<CUserScript> scripts;
+        QVector<int> unconditional; // scripts without include and match rules
+
+        QHash<QString,QVector<RuleRef> > hosts;
+        QHash<QString,QVector<RuleRef> > domainSuffixes; // '*.domain' rules
+        QVector<RuleRef> generic;
+    };
+
+    std::shared_ptr<const Index> m_index;
+
+    static QString ruleHost(const QString &rule, bool *isSuffix);
+    static bool isApplicable(const CUserScript &script, bool isMainFrame, bool isContextMenu,
+                             bool isTranslator);
+};
+
+#endif // CUSERSCRIPTMATCHER_H
@@ -4,7 +4,6 @@
 #include <QWebEngineScriptCollection>
 #include <QDirIterator>
 #include <QDialog>
-#include <QThread>
 #include <QMimeData>
 #include <QAuthenticator>
 
@@ -218,18 +217,15 @@ void CBrowserNet::load(const QUrl &url, bool autoTranslate, bool alternateAutoTr
             snv->m_onceTranslated = false;
             snv->m_translationBkgdFinished=false;
             snv->m_loadingBkgdFinished=false;
-            auto *pdf = new CPDFWorker();
-            auto *pdft = new QThread();
-            pdf->moveToThread(pdft);
-            connect(this,&CBrowserNet::startPdfConversion,pdf,&CPDFWorker::pdfToText,Qt::QueuedConnection);
-            connect(pdf,&CPDFWorker::gotText,this,&CBrowserNet::pdfConverted,Qt::QueuedConnection);
-            connect(pdf,&CPDFWorker::error,this,&CBrowserNet::pdfError,Qt::QueuedConnection);
-            connect(pdf,&CPDFWorker::finished,pdft,&QThread::quit);
-            connect(pdft,&QThread::finished,pdf,&CPDFWorker::deleteLater);
-            connect(pdft,&QThread::finished,pdft,&QThread::deleteLater);
-            pdft->setObjectName(QSL("PDF_parser"));
-            pdft->start();
-            Q_EMIT startPdfConversion(url.toString());
+            auto *pdf = new CPDFWorker(url.toString());
+            pdf->setWorkerPriority(CAbstractThreadWorker::wpHigh);
+            if (!gSet->startup()->setupThreadedWorker(pdf)) {
+                delete pdf;
+            } else {
+                connect(pdf,&CPDFWorker::gotText,this,&CBrowserNet::pdfConverted,Qt::QueuedConnection);
+                connect(pdf,&CPDFWorker::error,this,&CBrowserNet::pdfError,Qt::QueuedConnection);
+                QMetaObject::invokeMethod(pdf,&CAbstractThreadWorker::start,Qt::QueuedConnection);
+            }
         } else if (mime.startsWith(QSL("text/html"),Qt::CaseInsensitive) && fi.suffix().isEmpty()) {
             // for local html files without extension
             QUrl u = url;
@@ -26,9 +26,6 @@ public:
     bool isValidLoadedUrl();
     QUrl getLoadedUrl() const { return m_loadedUrl; }
 
-Q_SIGNALS:
-    void startPdfConversion(const QString& filename);
-
 public Q_SLOTS:
     void load(const QUrl & url, bool autoTranslate, bool alternateAutoTranslate);
     void load(const QString & html, const QUrl& baseUrl,
@@ -18,6 +18,11 @@ CAbstractExtractor::CAbstractExtractor(QObject *parent)
 {
 }
 
+CAbstractThreadWorker::WorkerCategory CAbstractExtractor::workerCategory() const
+{
+    return wcExtractor;
+}
+
 
 QList<QAction *> CAbstractExtractor::addMenuActions(const QUrl &pageUrl, const QUrl &origin,
                                                     const QString &title, QMenu *menu,
@@ -21,6 +21,7 @@ public:
                                            const QString &title, QMenu *menu, QObject *workersParent,
                                            bool skipHtmlParserActions);
     static CAbstractExtractor* extractorFactory(const QVariant &data, QWidget *parentWidget);
+    WorkerCategory workerCategory() const override;
 
 protected:
     void showError(const QString &message);
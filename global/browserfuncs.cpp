@@ -1,5 +1,6 @@
-#include <chrono>
 #include <QSettings>
+#include <QEventLoop>
+#include <QPointer>
 
 #include "browserfuncs.h"
 #include "control.h"
@@ -7,12 +8,6 @@
 #include "utils/specwidgets.h"
 #include "utils/genericfuncs.h"
 
-using namespace std::chrono_literals;
-
-namespace CDefaults {
-const auto domWorkerCheckInterval = 500ms;
-}
-
 CGlobalBrowserFuncs::CGlobalBrowserFuncs(QObject *parent)
     : QObject(parent)
 {
@@ -108,26 +103,8 @@ void CGlobalBrowserFuncs::removePassword(const QUrl &origin) const
 QVector<CUserScript> CGlobalBrowserFuncs::getUserScriptsForUrl(const QUrl &url, bool isMainFrame, bool isContextMenu,
                                                           bool isTranslator)
 {
-    gSet->d_func()->userScriptsMutex.lock();
-
-    QVector<CUserScript> scripts;
-
-    for (auto it = gSet->d_func()->userScripts.constBegin(),
-         end = gSet->d_func()->userScripts.constEnd(); it != end; ++it) {
-        if (it.value().isEnabledForUrl(url) &&
-                (isMainFrame || it.value().shouldRunOnSubFrames()) &&
-                ((isContextMenu && it.value().shouldRunFromContextMenu()) ||
-                 (!isContextMenu && !it.value().shouldRunFromContextMenu())) &&
-                ((isTranslator && it.value().shouldRunByTranslator()) ||
-                 (!isTranslator && !it.value().shouldRunByTranslator()))) {
-
-            scripts.append(it.value());
-        }
-    }
-
-    gSet->d_func()->userScriptsMutex.unlock();
-
-    return scripts;
+    // Matcher snapshot is replaced atomically on scripts update, no locking here
+    return gSet->d_func()->userScriptMatcher.match(url,isMainFrame,isContextMenu,isTranslator);
 }
 
 void CGlobalBrowserFuncs::initUserScripts(const CStringHash &scripts)
@@ -137,6 +114,7 @@ void CGlobalBrowserFuncs::initUserScripts(const CStringHash &scripts)
     gSet->d_func()->userScripts.clear();
     for (auto it = scripts.constBegin(), end = scripts.constEnd(); it != end; ++it)
         gSet->d_func()->userScripts[it.key()] = CUserScript(it.key(), it.value());
+    gSet->d_func()->userScriptMatcher.rebuild(gSet->d_func()->userScripts);
 
     gSet->d_func()->userScriptsMutex.unlock();
 }
@@ -171,47 +149,18 @@ void CGlobalBrowserFuncs::headlessDOMWorker(const QUrl &url, const QString &java
 {
     if (!isDOMWorkerReady()) return;
 
-    QMutexLocker locker(&(gSet->d_func()->domWorkerMutex));
-
-    QTimer retryTimer;
-    QTimer failTimer;
+    // Pool is responsible for request timeout, quit is queued to survive early completion
     QPointer<QEventLoop> eventLoop(new QEventLoop());
-
-    retryTimer.setInterval(CDefaults::domWorkerCheckInterval);
-    retryTimer.setSingleShot(false);
-    failTimer.setInterval(1s * gSet->settings()->domWorkerReplyTimeoutSec);
-    failTimer.setSingleShot(true);
-    connect(&failTimer,&QTimer::timeout,eventLoop.data(),[eventLoop,url](){
-        qWarning() << QSL("Failed to load page '%1' in DOM worker, aborting.").arg(url.toString());
+    gSet->d_func()->domWorkerPool->evaluate(url,javaScript,matchFunc,[eventLoop](){
         if (eventLoop)
-            eventLoop->quit();
-    });
-
-    QMetaObject::invokeMethod(gSet->d_func()->domWorker->page(),[url](){
-        gSet->d_func()->domWorker->load(url);
-    });
-
-    connect(&retryTimer,&QTimer::timeout,gSet->d_func()->domWorker->page(),
-            [javaScript,eventLoop,matchFunc](){
-        if (eventLoop.isNull())
-            return;
-
-        gSet->d_func()->domWorker->page()->runJavaScript(javaScript,
-                                                         [eventLoop,matchFunc](const QVariant &result) {
-            if (matchFunc(result))
-                eventLoop->quit();
-        });
+            QMetaObject::invokeMethod(eventLoop.data(),&QEventLoop::quit,Qt::QueuedConnection);
     });
 
-    failTimer.start();
-    retryTimer.start();
     eventLoop->exec();
-    retryTimer.stop();
-    failTimer.stop();
     eventLoop->deleteLater();
 }
 
 bool CGlobalBrowserFuncs::isDOMWorkerReady() const
 {
-    return !(gSet->d_func()->domWorker.isNull());
+    return !(gSet->d_func()->domWorkerPool.isNull());
 }
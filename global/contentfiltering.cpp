@@ -28,17 +28,15 @@ bool CGlobalContentFiltering::isUrlBlocked(const QUrl& url, QString &filter)
 
     if (gSet->d_func()->adblockWhiteList.contains(u)) return false;
 
-    auto it = std::find_if(std::execution::par,
-                           gSet->d_func()->adblock.begin(),
-                           gSet->d_func()->adblock.end(),
-                           [u](const CAdBlockRule& rule) -> bool {
-        return rule.networkMatch(u);
-    });
-    if (it != gSet->d_func()->adblock.end()) {
-        filter = it->filter();
-        return true;
+    if (!gSet->d_func()->adblockMatcher.isValid()) {
+        gSet->d_func()->adblockModifyMutex.lock();
+        gSet->d_func()->adblockMatcher.rebuild(gSet->d_func()->adblock);
+        gSet->d_func()->adblockModifyMutex.unlock();
     }
 
+    if (gSet->d_func()->adblockMatcher.match(u,filter))
+        return true;
+
     Q_EMIT addAdBlockWhiteListUrl(u);
 
     return false;
@@ -72,6 +70,7 @@ void CGlobalContentFiltering::adblockAppend(const CAdBlockRule& url, bool fast)
 {
     gSet->d_func()->adblockModifyMutex.lock();
     gSet->d_func()->adblock.push_back(url);
+    gSet->d_func()->adblockMatcher.invalidate();
     gSet->d_func()->adblockModifyMutex.unlock();
 
     if (!fast) {
@@ -92,6 +91,7 @@ void CGlobalContentFiltering::adblockDelete(const CAdBlockVector &rules)
         auto res = excludes.find(rule);
         return (res != excludes.end());
     }),gSet->d_func()->adblock.end());
+    gSet->d_func()->adblockMatcher.invalidate();
     gSet->d_func()->adblockModifyMutex.unlock();
 
     gSet->d_func()->clearAdblockWhiteList();
@@ -103,6 +103,7 @@ void CGlobalContentFiltering::adblockClear()
 {
     gSet->d_func()->adblockModifyMutex.lock();
     gSet->d_func()->adblock.clear();
+    gSet->d_func()->adblockMatcher.invalidate();
     gSet->d_func()->adblockModifyMutex.unlock();
 
     gSet->d_func()->clearAdblockWhiteList();
@@ -13,10 +13,13 @@
 #include "structures.h"
 #include "settings.h"
 #include "browser-utils/adblockrule.h"
+#include "browser-utils/adblockmatcher.h"
 #include "browser-utils/userscript.h"
+#include "browser-utils/userscriptmatcher.h"
 #include "browser-utils/downloadmanager.h"
 #include "browser-utils/downloadwriter.h"
 #include "browser-utils/autofillassistant.h"
+#include "browser-utils/domworkerpool.h"
 #include "utils/auxdictionary.h"
 #include "utils/cliworker.h"
 #include "utils/workermonitor.h"
@@ -36,6 +39,7 @@ class CTranslatorCache;
 class CAbstractThreadWorker;
 class CWorkerMonitor;
 class CZipWriter;
+class CWorkerExecutor;
 
 class CGlobalControlPrivate : public QObject
 {
@@ -49,6 +53,7 @@ public:
     ZDict::ZDictController * dictManager { nullptr };
     CTranslatorCache *translatorCache { nullptr };
     CZipWriter *zipWriter { nullptr };
+    CWorkerExecutor *workerExecutor { nullptr };
 
     QWebEngineProfile *domWorkerProfile { nullptr };
 
@@ -62,9 +67,8 @@ public:
     QScopedPointer<CWorkerMonitor, QScopedPointerDeleteLater> workerMonitor;
     QScopedPointer<CAutofillAssistant, QScopedPointerDeleteLater> autofillAssistant;
     QScopedPointer<QFileSystemWatcher, QScopedPointerDeleteLater> xapianFilesystemWatcher;
-    QScopedPointer<QWebEngineView, QScopedPointerDeleteLater> domWorker;
+    QScopedPointer<CDOMWorkerPool, QScopedPointerDeleteLater> domWorkerPool;
     QList<CAbstractThreadWorker *> workerPool;
-    QMutex domWorkerMutex;
 
     QStringList recentFiles;
     CStringHash ctxSearchEngines;
@@ -93,10 +97,12 @@ public:
 
     QHash<QString, CUserScript> userScripts;
     QMutex userScriptsMutex;
+    CUserScriptMatcher userScriptMatcher;
     bool cleaningState { false };
     bool sslCertErrorInteractive { false };
 
     CAdBlockVector adblock;
+    CAdBlockMatcher adblockMatcher;
     QMutex adblockModifyMutex;
     QStringList adblockWhiteList;
     QMutex adblockWhiteListMutex;
@@ -196,7 +196,12 @@ void CSettings::writeSettings()
     settings.setValue(QSL("openaiTopP"),openaiTopP);
     settings.setValue(QSL("openaiPresencePenalty"),openaiPresencePenalty);
     settings.setValue(QSL("openaiFrequencyPenalty"),openaiFrequencyPenalty);
+    settings.setValue(QSL("openaiBaseUrl"),openaiBaseUrl);
+    settings.setValue(QSL("openaiBatchParagraphs"),openaiBatchParagraphs);
+    settings.setValue(QSL("openaiStreaming"),openaiStreaming);
     settings.setValue(QSL("tokensMaxCountCombined"),tokensMaxCountCombined);
+    settings.setValue(QSL("translatorParallelRequests"),translatorParallelRequests);
+    settings.setValue(QSL("translatorBatchSize"),translatorBatchSize);
 
     settings.setValue(QSL("createCoredumps"),createCoredumps);
     settings.setValue(QSL("overrideUserAgent"),overrideUserAgent);
@@ -219,15 +224,22 @@ void CSettings::writeSettings()
     settings.setValue(QSL("pixivMangaPageSize"),static_cast<int>(pixivMangaPageSize));
 
     settings.setValue(QSL("translatorCacheEnabled"),translatorCacheEnabled);
+    settings.setValue(QSL("translatorCacheCompression"),translatorCacheCompression);
     settings.setValue(QSL("translatorCacheSize"),translatorCacheSize);
 
     settings.setValue(QSL("xapianStemmerLang"),xapianStemmerLang);
     settings.setValue(QSL("xapianStartDelay"),getXapianTimerInterval());
     settings.setValue(QSL("xapianIndexDirList"),xapianIndexDirList);
+    settings.setValue(QSL("xapianCommitBatchSize"),xapianCommitBatchSize);
 
     settings.setValue(QSL("domWorkerReplyTimeoutSec"),domWorkerReplyTimeoutSec);
+    settings.setValue(QSL("domWorkerPoolSize"),domWorkerPoolSize);
 
     settings.setValue(QSL("mangaCacheWidth"),mangaCacheWidth);
+    settings.setValue(QSL("mangaCacheMemory"),mangaCacheMemory);
+    settings.setValue(QSL("mangaCacheSpillMemory"),mangaCacheSpillMemory);
+    settings.setValue(QSL("mangaFetchConcurrency"),mangaFetchConcurrency);
+    settings.setValue(QSL("mangaFetchPerHost"),mangaFetchPerHost);
     settings.setValue(QSL("mangaMagnifySize"),mangaMagnifySize);
     settings.setValue(QSL("mangaScrollDelta"),mangaScrollDelta);
     settings.setValue(QSL("mangaScrollFactor"),mangaScrollFactor);
@@ -293,6 +305,7 @@ bool CSettings::readBinaryBigData(QObject *control, const QString& dirname)
             }
             g->d_func()->adblockModifyMutex.lock();
             g->d_func()->adblock = rules;
+            g->d_func()->adblockMatcher.invalidate();
             g->d_func()->adblockModifyMutex.unlock();
             qInfo() << "Adblock rules loaded";
             Q_EMIT adblockRulesUpdated();
@@ -526,8 +539,14 @@ void CSettings::readSettings(QObject *control)
     openaiTopP = settings.value(QSL("openaiTopP"),CDefaults::openaiTopP).toDouble();
     openaiPresencePenalty = settings.value(QSL("openaiPresencePenalty"),CDefaults::openaiPresencePenalty).toDouble();
     openaiFrequencyPenalty = settings.value(QSL("openaiFrequencyPenalty"),CDefaults::openaiFrequencyPenalty).toDouble();
+    openaiBaseUrl = settings.value(QSL("openaiBaseUrl"),CDefaults::openaiBaseUrl).toString();
+    openaiBatchParagraphs = settings.value(QSL("openaiBatchParagraphs"),CDefaults::openaiBatchParagraphs).toBool();
+    openaiStreaming = settings.value(QSL("openaiStreaming"),CDefaults::openaiStreaming).toBool();
 
     tokensMaxCountCombined = settings.value(QSL("tokensMaxCountCombined"),CDefaults::tokensMaxCountCombined).toInt();
+    translatorParallelRequests = settings.value(QSL("translatorParallelRequests"),
+                                                CDefaults::translatorParallelRequests).toInt();
+    translatorBatchSize = settings.value(QSL("translatorBatchSize"),CDefaults::translatorBatchSize).toInt();
 
     jsLogConsole = settings.value(QSL("jsLogConsole"),CDefaults::jsLogConsole).toBool();
     downloaderCleanCompleted = settings.value(QSL("downloaderCleanCompleted"),
@@ -556,15 +575,21 @@ void CSettings::readSettings(QObject *control)
 
     translatorCacheEnabled = settings.value(QSL("translatorCacheEnabled"),
                                             CDefaults::translatorCacheEnabled).toBool();
+    translatorCacheCompression = settings.value(QSL("translatorCacheCompression"),
+                                                CDefaults::translatorCacheCompression).toBool();
     translatorCacheSize = settings.value(QSL("translatorCacheSize"),
                                          CDefaults::translatorCacheSize).toInt();
 
     domWorkerReplyTimeoutSec = settings.value(QSL("domWorkerReplyTimeoutSec"),
                                               CDefaults::domWorkerReplyTimeoutSec).toInt();
+    domWorkerPoolSize = settings.value(QSL("domWorkerPoolSize"),
+                                       CDefaults::domWorkerPoolSize).toInt();
 
     setupXapianTimerInterval(g,settings.value(QSL("xapianStartDelay"),CDefaults::xapianStartDelay).toInt());
     xapianStemmerLang = settings.value(QSL("xapianStemmerLang"),QString()).toString();
     xapianIndexDirList = settings.value(QSL("xapianIndexDirList"),QStringList()).toStringList();
+    xapianCommitBatchSize = settings.value(QSL("xapianCommitBatchSize"),
+                                           CDefaults::xapianCommitBatchSize).toInt();
 
     overrideUserAgent=settings.value(QSL("overrideUserAgent"),
                                      CDefaults::overrideUserAgent).toBool();
@@ -576,6 +601,11 @@ void CSettings::readSettings(QObject *control)
     }
 
     mangaCacheWidth = settings.value(QSL("mangaCacheWidth"),CDefaults::mangaCacheWidth).toInt();
+    mangaCacheMemory = settings.value(QSL("mangaCacheMemory"),CDefaults::mangaCacheMemory).toInt();
+    mangaCacheSpillMemory = settings.value(QSL("mangaCacheSpillMemory"),
+                                           CDefaults::mangaCacheSpillMemory).toInt();
+    mangaFetchConcurrency = settings.value(QSL("mangaFetchConcurrency"),CDefaults::mangaFetchConcurrency).toInt();
+    mangaFetchPerHost = settings.value(QSL("mangaFetchPerHost"),CDefaults::mangaFetchPerHost).toInt();
     mangaMagnifySize = settings.value(QSL("mangaMagnifySize"),CDefaults::mangaMagnifySize).toInt();
     mangaScrollDelta = settings.value(QSL("mangaScrollDelta"),CDefaults::mangaScrollDelta).toInt();
     mangaScrollFactor = settings.value(QSL("mangaScrollFactor"),CDefaults::mangaScrollFactor).toInt();
@@ -624,7 +654,7 @@ void CSettings::readSettings(QObject *control)
         g->m_actions->rebindGctxHotkey(g);
         g->d_func()->reloadXapianFilesystemWatcher(g);
 
-        COpenAITranslator::getAvailableModels(control,openaiAPIKey);
+        COpenAITranslator::getAvailableModels(control,openaiAPIKey,openaiBaseUrl);
     }
 }
 
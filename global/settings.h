@@ -37,12 +37,20 @@ const int fontSizeFixed = 12;
 const int translatorCacheSize = 128;
 const int xapianStartDelay = 30;
 const int domWorkerReplyTimeoutSec = 60;
+const int domWorkerPoolSize = 2;
 const int mangaMagnifySize = 150;
 const int mangaScrollDelta = 120;
 const int mangaScrollFactor = 5;
 const int mangaCacheWidth = 6;
+const int mangaCacheMemory = 512;
+const int mangaCacheSpillMemory = 0;
+const int mangaFetchConcurrency = 6;
+const int mangaFetchPerHost = 4;
 const int downloadsLimit = 0;
 const int tokensMaxCountCombined = 1024;
+const int translatorParallelRequests = 4;
+const int translatorBatchSize = 2000;
+const int xapianCommitBatchSize = 1000;
 const unsigned int mangaBackgroundColor = 0x303030;
 const double mangaResizeBlur = 1.0;
 const double openaiTemperature = 1.0;
@@ -80,8 +88,11 @@ const bool ignoreSSLErrors = false;
 const bool pdfExtractImages = true;
 const bool pixivFetchImages = false;
 const bool translatorCacheEnabled = false;
+const bool translatorCacheCompression = true;
 const bool downloaderCleanCompleted = false;
 const bool mangaUseFineRendering = true;
+const bool openaiBatchParagraphs = true;
+const bool openaiStreaming = true;
 const auto fontFixed = "Courier New";
 const auto fontSerif = "Times New Roman";
 const auto fontSansSerif = "Verdana";
@@ -89,6 +100,7 @@ const auto sysBrowser = "konqueror";
 const auto sysEditor = "kwrite";
 const auto propXapianInotifyTimer = "inotify";
 const auto promtNmtServer = "https://pts.promt.ru/pts";
+const auto openaiBaseUrl = "https://api.openai.com/v1";
 }
 
 class CGlobalControl;
@@ -135,6 +147,7 @@ public:
     QString deeplAPIKey;
     QString openaiAPIKey;
     QString openaiTranslationModel;
+    QString openaiBaseUrl;
 
     QString xapianStemmerLang;
 
@@ -173,12 +186,20 @@ public:
     int translatorCacheSize { CDefaults::translatorCacheSize };
     int translatorRetryCount { CDefaults::translatorRetryCount };
     int domWorkerReplyTimeoutSec { CDefaults::domWorkerReplyTimeoutSec };
+    int domWorkerPoolSize { CDefaults::domWorkerPoolSize };
     int mangaMagnifySize { CDefaults::mangaMagnifySize };
     int mangaScrollDelta { CDefaults::mangaScrollDelta };
     int mangaScrollFactor { CDefaults::mangaScrollFactor };
     int mangaCacheWidth { CDefaults::mangaCacheWidth };
+    int mangaCacheMemory { CDefaults::mangaCacheMemory };
+    int mangaCacheSpillMemory { CDefaults::mangaCacheSpillMemory };
+    int mangaFetchConcurrency { CDefaults::mangaFetchConcurrency };
+    int mangaFetchPerHost { CDefaults::mangaFetchPerHost };
     int downloadsLimit { CDefaults::downloadsLimit };
     int tokensMaxCountCombined { CDefaults::tokensMaxCountCombined };
+    int translatorParallelRequests { CDefaults::translatorParallelRequests };
+    int translatorBatchSize { CDefaults::translatorBatchSize };
+    int xapianCommitBatchSize { CDefaults::xapianCommitBatchSize };
     quint16 atlPort { CDefaults::atlPort };
     quint16 proxyPort { CDefaults::proxyPort };
     QSsl::SslProtocol atlProto { CDefaults::atlProto };
@@ -219,8 +240,11 @@ public:
     bool pdfExtractImages { CDefaults::pdfExtractImages };
     bool pixivFetchImages { CDefaults::pixivFetchImages };
     bool translatorCacheEnabled { CDefaults::translatorCacheEnabled };
+    bool translatorCacheCompression { CDefaults::translatorCacheCompression };
     bool downloaderCleanCompleted { CDefaults::downloaderCleanCompleted };
     bool mangaUseFineRendering { CDefaults::mangaUseFineRendering };
+    bool openaiBatchParagraphs { CDefaults::openaiBatchParagraphs };
+    bool openaiStreaming { CDefaults::openaiStreaming };
 
     explicit CSettings(CGlobalControl *parent);
     ~CSettings() override = default;
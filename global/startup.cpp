@@ -23,12 +23,14 @@ extern "C" {
 #include "contentfiltering.h"
 #include "network.h"
 #include "ui.h"
+#include "workerexecutor.h"
 #include "browser-utils/adblockrule.h"
 #include "browser-utils/bookmarks.h"
 #include "browser-utils/browsercontroller.h"
 #include "browser-utils/downloadmanager.h"
 #include "translator/translatorcache.h"
 #include "translator/lighttranslator.h"
+#include "translator-workers/atlastranslator.h"
 #include "utils/genericfuncs.h"
 #include "utils/pdftotext.h"
 #include "utils/logdisplay.h"
@@ -106,6 +108,8 @@ void CGlobalStartup::initialize()
     QString tcache = fs + QSL("translator_cache") + QDir::separator();
     QString auxcache = fs + QSL("aux_cache") + QDir::separator();
 
+    m_g->d_func()->workerExecutor = new CWorkerExecutor(this);
+
     if (cliMode) {
         m_g->d_func()->cliWorker.reset(new CCLIWorker());
         connect(m_g->d_func()->cliWorker.data(),&CCLIWorker::finished,this,&CGlobalStartup::cleanupAndExit);
@@ -122,6 +126,8 @@ void CGlobalStartup::initialize()
         m_g->d_func()->downloadManager.reset(new CDownloadManager(nullptr,m_g->d_func()->zipWriter));
         m_g->d_func()->bookmarksManager = new BookmarksManager(this);
         m_g->d_func()->workerMonitor.reset(new CWorkerMonitor());
+        connect(m_g->d_func()->workerExecutor,&CWorkerExecutor::workerDispatched,
+                m_g->d_func()->workerMonitor.data(),&CWorkerMonitor::workerDispatched);
         m_g->d_func()->autofillAssistant.reset(new CAutofillAssistant());
 
         m_g->d_func()->auxTranslatorDBus = new CAuxTranslator(this);
@@ -252,9 +258,8 @@ void CGlobalStartup::initialize()
         m_g->m_ui->addMainWindowEx(false,true,openUrls);
         QTimer::singleShot(m_g->d_func()->xapianIndexerTimer.interval(),this,&CGlobalStartup::startupXapianIndexer);
         QTimer::singleShot(CDefaults::domWorkerStartupDelay,this,[](){
-            gSet->d_func()->domWorker.reset(new QWebEngineView());
-            gSet->d_func()->domWorker->setPage(new QWebEnginePage(gSet->d_func()->domWorkerProfile,
-                                                                  gSet->d_func()->domWorker.data()));
+            gSet->d_func()->domWorkerPool.reset(new CDOMWorkerPool(gSet->d_func()->domWorkerProfile,
+                                                                   gSet->settings()->domWorkerPoolSize));
         });
 
         qInfo() << "Initialization time, ms: " << initTime.elapsed();
@@ -390,6 +395,7 @@ void CGlobalStartup::stopAndCloseWorkers()
         m_g->d_func()->zipWriter->terminateAllWorkers();
     if (!m_g->d_func()->workerPool.isEmpty()) {
         Q_EMIT terminateWorkers();
+        m_g->d_func()->workerExecutor->terminateAll();
         started = std::chrono::steady_clock::now();
         while (!m_g->d_func()->workerPool.isEmpty() &&
                ((std::chrono::steady_clock::now() - started) < CDefaults::workerMaxShutdownTime)) {
@@ -424,6 +430,7 @@ void CGlobalStartup::cleanupAndExit()
     stopAndCloseWorkers();
 
     CPDFWorker::freePdfToText();
+    CAtlasConnectionPool::cleanup();
 
     if (!m_g->m_actions.isNull()) {
         // free global objects
@@ -435,7 +442,7 @@ void CGlobalStartup::cleanupAndExit()
         m_g->d_func()->autofillAssistant.reset(nullptr);
         m_g->d_func()->ipcServer->close();
         m_g->d_func()->ipcServer.reset(nullptr);
-        m_g->d_func()->domWorker.reset(nullptr);
+        m_g->d_func()->domWorkerPool.reset(nullptr);
     }
 
     QMetaObject::invokeMethod(QApplication::instance(),&QApplication::quit,Qt::QueuedConnection);
@@ -450,16 +457,9 @@ bool CGlobalStartup::setupThreadedWorker(CAbstractThreadWorker *worker)
 
     m_g->d_func()->workerPool.append(worker);
 
-    auto *thread = new QThread();
-    worker->moveToThread(thread);
-
     connect(worker,&CAbstractThreadWorker::finished,this,&CGlobalStartup::cleanupWorker,Qt::QueuedConnection);
-    connect(worker,&CAbstractThreadWorker::finished,thread,&QThread::quit);
-    connect(thread,&QThread::finished,worker,&CAbstractThreadWorker::deleteLater);
-    connect(thread,&QThread::finished,thread,&QThread::deleteLater);
     connect(this,&CGlobalStartup::stopWorkers,
             worker,&CAbstractThreadWorker::abort,Qt::QueuedConnection);
-    connect(this,&CGlobalStartup::terminateWorkers,thread,&QThread::terminate);
 
     connect(worker,&CAbstractThreadWorker::started,
             m_g->actions(),&CGlobalActions::updateBusyCursor,Qt::QueuedConnection);
@@ -485,10 +485,11 @@ bool CGlobalStartup::setupThreadedWorker(CAbstractThreadWorker *worker)
                 gSet->downloadManager(),&CDownloadManager::mangaReady,Qt::QueuedConnection);
     }
 
-    m_g->d_func()->workerMonitor->workerStarted(worker);
+    // Executor moves worker to the pooled thread or queues it until category slot is available
+    m_g->d_func()->workerExecutor->submit(worker);
 
-    thread->setObjectName(QSL("WRK-%1").arg(QString::fromLatin1(worker->metaObject()->className())));
-    thread->start();
+    if (m_g->d_func()->workerMonitor)
+        m_g->d_func()->workerMonitor->workerStarted(worker);
 
     return true;
 }
@@ -502,7 +503,8 @@ void CGlobalStartup::cleanupWorker()
 {
     auto *worker = qobject_cast<CAbstractThreadWorker *>(sender());
     if (worker) {
-        m_g->d_func()->workerMonitor->workerAboutToFinished(worker);
+        if (m_g->d_func()->workerMonitor)
+            m_g->d_func()->workerMonitor->workerAboutToFinished(worker);
         m_g->d_func()->workerPool.removeAll(worker);
     }
 
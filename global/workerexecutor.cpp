@@ -0,0 +1,169 @@
+#include <algorithm>
+#include "workerexecutor.h"
+#include "structures.h"
+
+namespace CDefaults {
+const int workerExecutorIndexerLimit = 2;
+const int workerExecutorSchedulerLimit = 4;
+const int workerExecutorThreadWaitMS = 1000;
+}
+
+CWorkerExecutor::CWorkerExecutor(QObject *parent)
+    : QObject(parent)
+{
+}
+
+CWorkerExecutor::~CWorkerExecutor()
+{
+    for (auto *thread : qAsConst(m_idleThreads)) {
+        thread->quit();
+        thread->wait(CDefaults::workerExecutorThreadWaitMS);
+        delete thread;
+    }
+    m_idleThreads.clear();
+}
+
+int CWorkerExecutor::categoryLimit(CAbstractThreadWorker::WorkerCategory category) const
+{
+    const int idealCount = qMax(1,QThread::idealThreadCount());
+
+    switch (category) {
+        case CAbstractThreadWorker::wcIndexer: return CDefaults::workerExecutorIndexerLimit;
+        case CAbstractThreadWorker::wcScheduler: return CDefaults::workerExecutorSchedulerLimit;
+        // Writers are controlled directly by download manager and manga viewer
+        case CAbstractThreadWorker::wcWriter: return -1;
+        default: return idealCount;
+    }
+}
+
+bool CWorkerExecutor::canDispatch(CAbstractThreadWorker *worker) const
+{
+    const int limit = categoryLimit(worker->workerCategory());
+    if (limit < 0) return true;
+
+    return (m_runningPerCategory.value(worker->workerCategory(),0) < limit);
+}
+
+void CWorkerExecutor::submit(CAbstractThreadWorker *worker)
+{
+    connect(worker,&CAbstractThreadWorker::finished,this,&CWorkerExecutor::workerFinished,Qt::QueuedConnection);
+
+    if (canDispatch(worker)) {
+        dispatch(worker);
+        return;
+    }
+
+    // Worker stays in main thread until dispatch, start request is postponed
+    worker->m_queued.storeRelease(true);
+
+    QueueEntry entry;
+    entry.worker = worker;
+    entry.priority = worker->workerPriority();
+    entry.sequence = m_sequence++;
+
+    auto it = std::upper_bound(m_queue.begin(),m_queue.end(),entry,
+                               [](const QueueEntry& a, const QueueEntry& b){
+        if (a.priority != b.priority)
+            return (a.priority > b.priority);
+        return (a.sequence < b.sequence);
+    });
+    m_queue.insert(it,entry);
+}
+
+void CWorkerExecutor::dispatch(CAbstractThreadWorker *worker)
+{
+    QThread *thread = acquireThread();
+    thread->setObjectName(QSL("WRK-%1").arg(QString::fromLatin1(worker->metaObject()->className())));
+
+    RunningEntry entry;
+    entry.thread = thread;
+    entry.category = worker->workerCategory();
+    m_running.insert(worker,entry);
+    m_runningPerCategory[entry.category]++;
+
+    // Pending queued calls are moved to the new thread along with the worker
+    worker->moveToThread(thread);
+
+    if (worker->m_queued.testAndSetOrdered(true,false)) {
+        Q_EMIT workerDispatched(worker);
+
+        if (worker->m_startRequested.testAndSetOrdered(true,false))
+            QMetaObject::invokeMethod(worker,&CAbstractThreadWorker::start,Qt::QueuedConnection);
+    }
+}
+
+void CWorkerExecutor::dispatchQueued()
+{
+    auto it = m_queue.begin();
+    while (it != m_queue.end()) {
+        if (it->worker.isNull()) {
+            it = m_queue.erase(it);
+            continue;
+        }
+        if (canDispatch(it->worker.data())) {
+            CAbstractThreadWorker *worker = it->worker.data();
+            it = m_queue.erase(it);
+            dispatch(worker);
+            continue;
+        }
+        it++;
+    }
+}
+
+QThread *CWorkerExecutor::acquireThread()
+{
+    if (!m_idleThreads.isEmpty())
+        return m_idleThreads.takeLast();
+
+    auto *thread = new QThread();
+    thread->start();
+    return thread;
+}
+
+void CWorkerExecutor::releaseThread(QThread *thread)
+{
+    if (thread->isRunning() && m_idleThreads.count() < QThread::idealThreadCount()) {
+        thread->setObjectName(QSL("WRK-idle"));
+        m_idleThreads.append(thread);
+        return;
+    }
+
+    connect(thread,&QThread::finished,thread,&QThread::deleteLater);
+    thread->quit();
+}
+
+void CWorkerExecutor::workerFinished()
+{
+    // Sender is used as a key only, it may be already deleted by repeated finished signal
+    auto *worker = static_cast<CAbstractThreadWorker *>(sender());
+    if (worker == nullptr) return;
+
+    auto it = m_running.find(worker);
+    if (it == m_running.end()) {
+        // Aborted before dispatch, worker still lives in main thread
+        auto qit = std::find_if(m_queue.begin(),m_queue.end(),[worker](const QueueEntry& entry){
+            return (!entry.worker.isNull() && entry.worker.data() == worker);
+        });
+        if (qit == m_queue.end()) return;
+
+        qit->worker->deleteLater();
+        m_queue.erase(qit);
+        return;
+    }
+
+    const RunningEntry entry = it.value();
+    m_running.erase(it);
+    m_runningPerCategory[entry.category]--;
+
+    // Deferred deletion is processed by the worker thread before the next job
+    worker->deleteLater();
+    releaseThread(entry.thread);
+
+    dispatchQueued();
+}
+
+void CWorkerExecutor::terminateAll()
+{
+    for (auto it = m_running.constBegin(), end = m_running.constEnd(); it != end; ++it)
+        it.value().thread->terminate();
+}
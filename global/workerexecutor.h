@@ -0,0 +1,55 @@
+#ifndef CWORKEREXECUTOR_H
+#define CWORKEREXECUTOR_H
+
+#include <QObject>
+#include <QThread>
+#include <QHash>
+#include <QList>
+#include <QPointer>
+#include "abstractthreadworker.h"
+
+class CWorkerExecutor : public QObject
+{
+    Q_OBJECT
+    Q_DISABLE_COPY(CWorkerExecutor)
+public:
+    explicit CWorkerExecutor(QObject *parent = nullptr);
+    ~CWorkerExecutor() override;
+
+    void submit(CAbstractThreadWorker *worker);
+    void terminateAll();
+
+private:
+    struct QueueEntry {
+        QPointer<CAbstractThreadWorker> worker;
+        int priority { CAbstractThreadWorker::wpNormal };
+        quint64 sequence { 0UL };
+    };
+
+    QList<QueueEntry> m_queue;
+    QList<QThread *> m_idleThreads;
+    struct RunningEntry {
+        QThread *thread { nullptr };
+        CAbstractThreadWorker::WorkerCategory category { CAbstractThreadWorker::wcGeneric };
+    };
+
+    QHash<CAbstractThreadWorker *, RunningEntry> m_running;
+    QHash<int, int> m_runningPerCategory;
+    quint64 m_sequence { 0UL };
+
+    int categoryLimit(CAbstractThreadWorker::WorkerCategory category) const;
+    bool canDispatch(CAbstractThreadWorker *worker) const;
+    void dispatch(CAbstractThreadWorker *worker);
+    void dispatchQueued();
+    QThread *acquireThread();
+    void releaseThread(QThread *thread);
+
+Q_SIGNALS:
+    void workerDispatched(CAbstractThreadWorker *worker);
+
+private Q_SLOTS:
+    void workerFinished();
+
+};
+
+#endif // CWORKEREXECUTOR_H
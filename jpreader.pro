@@ -1,6 +1,7 @@
 HEADERS = mainwindow.h \
     abstractthreadworker.h \
     browser-utils/autofillassistant.h \
+    browser-utils/domworkerpool.h \
     browser-utils/downloadlistmodel.h \
     browser-utils/downloadmodel.h \
     browser/browser.h \
@@ -21,9 +22,13 @@ HEADERS = mainwindow.h \
     manga/mangaviewtab.h \
     manga/scalefilter.h \
     manga/zmangaview.h \
+    manga/zpagecache.h \
+    manga/ztilecache.h \
+    manga/zpagefetchqueue.h \
     manga/zscrollarea.h \
     search/baloosearch.h \
     search/defaultsearch.h \
+    search/xapianindexjournal.h \
     search/xapianindexworker.h \
     search/xapianindexworker_p.h \
     search/xapiansearch.h \
@@ -34,8 +39,10 @@ HEADERS = mainwindow.h \
     translator-workers/deeplapitranslator.h \
     translator-workers/deeplfreetranslator.h \
     translator-workers/openaitranslator.h \
+    translator-workers/openaiprotocol.h \
     translator-workers/promtnmttranslator.h \
     translator-workers/promtonefreetranslator.h \
+    translator-workers/translatorratelimiter.h \
     translator-workers/yandexcloudtranslator.h \
     translator-workers/yandextranslator.h \
     translator-workers/googlecloudtranslator.h \
@@ -53,11 +60,14 @@ HEADERS = mainwindow.h \
     global/settings.h \
     global/contentfiltering.h \
     global/startup.h \
+    global/workerexecutor.h \
     browser-utils/authdlg.h \
     browser-utils/adblockrule.h \
+    browser-utils/adblockmatcher.h \
     browser-utils/downloadmanager.h \
     browser-utils/downloadwriter.h \
     browser-utils/userscript.h \
+    browser-utils/userscriptmatcher.h \
     browser-utils/browsercontroller.h \
     browser-utils/bookmarks.h \
     browser-utils/xbel.h \
@@ -71,6 +81,7 @@ HEADERS = mainwindow.h \
     translator/auxtranslator.h \
     translator/translator.h \
     translator/titlestranslator.h \
+    translator/translatorbatch.h \
     translator/translatorcache.h \
     translator/translatorcachedialog.h \
     translator/translatorstatisticstab.h \
@@ -81,6 +92,7 @@ HEADERS = mainwindow.h \
     utils/sequencescheduler.h \
     utils/settingstab.h \
     utils/genericfuncs.h \
+    utils/contentdetector.h \
     utils/cliworker.h \
     utils/pixivindextab.h \
     utils/logdisplay.h \
@@ -96,6 +108,7 @@ HEADERS = mainwindow.h \
 
 SOURCES = main.cpp \
     browser-utils/autofillassistant.cpp \
+    browser-utils/domworkerpool.cpp \
     browser-utils/downloadlistmodel.cpp \
     browser-utils/downloadmodel.cpp \
     browser/browser.cpp \
@@ -116,10 +129,15 @@ SOURCES = main.cpp \
     abstractthreadworker.cpp \
     manga/mangaviewtab.cpp \
     manga/scalefilter.cpp \
+    manga/fastscalefilter.cpp \
     manga/zmangaview.cpp \
+    manga/zpagecache.cpp \
+    manga/ztilecache.cpp \
+    manga/zpagefetchqueue.cpp \
     manga/zscrollarea.cpp \
     search/baloosearch.cpp \
     search/defaultsearch.cpp \
+    search/xapianindexjournal.cpp \
     search/xapianindexworker.cpp \
     search/xapiansearch.cpp \
     translator-workers/alicloudtranslator.cpp \
@@ -130,8 +148,10 @@ SOURCES = main.cpp \
     translator-workers/deeplapitranslator.cpp \
     translator-workers/deeplfreetranslator.cpp \
     translator-workers/openaitranslator.cpp \
+    translator-workers/openaiprotocol.cpp \
     translator-workers/promtnmttranslator.cpp \
     translator-workers/promtonefreetranslator.cpp \
+    translator-workers/translatorratelimiter.cpp \
     translator-workers/yandexcloudtranslator.cpp \
     translator-workers/yandextranslator.cpp \
     translator-workers/googlecloudtranslator.cpp \
@@ -148,11 +168,14 @@ SOURCES = main.cpp \
     global/settings.cpp \
     global/contentfiltering.cpp \
     global/startup.cpp \
+    global/workerexecutor.cpp \
     browser-utils/authdlg.cpp \
     browser-utils/adblockrule.cpp \
+    browser-utils/adblockmatcher.cpp \
     browser-utils/downloadmanager.cpp \
     browser-utils/downloadwriter.cpp \
     browser-utils/userscript.cpp \
+    browser-utils/userscriptmatcher.cpp \
     browser-utils/browsercontroller.cpp \
     browser-utils/bookmarks.cpp \
     browser-utils/xbel.cpp \
@@ -166,6 +189,7 @@ SOURCES = main.cpp \
     translator/auxtranslator.cpp \
     translator/translator.cpp \
     translator/titlestranslator.cpp \
+    translator/translatorbatch.cpp \
     translator/translatorcache.cpp \
     translator/translatorcachedialog.cpp \
     translator/translatorstatisticstab.cpp \
@@ -178,6 +202,7 @@ SOURCES = main.cpp \
     utils/sequencescheduler.cpp \
     utils/settingstab.cpp \
     utils/genericfuncs.cpp \
+    utils/contentdetector.cpp \
     utils/logdisplay.cpp \
     utils/auxdictionary.cpp \
     utils/multiinputdialog.cpp \
@@ -0,0 +1,444 @@
+#include <QCache>
+#include <QMutex>
+#include <QMutexLocker>
+#include <QSharedPointer>
+#include <QAtomicInteger>
+#include <algorithm>
+#include <execution>
+#include <numeric>
+#include <limits>
+#include <array>
+#include <functional>
+#include <cmath>
+#include <vector>
+#include "scalefilter.h"
+
+#if defined(__x86_64__) || defined(__i386__)
+#define BLITZ_X86_SIMD 1
+#include <immintrin.h>
+#endif
+
+/**
+ * Fixed-point separable resampler with the same filter kernels as the
+ * ImageMagick port in scalefilter.cpp.
+ *
+ * Contributions are computed once per (source length, target length, blur,
+ * filter) and kept in a small cache as 2.14 fixed-point weights. Both passes
+ * walk memory row by row in bands of scanlines, bands are processed in parallel.
+ */
+
+namespace BlitzFastScale {
+
+const int weightBits = 14;
+const int weightRound = 1 << (weightBits - 1);
+const double weightOne = 1 << weightBits;
+const double halfPixel = 0.5;
+const double epsilon = 1.0e-6;
+const int bandHeight = 32;
+const int tableCacheSize = 64;
+
+struct ContributionTable {
+    std::vector<int> start;
+    std::vector<int> count;
+    std::vector<int> offset;
+    std::vector<qint16> weights;
+};
+
+using TablePtr = QSharedPointer<const ContributionTable>;
+
+enum class SimdLevel { Scalar, SSE2, AVX2 };
+
+SimdLevel simdLevel()
+{
+    static const SimdLevel level = [](){
+#ifdef BLITZ_X86_SIMD
+        __builtin_cpu_init();
+        if (__builtin_cpu_supports("avx2"))
+            return SimdLevel::AVX2;
+        if (__builtin_cpu_supports("sse2"))
+            return SimdLevel::SSE2;
+#endif
+        return SimdLevel::Scalar;
+    }();
+    return level;
+}
+
+TablePtr buildTable(int srcLength, int dstLength, double blur, Blitz::ScaleFilterType filter)
+{
+    auto table = QSharedPointer<ContributionTable>::create();
+    const double factor = static_cast<double>(dstLength) / static_cast<double>(srcLength);
+    double scale = blur*qMax(1.0/factor, 1.0);
+    double support = scale*Blitz::filterSupportSize(filter);
+    if (support <= halfPixel) {
+        support = halfPixel+epsilon;
+        scale = 1.0;
+    }
+    scale = 1.0/scale;
+
+    table->start.resize(dstLength);
+    table->count.resize(dstLength);
+    table->offset.resize(dstLength);
+
+    std::vector<double> weights;
+    for (int x = 0; x < dstLength; ++x) {
+        const double center = (x+halfPixel)/factor;
+        const int start = qRound(qMax(center-support+halfPixel, 0.0));
+        const int stop = qMax(start+1,qRound(qMin(center+support+halfPixel, static_cast<double>(srcLength))));
+        const int count = qMin(stop,srcLength) - start;
+
+        weights.resize(count);
+        double density = 0.0;
+        for (int n = 0; n < count; ++n) {
+            weights[n] = Blitz::filterWeight(filter,scale*(start+n-center+halfPixel));
+            density += weights[n];
+        }
+        if ((density != 0.0) && (density != 1.0)) {
+            for (double &w : weights)
+                w /= density;
+        }
+
+        // Quantize, and push rounding error into the largest tap to keep exact unity gain
+        const int offset = static_cast<int>(table->weights.size());
+        int sum = 0;
+        int largest = 0;
+        for (int n = 0; n < count; ++n) {
+            const auto w = static_cast<qint16>(qBound<long>(std::numeric_limits<qint16>::min(),
+                                                            std::lround(weights[n]*weightOne),
+                                                            std::numeric_limits<qint16>::max()));
+            table->weights.push_back(w);
+            sum += w;
+            if (std::abs(w) > std::abs(table->weights[offset+largest]))
+                largest = n;
+        }
+        if (count > 0 && density != 0.0)
+            table->weights[offset+largest] += static_cast<qint16>((1 << weightBits) - sum);
+
+        table->start[x] = start;
+        table->count[x] = count;
+        table->offset[x] = offset;
+    }
+
+    return table;
+}
+
+TablePtr contributionTable(int srcLength, int dstLength, double blur, Blitz::ScaleFilterType filter)
+{
+    static QMutex cacheMutex;
+    static QCache<QString,TablePtr> cache(tableCacheSize);
+
+    const QString key = QStringLiteral("%1:%2:%3:%4").arg(srcLength).arg(dstLength).arg(blur)
+                        .arg(static_cast<int>(filter));
+    {
+        const QMutexLocker locker(&cacheMutex);
+        if (const TablePtr* table = cache.object(key))
+            return *table;
+    }
+
+    TablePtr table = buildTable(srcLength,dstLength,blur,filter);
+
+    const QMutexLocker locker(&cacheMutex);
+    cache.insert(key,new TablePtr(table));
+    return table;
+}
+
+inline QRgb packPixel(const int* acc)
+{
+    std::array<int,4> res {};
+    for (int c = 0; c < 4; ++c)
+        res.at(c) = qBound(0,(acc[c] + weightRound) >> weightBits,255);
+    return static_cast<QRgb>(res[0] | (res[1] << 8) | (res[2] << 16) | (res[3] << 24));
+}
+
+void horizontalRowScalar(const QRgb* src, QRgb* dst, int dstWidth, const ContributionTable& table)
+{
+    for (int x = 0; x < dstWidth; ++x) {
+        const qint16* w = table.weights.data() + table.offset[x];
+        const QRgb* s = src + table.start[x];
+        std::array<int,4> acc {};
+        for (int k = 0; k < table.count[x]; ++k) {
+            for (int c = 0; c < 4; ++c)
+                acc.at(c) += static_cast<int>((s[k] >> (c*8)) & 0xff) * w[k];
+        }
+        dst[x] = packPixel(acc.data());
+    }
+}
+
+void verticalRowScalar(const QRgb* const* rows, const qint16* w, int count, QRgb* dst, int from, int width)
+{
+    for (int x = from; x < width; ++x) {
+        std::array<int,4> acc {};
+        for (int k = 0; k < count; ++k) {
+            const QRgb px = rows[k][x];
+            for (int c = 0; c < 4; ++c)
+                acc.at(c) += static_cast<int>((px >> (c*8)) & 0xff) * w[k];
+        }
+        dst[x] = packPixel(acc.data());
+    }
+}
+
+#ifdef BLITZ_X86_SIMD
+
+inline int weightPair(qint16 w0, qint16 w1)
+{
+    return static_cast<int>(static_cast<quint16>(w0) | (static_cast<quint32>(static_cast<quint16>(w1)) << 16));
+}
+
+void horizontalRowSSE2(const QRgb* src, QRgb* dst, int dstWidth, const ContributionTable& table)
+{
+    const __m128i zero = _mm_setzero_si128();
+    const __m128i round = _mm_set1_epi32(weightRound);
+    for (int x = 0; x < dstWidth; ++x) {
+        const qint16* w = table.weights.data() + table.offset[x];
+        const QRgb* s = src + table.start[x];
+        const int count = table.count[x];
+        __m128i acc = zero;
+        int k = 0;
+        for (; k + 1 < count; k += 2) {
+            __m128i px = _mm_loadl_epi64(reinterpret_cast<const __m128i*>(s + k));
+            px = _mm_unpacklo_epi8(px, zero);
+            px = _mm_unpacklo_epi16(px, _mm_srli_si128(px, 8));
+            acc = _mm_add_epi32(acc, _mm_madd_epi16(px, _mm_set1_epi32(weightPair(w[k],w[k+1]))));
+        }
+        if (k < count) {
+            __m128i px = _mm_cvtsi32_si128(static_cast<int>(s[k]));
+            px = _mm_unpacklo_epi16(_mm_unpacklo_epi8(px, zero), zero);
+            acc = _mm_add_epi32(acc, _mm_madd_epi16(px, _mm_set1_epi32(weightPair(w[k],0))));
+        }
+        acc = _mm_srai_epi32(_mm_add_epi32(acc, round), weightBits);
+        acc = _mm_packs_epi32(acc, acc);
+        acc = _mm_packus_epi16(acc, acc);
+        dst[x] = static_cast<QRgb>(_mm_cvtsi128_si32(acc));
+    }
+}
+
+int verticalRowSSE2(const QRgb* const* rows, const qint16* w, int count, QRgb* dst, int width)
+{
+    const __m128i zero = _mm_setzero_si128();
+    const __m128i round = _mm_set1_epi32(weightRound);
+    int x = 0;
+    for (; x + 4 <= width; x += 4) {
+        __m128i acc0 = zero;
+        __m128i acc1 = zero;
+        __m128i acc2 = zero;
+        __m128i acc3 = zero;
+        for (int k = 0; k < count; k += 2) {
+            const bool pair = (k + 1 < count);
+            const __m128i a = _mm_loadu_si128(reinterpret_cast<const __m128i*>(rows[k] + x));
+            const __m128i b = pair ? _mm_loadu_si128(reinterpret_cast<const __m128i*>(rows[k+1] + x)) : zero;
+            const __m128i wv = _mm_set1_epi32(weightPair(w[k], pair ? w[k+1] : 0));
+            const __m128i alo = _mm_unpacklo_epi8(a, zero);
+            const __m128i ahi = _mm_unpackhi_epi8(a, zero);
+            const __m128i blo = _mm_unpacklo_epi8(b, zero);
+            const __m128i bhi = _mm_unpackhi_epi8(b, zero);
+            acc0 = _mm_add_epi32(acc0, _mm_madd_epi16(_mm_unpacklo_epi16(alo, blo), wv));
+            acc1 = _mm_add_epi32(acc1, _mm_madd_epi16(_mm_unpackhi_epi16(alo, blo), wv));
+            acc2 = _mm_add_epi32(acc2, _mm_madd_epi16(_mm_unpacklo_epi16(ahi, bhi), wv));
+            acc3 = _mm_add_epi32(acc3, _mm_madd_epi16(_mm_unpackhi_epi16(ahi, bhi), wv));
+        }
+        acc0 = _mm_srai_epi32(_mm_add_epi32(acc0, round), weightBits);
+        acc1 = _mm_srai_epi32(_mm_add_epi32(acc1, round), weightBits);
+        acc2 = _mm_srai_epi32(_mm_add_epi32(acc2, round), weightBits);
+        acc3 = _mm_srai_epi32(_mm_add_epi32(acc3, round), weightBits);
+        const __m128i res = _mm_packus_epi16(_mm_packs_epi32(acc0, acc1), _mm_packs_epi32(acc2, acc3));
+        _mm_storeu_si128(reinterpret_cast<__m128i*>(dst + x), res);
+    }
+    return x;
+}
+
+__attribute__((target("avx2")))
+int verticalRowAVX2(const QRgb* const* rows, const qint16* w, int count, QRgb* dst, int width)
+{
+    // Unpack and pack instructions work inside 128-bit lanes, so pixel order is restored by packing
+    const __m256i zero = _mm256_setzero_si256();
+    const __m256i round = _mm256_set1_epi32(weightRound);
+    int x = 0;
+    for (; x + 8 <= width; x += 8) {
+        __m256i acc0 = zero;
+        __m256i acc1 = zero;
+        __m256i acc2 = zero;
+        __m256i acc3 = zero;
+        for (int k = 0; k < count; k += 2) {
+            const bool pair = (k + 1 < count);
+            const __m256i a = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(rows[k] + x));
+            const __m256i b = pair ? _mm256_loadu_si256(reinterpret_cast<const __m256i*>(rows[k+1] + x)) : zero;
+            const __m256i wv = _mm256_set1_epi32(weightPair(w[k], pair ? w[k+1] : 0));
+            const __m256i alo = _mm256_unpacklo_epi8(a, zero);
+            const __m256i ahi = _mm256_unpackhi_epi8(a, zero);
+            const __m256i blo = _mm256_unpacklo_epi8(b, zero);
+            const __m256i bhi = _mm256_unpackhi_epi8(b, zero);
+            acc0 = _mm256_add_epi32(acc0, _mm256_madd_epi16(_mm256_unpacklo_epi16(alo, blo), wv));
+            acc1 = _mm256_add_epi32(acc1, _mm256_madd_epi16(_mm256_unpackhi_epi16(alo, blo), wv));
+            acc2 = _mm256_add_epi32(acc2, _mm256_madd_epi16(_mm256_unpacklo_epi16(ahi, bhi), wv));
+            acc3 = _mm256_add_epi32(acc3, _mm256_madd_epi16(_mm256_unpackhi_epi16(ahi, bhi), wv));
+        }
+        acc0 = _mm256_srai_epi32(_mm256_add_epi32(acc0, round), weightBits);
+        acc1 = _mm256_srai_epi32(_mm256_add_epi32(acc1, round), weightBits);
+        acc2 = _mm256_srai_epi32(_mm256_add_epi32(acc2, round), weightBits);
+        acc3 = _mm256_srai_epi32(_mm256_add_epi32(acc3, round), weightBits);
+        const __m256i res = _mm256_packus_epi16(_mm256_packs_epi32(acc0, acc1), _mm256_packs_epi32(acc2, acc3));
+        _mm256_storeu_si256(reinterpret_cast<__m256i*>(dst + x), res);
+    }
+    return x;
+}
+
+#endif // BLITZ_X86_SIMD
+
+void horizontalRow(const QRgb* src, QRgb* dst, int dstWidth, const ContributionTable& table)
+{
+#ifdef BLITZ_X86_SIMD
+    if (simdLevel() != SimdLevel::Scalar) {
+        horizontalRowSSE2(src,dst,dstWidth,table);
+        return;
+    }
+#endif
+    horizontalRowScalar(src,dst,dstWidth,table);
+}
+
+void verticalRow(const QRgb* const* rows, const qint16* w, int count, QRgb* dst, int width)
+{
+    int done = 0;
+#ifdef BLITZ_X86_SIMD
+    switch (simdLevel()) {
+        case SimdLevel::AVX2:
+            done = verticalRowAVX2(rows,w,count,dst,width);
+            break;
+        case SimdLevel::SSE2:
+            done = verticalRowSSE2(rows,w,count,dst,width);
+            break;
+        case SimdLevel::Scalar:
+            break;
+    }
+#endif
+    verticalRowScalar(rows,w,count,dst,done,width);
+}
+
+bool isCancelled(int page, const int *currentPage)
+{
+    return (currentPage!=nullptr && *currentPage!=page);
+}
+
+bool processBands(int rowCount, int page, const int *currentPage,
+                  const std::function<void(int first, int last)>& func)
+{
+    std::vector<int> bands((rowCount + bandHeight - 1) / bandHeight);
+    std::iota(bands.begin(),bands.end(),0);
+    QAtomicInteger<bool> cancelled(false);
+
+    std::for_each(std::execution::par,bands.cbegin(),bands.cend(),[&](int band){
+        if (cancelled.loadAcquire()) return;
+        if (isCancelled(page,currentPage)) {
+            cancelled.storeRelease(true);
+            return;
+        }
+        func(band * bandHeight, qMin(rowCount, (band + 1) * bandHeight));
+    });
+
+    return !cancelled.loadAcquire();
+}
+
+bool horizontalPass(const QImage& src, QImage& dst, double blur, Blitz::ScaleFilterType filter,
+                    int page, const int *currentPage)
+{
+    const TablePtr table = contributionTable(src.width(),dst.width(),blur,filter);
+    return processBands(dst.height(),page,currentPage,[&src,&dst,&table](int first, int last){
+        for (int y = first; y < last; ++y) {
+            horizontalRow(reinterpret_cast<const QRgb*>(src.constScanLine(y)),
+                          reinterpret_cast<QRgb*>(dst.scanLine(y)),dst.width(),*table);
+        }
+    });
+}
+
+bool verticalPass(const QImage& src, QImage& dst, double blur, Blitz::ScaleFilterType filter,
+                  int page, const int *currentPage)
+{
+    const TablePtr table = contributionTable(src.height(),dst.height(),blur,filter);
+    return processBands(dst.height(),page,currentPage,[&src,&dst,&table](int first, int last){
+        std::vector<const QRgb*> rows;
+        for (int y = first; y < last; ++y) {
+            const int count = table->count[y];
+            rows.resize(count);
+            for (int k = 0; k < count; ++k)
+                rows[k] = reinterpret_cast<const QRgb*>(src.constScanLine(table->start[y] + k));
+            verticalRow(rows.data(),table->weights.data() + table->offset[y],count,
+                        reinterpret_cast<QRgb*>(dst.scanLine(y)),dst.width());
+        }
+    });
+}
+
+}
+
+QImage Blitz::fastScaleFilter(const QImage &img, const QSize &sz,
+                              double blur, ScaleFilterType filter,
+                              Qt::AspectRatioMode aspectRatio,
+                              int page, const int *currentPage)
+{
+    using namespace BlitzFastScale;
+
+    QSize destSize(img.size());
+    destSize.scale(sz, aspectRatio);
+    if(img.isNull() || !destSize.isValid() || destSize.isEmpty())
+        return(img);
+    const int dw = destSize.width();
+    const int dh = destSize.height();
+
+    QImage imgc = img;
+    if(imgc.depth() != 32){
+        imgc = imgc.convertToFormat(imgc.hasAlphaChannel() ?
+                                      QImage::Format_ARGB32 :
+                                      QImage::Format_RGB32);
+    }
+    else if(imgc.format() == QImage::Format_ARGB32_Premultiplied)
+        imgc = imgc.convertToFormat(QImage::Format_ARGB32);
+
+    const QImage::Format format = imgc.hasAlphaChannel() ? QImage::Format_ARGB32 : QImage::Format_RGB32;
+
+    ScaleFilterType m_filter = filter;
+    if(m_filter == UndefinedFilter) {
+        if((dw == imgc.width()) && (dh == imgc.height())) {
+            m_filter = PointFilter;
+        } else {
+            m_filter = MitchellFilter;
+        }
+    }
+
+    // Same pass ordering heuristic as in smoothScaleFilter, skip pass for unchanged dimension
+    const bool horizontalFirst = ((dw*(imgc.height()+dh)) > (dh*(imgc.width()+dw)));
+    QImage tmp;
+    QImage buffer;
+    if (horizontalFirst) {
+        if (dw != imgc.width()) {
+            tmp = QImage(dw, imgc.height(), format);
+            if (!horizontalPass(imgc, tmp, blur, m_filter, page, currentPage))
+                return QImage();
+        } else {
+            tmp = imgc;
+        }
+        if (dh != tmp.height()) {
+            buffer = QImage(dw, dh, format);
+            if (!verticalPass(tmp, buffer, blur, m_filter, page, currentPage))
+                return QImage();
+        } else {
+            buffer = tmp;
+        }
+    } else {
+        if (dh != imgc.height()) {
+            tmp = QImage(imgc.width(), dh, format);
+            if (!verticalPass(imgc, tmp, blur, m_filter, page, currentPage))
+                return QImage();
+        } else {
+            tmp = imgc;
+        }
+        if (dw != tmp.width()) {
+            buffer = QImage(dw, dh, format);
+            if (!horizontalPass(tmp, buffer, blur, m_filter, page, currentPage))
+                return QImage();
+        } else {
+            buffer = tmp;
+        }
+    }
+
+    if (buffer.format() != format)
+        buffer = buffer.convertToFormat(format);
+
+    return(buffer);
+}
@@ -637,6 +637,36 @@ bool BlitzScaleFilter::verticalFilter(const QImage *srcImg,
     return(true);
 }
 
+double Blitz::filterWeight(ScaleFilterType filter, double x)
+{
+    const double fSupport = filterSupport.at(filter);
+    switch(filter){
+        case Blitz::TriangleFilter: return Triangle(x,fSupport);
+        case Blitz::HermiteFilter: return Hermite(x,fSupport);
+        case Blitz::HanningFilter: return Hanning(x,fSupport);
+        case Blitz::HammingFilter: return Hamming(x,fSupport);
+        case Blitz::BlackmanFilter: return Blackman(x,fSupport);
+        case Blitz::GaussianFilter: return Gaussian(x,fSupport);
+        case Blitz::QuadraticFilter: return Quadratic(x,fSupport);
+        case Blitz::CubicFilter: return Cubic(x,fSupport);
+        case Blitz::CatromFilter: return Catrom(x,fSupport);
+        case Blitz::MitchellFilter: return Mitchell(x,fSupport);
+        case Blitz::LanczosFilter: return Lanczos(x,fSupport);
+        case Blitz::BesselFilter: return BlackmanBessel(x,fSupport);
+        case Blitz::SincFilter: return BlackmanSinc(x,fSupport);
+        case Blitz::UndefinedFilter:
+        case Blitz::PointFilter:
+        case Blitz::BoxFilter:
+        default:
+            return Box(x,fSupport);
+    }
+}
+
+double Blitz::filterSupportSize(ScaleFilterType filter)
+{
+    return filterSupport.at(filter);
+}
+
 QImage Blitz::smoothScaleFilter(const QImage &img, int w, int h,
                                 double blur, ScaleFilterType filter,
                                 Qt::AspectRatioMode aspectRatio,
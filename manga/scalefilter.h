@@ -94,6 +94,20 @@ public:
                                     Qt::AspectRatioMode aspectRatio =
             Qt::IgnoreAspectRatio, int page = -1, const int *currentPage = nullptr);
 
+    /**
+ * Same filters as smoothScaleFilter, but with fixed-point contribution tables
+ * cached per (source size, target size, filter), row-major processing in
+ * bands, SSE2/AVX2 kernels selected at runtime and parallel execution.
+ */
+    static QImage fastScaleFilter(const QImage &img, const QSize &sz,
+                                  double blur=1.0,
+                                  ScaleFilterType filter=BlackmanFilter,
+                                  Qt::AspectRatioMode aspectRatio =
+            Qt::IgnoreAspectRatio, int page = -1, const int *currentPage = nullptr);
+
+    static double filterWeight(ScaleFilterType filter, double x);
+    static double filterSupportSize(ScaleFilterType filter);
+
 
 
 };
@@ -16,8 +16,11 @@
 #include <QProgressDialog>
 #include <QThreadPool>
 #include <QElapsedTimer>
+#include <QtMath>
 #include <QComboBox>
 #include <QUuid>
+#include <QBuffer>
+#include <QImageReader>
 
 #include "zmangaview.h"
 #include "utils/genericfuncs.h"
@@ -32,8 +35,14 @@
 namespace CDefaults {
 const int errorPageLoadMsgVerticalMargin = 5;
 const double dynamicZoomUpScale = 3.0;
+const qint64 mangaMagnifierMaxPixels = 64L * 1024L * 1024L;
+const int mangaPreviewMaxShift = 3; // JPEG DCT scaling goes down to 1/8
+const int mangaTileFilterMargin = 4;
+const int mangaTileVisiblePriority = 1;
+const int mangaTilePrefetchPriority = 0;
 const auto propertyMangaPageNum = "PAGENUM";
 const auto propertyMangaBytesReceived = "RECEIVEDSIZE";
+const auto propertyMangaFetchGeneration = "FETCHGEN";
 }
 
 ZMangaView::ZMangaView(QWidget *parent) :
@@ -45,8 +54,12 @@ ZMangaView::ZMangaView(QWidget *parent) :
     p.setBrush(QPalette::Dark,QBrush(QColor(Qt::black)));
     setPalette(p);
 
-    connect(this, &ZMangaView::requestRedrawPageEx, this, &ZMangaView::redrawPageEx, Qt::QueuedConnection);
-    connect(gSet->settings(), &CSettings::mangaViewerSettingsUpdated, this, &ZMangaView::redrawPage, Qt::QueuedConnection);
+    connect(gSet->settings(), &CSettings::mangaViewerSettingsUpdated, this, [this](){
+        // filters and blur settings are not part of tile key
+        m_tileCache.clear();
+        m_tileGeneration++;
+        redrawPage();
+    }, Qt::QueuedConnection);
 }
 
 ZMangaView::~ZMangaView()
@@ -71,6 +84,8 @@ int ZMangaView::getPageCount() const
 void ZMangaView::getPage(int num)
 {
     if (!m_scroller) return;
+    if (num != m_currentPage)
+        m_readingDirection = (num > m_currentPage) ? 1 : -1;
     m_currentPage = num;
 
     if (m_scroller->verticalScrollBar()->isVisible())
@@ -79,9 +94,10 @@ void ZMangaView::getPage(int num)
         m_scroller->horizontalScrollBar()->setValue(0);
 
     cacheDropUnusable();
-    if (m_iCacheImages.contains(m_currentPage))
+    if (m_pageCache.contains(m_currentPage))
         displayCurrentPage();
     cacheFillNearest();
+    fetchNextPages();
 }
 
 int ZMangaView::getCurrentPage() const
@@ -97,14 +113,26 @@ void ZMangaView::setScroller(QScrollArea *scroller)
 void ZMangaView::displayCurrentPage()
 {
     QImage p;
+    m_curNativeSize = QSize();
 
-    if (m_iCacheImages.contains(m_currentPage)) {
-        p = m_iCacheImages.value(m_currentPage);
+    if (m_pageCache.contains(m_currentPage)) {
+        p = m_pageCache.image(m_currentPage);
+        m_curNativeSize = m_pageCache.nativeSize(m_currentPage);
+        if ((m_rotation % 2) != 0)
+            m_curNativeSize.transpose();
 
         if (m_rotation!=0) {
-            QTransform mr;
-            mr.rotateRadians(m_rotation*M_PI_2);
-            p = p.transformed(mr,Qt::SmoothTransformation);
+            if (m_rotatedPage.page != m_currentPage || m_rotatedPage.rotation != m_rotation
+                    || m_rotatedPage.sourceKey != p.cacheKey()) {
+                // Right angle rotation only remaps pixels, smooth transform gives nothing here
+                QTransform mr;
+                mr.rotate(m_rotation*90.0);
+                m_rotatedPage.page = m_currentPage;
+                m_rotatedPage.rotation = m_rotation;
+                m_rotatedPage.sourceKey = p.cacheKey();
+                m_rotatedPage.image = p.transformed(mr,Qt::FastTransformation);
+            }
+            p = m_rotatedPage.image;
         }
     }
 
@@ -117,10 +145,19 @@ void ZMangaView::displayCurrentPage()
 void ZMangaView::closeManga()
 {
     if (m_cleanup) return;
-    m_curPixmap = QImage();
+    m_curPageSize = QSize();
     m_openedManga.clear();
+    m_rotatedPage = RotatedPage();
+    m_magnifierLevel = QImage();
+    m_magnifierSourceKey = 0L;
+    m_pageCache.clear();
+    m_tileCache.clear();
+    m_tileGeneration++;
+    m_cacheGeneration++;
     m_pageData.clear();
     m_processingPages.clear();
+    m_fetchQueue.clear();
+    m_networkLoadersActive = 0;
     m_pageCount = 0;
     m_networkLoadedTotal = 0L;
     update();
@@ -187,69 +224,25 @@ QImage ZMangaView::resizeImage(const QImage& src, const QSize& targetSize, bool
     if (rf==Blitz::Bilinear)
         return src.scaled(targetSize,Qt::IgnoreAspectRatio,Qt::SmoothTransformation);
 
-    return Blitz::smoothScaleFilter(src,targetSize,gSet->settings()->mangaResizeBlur,
-                                    rf,Qt::KeepAspectRatio,page,currentPage);
+    return Blitz::fastScaleFilter(src,targetSize,gSet->settings()->mangaResizeBlur,
+                                  rf,Qt::KeepAspectRatio,page,currentPage);
 }
 
 void ZMangaView::paintEvent(QPaintEvent *event)
 {
-    Q_UNUSED(event)
     if (!m_scroller) return;
 
     QPainter w(this);
-    if (!m_curPixmap.isNull()) {
-        int x=0;
-        int y=0;
-        if (m_curPixmap.width() < m_scroller->viewport()->width())
-            x = (m_scroller->viewport()->width() - m_curPixmap.width()) / 2;
-        if (m_curPixmap.height() < m_scroller->viewport()->height())
-            y = (m_scroller->viewport()->height() - m_curPixmap.height()) / 2;
-        w.drawImage(x,y,m_curPixmap);
-
-        if (m_zoomDynamic) {
-            QPoint mp(m_zoomPos.x()-x,m_zoomPos.y()-y);
-            QRect baseRect = m_curPixmap.rect();
-            if (baseRect.contains(mp,true)) {
-                mp.setX(mp.x()*m_curUnscaledPixmap.width()/m_curPixmap.width());
-                mp.setY(mp.y()*m_curUnscaledPixmap.height()/m_curPixmap.height());
-                int msz = gSet->settings()->mangaMagnifySize;
-
-                if (m_curPixmap.width()<m_curUnscaledPixmap.width() || m_curPixmap.height()<m_curUnscaledPixmap.height()) {
-                    QRect cutBox(mp.x()-msz/2,mp.y()-msz/2,msz,msz);
-                    baseRect = m_curUnscaledPixmap.rect();
-                    if (cutBox.left()<baseRect.left()) cutBox.moveLeft(baseRect.left());
-                    if (cutBox.right()>baseRect.right()) cutBox.moveRight(baseRect.right());
-                    if (cutBox.top()<baseRect.top()) cutBox.moveTop(baseRect.top());
-                    if (cutBox.bottom()>baseRect.bottom()) cutBox.moveBottom(baseRect.bottom());
-                    QImage zoomed = m_curUnscaledPixmap.copy(cutBox);
-                    baseRect = QRect(QPoint(m_zoomPos.x()-zoomed.width()/2,m_zoomPos.y()-zoomed.height()/2),
-                                     zoomed.size());
-                    if (baseRect.left()<0) baseRect.moveLeft(0);
-                    if (baseRect.right()>width()) baseRect.moveRight(width());
-                    if (baseRect.top()<0) baseRect.moveTop(0);
-                    if (baseRect.bottom()>height()) baseRect.moveBottom(height());
-                    w.drawImage(baseRect,zoomed);
-                } else {
-                    QRect cutBox(mp.x()-msz/4,mp.y()-msz/4,msz/2,msz/2);
-                    baseRect = m_curUnscaledPixmap.rect();
-                    if (cutBox.left()<baseRect.left()) cutBox.moveLeft(baseRect.left());
-                    if (cutBox.right()>baseRect.right()) cutBox.moveRight(baseRect.right());
-                    if (cutBox.top()<baseRect.top()) cutBox.moveTop(baseRect.top());
-                    if (cutBox.bottom()>baseRect.bottom()) cutBox.moveBottom(baseRect.bottom());
-                    QImage zoomed = m_curUnscaledPixmap.copy(cutBox);
-                    zoomed = ZMangaView::resizeImage(zoomed,zoomed.size()*CDefaults::dynamicZoomUpScale,
-                                                     true,gSet->settings()->mangaUpscaleFilter);
-                    baseRect = QRect(QPoint(m_zoomPos.x()-zoomed.width()/2,m_zoomPos.y()-zoomed.height()/2),
-                                     zoomed.size());
-                    if (baseRect.left()<0) baseRect.moveLeft(0);
-                    if (baseRect.right()>width()) baseRect.moveRight(width());
-                    if (baseRect.top()<0) baseRect.moveTop(0);
-                    if (baseRect.bottom()>height()) baseRect.moveBottom(height());
-                    w.drawImage(baseRect,zoomed);
-                }
-            }
-
+    if (m_curPageSize.isValid() && !m_curUnscaledPixmap.isNull()) {
+        const QPoint offset = pageOffset();
+        if (m_curPageSize == m_curUnscaledPixmap.size()) {
+            w.drawImage(offset,m_curUnscaledPixmap);
+        } else {
+            paintTiles(w,event->rect(),offset);
         }
+
+        if (m_zoomDynamic)
+            paintMagnifier(w,offset);
     } else {
         if (m_curUnscaledPixmap.isNull()) {
             const int preferredIconSize = 32;
@@ -268,8 +261,12 @@ void ZMangaView::mouseMoveEvent(QMouseEvent *event)
     if (event->buttons() == Qt::NoButton) {
         if ((QApplication::keyboardModifiers() & Qt::ControlModifier) == 0) {
             if (m_zoomDynamic) {
+                // repaint only areas covered by old and new lens, clamped lens never leaves this box
+                const int radius = qCeil(gSet->settings()->mangaMagnifySize * CDefaults::dynamicZoomUpScale / 2.0);
+                const QPoint lensBox(radius,radius);
+                update(QRect(m_zoomPos - lensBox,m_zoomPos + lensBox));
                 m_zoomPos = event->pos();
-                update();
+                update(QRect(m_zoomPos - lensBox,m_zoomPos + lensBox));
             } else
                 m_zoomPos = QPoint();
         }
@@ -317,34 +314,29 @@ void ZMangaView::keyPressEvent(QKeyEvent *event)
 }
 
 void ZMangaView::redrawPage()
-{
-    redrawPageEx(QImage(),m_currentPage);
-}
-
-void ZMangaView::redrawPageEx(const QImage& scaled, int page)
 {
     if (m_cleanup) return;
     if (!m_scroller) return;
-    if (!scaled.isNull() && page!=m_currentPage) return;
 
     QPalette p = palette();
     p.setBrush(QPalette::Dark,QBrush(gSet->settings()->mangaBackgroundColor));
     setPalette(p);
 
     if (m_openedManga.isEmpty()) return;
-    if (page<0 || page>=m_pageCount) return;
+    if (m_currentPage<0 || m_currentPage>=m_pageCount) return;
 
     // Draw current page
-    m_curPixmap = QImage();
+    m_curPageSize = QSize();
 
     if (!m_curUnscaledPixmap.isNull()) {
+        // Layout uses native page size, cached image may be a reduced preview
+        const QSize nativeSize = m_curNativeSize.isValid() ? m_curNativeSize : m_curUnscaledPixmap.size();
         QSize scrollerSize = m_scroller->viewport()->size() - QSize(4,4);
-        QSize targetSize = m_curUnscaledPixmap.size();
+        QSize targetSize = nativeSize;
 
-        m_curPixmap = m_curUnscaledPixmap;
-        if (!m_curUnscaledPixmap.isNull() && m_curUnscaledPixmap.height()>0) {
-            double pixAspect = static_cast<double>(m_curUnscaledPixmap.width()) /
-                               static_cast<double>(m_curUnscaledPixmap.height());
+        if (nativeSize.height()>0) {
+            double pixAspect = static_cast<double>(nativeSize.width()) /
+                               static_cast<double>(nativeSize.height());
             double myAspect = static_cast<double>(width()) /
                               static_cast<double>(height());
 
@@ -368,47 +360,48 @@ void ZMangaView::redrawPageEx(const QImage& scaled, int page)
                     break;
                 case zmOriginal:
                     if (m_zoomAny>0)
-                        targetSize = m_curUnscaledPixmap.size()*(static_cast<double>(m_zoomAny)/100.0);
+                        targetSize = nativeSize*(static_cast<double>(m_zoomAny)/100.0);
                     break;
             }
+        }
+        if (targetSize.isEmpty())
+            targetSize = nativeSize;
+        m_curPageSize = targetSize;
+
+        const QSize imageSize = m_curUnscaledPixmap.size();
+        if (imageSize != nativeSize &&
+                (targetSize.width()>imageSize.width() || targetSize.height()>imageSize.height()
+                 || m_zoomDynamic)) {
+            cacheGetFullPage(m_currentPage);
+        }
 
-            if (targetSize!=m_curUnscaledPixmap.size()) {
-                if (!scaled.isNull()) {
-                    m_curPixmap = scaled;
-                } else {
-                    // fast inplace resampling
-                    m_curPixmap = m_curUnscaledPixmap.scaled(targetSize,Qt::IgnoreAspectRatio,
-                                                   Qt::FastTransformation);
-
-                    if (gSet->settings()->mangaUseFineRendering) {
-                        Blitz::ScaleFilterType filter = Blitz::UndefinedFilter;
-                        if (targetSize.width()>m_curUnscaledPixmap.width()) {
-                            filter = gSet->settings()->mangaUpscaleFilter;
-                        } else {
-                            filter = gSet->settings()->mangaDownscaleFilter;
-                        }
-
-                        if (filter!=Blitz::UndefinedFilter) {
-                            QImage image = m_curUnscaledPixmap;
-                            m_mangaThreadPool.start([this,targetSize,filter,image,page](){
-                                QElapsedTimer timer;
-                                timer.start();
-
-                                QImage res = ZMangaView::resizeImage(image,targetSize,true,filter,
-                                                                     page,&m_currentPage);
-
-                                if (!res.isNull()) {
-                                    qint64 elapsed = timer.elapsed();
-                                    Q_EMIT requestRedrawPageEx(res, page);
-                                    gSet->ui()->addMangaFineRenderTime(elapsed);
-                                }
-                            });
-                        }
-                    }
-                }
+        // Scaled page is painted by tiles, fast resampled preview is used until fine tile is ready
+        Blitz::ScaleFilterType filter = Blitz::UndefinedFilter;
+        if (gSet->settings()->mangaUseFineRendering && targetSize!=m_curUnscaledPixmap.size()) {
+            if (targetSize.width()>m_curUnscaledPixmap.width()) {
+                filter = gSet->settings()->mangaUpscaleFilter;
+            } else {
+                filter = gSet->settings()->mangaDownscaleFilter;
             }
         }
-        setMinimumSize(m_curPixmap.width(),m_curPixmap.height());
+
+        ZTileKey params;
+        params.page = m_currentPage;
+        params.rotation = m_rotation;
+        params.filter = static_cast<int>(filter);
+        params.sourceKey = m_curUnscaledPixmap.cacheKey();
+        params.pageSize = targetSize;
+        if (!(params == m_tileParams)) {
+            // drop queued jobs for previous zoom
+            m_tileParams = params;
+            m_tileGeneration++;
+            m_tileCache.clearPending();
+        }
+
+        if (m_zoomDynamic)
+            updateMagnifierLevel();
+
+        setMinimumSize(targetSize);
 
         if (targetSize.height()<scrollerSize.height()) targetSize.setHeight(scrollerSize.height());
         if (targetSize.width()<scrollerSize.width()) targetSize.setWidth(scrollerSize.width());
@@ -417,6 +410,219 @@ void ZMangaView::redrawPageEx(const QImage& scaled, int page)
     update();
 }
 
+void ZMangaView::updateMagnifierLevel()
+{
+    // Upscaled lens is served from whole page prepared once, small pages only
+    if (m_curUnscaledPixmap.isNull()
+            || m_curPageSize.width()<m_curUnscaledPixmap.width()
+            || m_curPageSize.height()<m_curUnscaledPixmap.height()) {
+        return;
+    }
+
+    const qint64 sourceKey = m_curUnscaledPixmap.cacheKey();
+    if (sourceKey == m_magnifierSourceKey || sourceKey == m_magnifierPendingKey)
+        return;
+
+    const QSize levelSize = m_curUnscaledPixmap.size() * CDefaults::dynamicZoomUpScale;
+    if (static_cast<qint64>(levelSize.width()) * levelSize.height() > CDefaults::mangaMagnifierMaxPixels)
+        return;
+
+    m_magnifierPendingKey = sourceKey;
+    const QImage image = m_curUnscaledPixmap;
+    const Blitz::ScaleFilterType filter = gSet->settings()->mangaUpscaleFilter;
+    m_mangaThreadPool.start([this,image,levelSize,filter,sourceKey](){
+        const QImage level = ZMangaView::resizeImage(image,levelSize,true,filter);
+        QMetaObject::invokeMethod(this,[this,level,sourceKey](){
+            if (m_cleanup) return;
+            if (m_magnifierPendingKey == sourceKey)
+                m_magnifierPendingKey = 0L;
+            if (level.isNull() || sourceKey != m_curUnscaledPixmap.cacheKey()) return;
+            m_magnifierLevel = level;
+            m_magnifierSourceKey = sourceKey;
+            update();
+        },Qt::QueuedConnection);
+    });
+}
+
+void ZMangaView::paintMagnifier(QPainter &painter, const QPoint &offset)
+{
+    QPoint mp = m_zoomPos - offset;
+    if (!QRect(QPoint(0,0),m_curPageSize).contains(mp,true))
+        return;
+
+    mp.setX(mp.x()*m_curUnscaledPixmap.width()/m_curPageSize.width());
+    mp.setY(mp.y()*m_curUnscaledPixmap.height()/m_curPageSize.height());
+    const int msz = gSet->settings()->mangaMagnifySize;
+
+    // Downscaled page shows original pixels in lens, otherwise lens is upscaled from prepared level
+    const bool upscale = (m_curPageSize.width()>=m_curUnscaledPixmap.width()
+                          && m_curPageSize.height()>=m_curUnscaledPixmap.height());
+    QRect cutBox(mp.x()-msz/2,mp.y()-msz/2,msz,msz);
+    if (upscale)
+        cutBox = QRect(mp.x()-msz/4,mp.y()-msz/4,msz/2,msz/2);
+
+    const QRect imageRect = m_curUnscaledPixmap.rect();
+    if (cutBox.left()<imageRect.left()) cutBox.moveLeft(imageRect.left());
+    if (cutBox.right()>imageRect.right()) cutBox.moveRight(imageRect.right());
+    if (cutBox.top()<imageRect.top()) cutBox.moveTop(imageRect.top());
+    if (cutBox.bottom()>imageRect.bottom()) cutBox.moveBottom(imageRect.bottom());
+    cutBox = cutBox.intersected(imageRect);
+    if (cutBox.isEmpty())
+        return;
+
+    QSize lensSize = cutBox.size();
+    if (upscale)
+        lensSize = lensSize * CDefaults::dynamicZoomUpScale;
+
+    QRect baseRect(QPoint(m_zoomPos.x()-lensSize.width()/2,m_zoomPos.y()-lensSize.height()/2),lensSize);
+    if (baseRect.left()<0) baseRect.moveLeft(0);
+    if (baseRect.right()>width()) baseRect.moveRight(width());
+    if (baseRect.top()<0) baseRect.moveTop(0);
+    if (baseRect.bottom()>height()) baseRect.moveBottom(height());
+
+    if (upscale && m_magnifierSourceKey == m_curUnscaledPixmap.cacheKey() && !m_magnifierLevel.isNull()) {
+        const double scale = static_cast<double>(m_magnifierLevel.width()) / m_curUnscaledPixmap.width();
+        const QRectF levelRect(cutBox.x()*scale,cutBox.y()*scale,cutBox.width()*scale,cutBox.height()*scale);
+        painter.drawImage(QRectF(baseRect),m_magnifierLevel,levelRect);
+        return;
+    }
+
+    // Level is not ready yet (or page is too big for it) - use plain pixel replication
+    painter.drawImage(QRectF(baseRect),m_curUnscaledPixmap,QRectF(cutBox));
+}
+
+QPoint ZMangaView::pageOffset() const
+{
+    QPoint res(0,0);
+    if (!m_scroller) return res;
+
+    if (m_curPageSize.width() < m_scroller->viewport()->width())
+        res.setX((m_scroller->viewport()->width() - m_curPageSize.width()) / 2);
+    if (m_curPageSize.height() < m_scroller->viewport()->height())
+        res.setY((m_scroller->viewport()->height() - m_curPageSize.height()) / 2);
+    return res;
+}
+
+void ZMangaView::paintTiles(QPainter &painter, const QRect &exposed, const QPoint &offset)
+{
+    const QRect pageRect(QPoint(0,0),m_curPageSize);
+    const QRect visible = exposed.translated(-offset).intersected(pageRect);
+    if (visible.isEmpty()) return;
+
+    const int tileSize = CDefaults::mangaTileSize;
+    const int columns = (m_curPageSize.width() - 1) / tileSize + 1;
+    const int rows = (m_curPageSize.height() - 1) / tileSize + 1;
+    const int firstColumn = visible.left() / tileSize;
+    const int lastColumn = visible.right() / tileSize;
+    const int firstRow = visible.top() / tileSize;
+    const int lastRow = visible.bottom() / tileSize;
+    const double fx = static_cast<double>(m_curUnscaledPixmap.width()) / m_curPageSize.width();
+    const double fy = static_cast<double>(m_curUnscaledPixmap.height()) / m_curPageSize.height();
+    const bool fineTiles = (m_tileParams.filter != static_cast<int>(Blitz::UndefinedFilter));
+
+    ZTileKey key = m_tileParams;
+    for (int row = firstRow; row <= lastRow; row++) {
+        for (int column = firstColumn; column <= lastColumn; column++) {
+            key.column = column;
+            key.row = row;
+            const QRect tileRect = key.rect();
+            const QImage tile = m_tileCache.tile(key);
+            if (!tile.isNull()) {
+                painter.drawImage(tileRect.topLeft() + offset,tile);
+                continue;
+            }
+
+            const QRectF source(tileRect.x() * fx, tileRect.y() * fy,
+                                tileRect.width() * fx, tileRect.height() * fy);
+            painter.drawImage(QRectF(tileRect.translated(offset)),m_curUnscaledPixmap,source);
+            if (fineTiles)
+                requestTile(key,CDefaults::mangaTileVisiblePriority);
+        }
+    }
+
+    if (!fineTiles) return;
+
+    // Prefetch neighbouring ring for scrolling
+    for (int row = firstRow - 1; row <= lastRow + 1; row++) {
+        for (int column = firstColumn - 1; column <= lastColumn + 1; column++) {
+            if (row < 0 || column < 0 || row >= rows || column >= columns)
+                continue;
+            if (row >= firstRow && row <= lastRow && column >= firstColumn && column <= lastColumn)
+                continue;
+            key.column = column;
+            key.row = row;
+            requestTile(key,CDefaults::mangaTilePrefetchPriority);
+        }
+    }
+}
+
+void ZMangaView::requestTile(const ZTileKey &key, int priority)
+{
+    if (m_tileCache.contains(key) || m_tileCache.isPending(key))
+        return;
+
+    m_tileCache.setPending(key,true);
+    const int generation = m_tileGeneration.loadAcquire();
+    const QImage image = m_curUnscaledPixmap;
+    m_mangaThreadPool.start([this,key,image,generation](){
+        if (generation != m_tileGeneration.loadAcquire()) return; // zoom or page changed
+
+        QElapsedTimer timer;
+        timer.start();
+
+        const QImage tile = ZMangaView::renderTile(image,key,&m_currentPage);
+        if (!tile.isNull())
+            gSet->ui()->addMangaFineRenderTime(timer.elapsed());
+
+        QMetaObject::invokeMethod(this,[this,key,tile,generation](){
+            tileRendered(key,tile,generation);
+        },Qt::QueuedConnection);
+    },priority);
+}
+
+void ZMangaView::tileRendered(const ZTileKey &key, const QImage &tile, int generation)
+{
+    if (m_cleanup) return;
+    if (generation != m_tileGeneration.loadAcquire()) return;
+
+    m_tileCache.insert(key,tile);
+    if (!tile.isNull())
+        update(key.rect().translated(pageOffset()));
+}
+
+QImage ZMangaView::renderTile(const QImage &src, const ZTileKey &key, const int *currentPage)
+{
+    const QRect tileRect = key.rect();
+    if (src.isNull() || tileRect.isEmpty())
+        return QImage();
+
+    const double fx = static_cast<double>(src.width()) / key.pageSize.width();
+    const double fy = static_cast<double>(src.height()) / key.pageSize.height();
+
+    // Filter kernel needs neighbour pixels, so slightly larger area is scaled and tile is cut from it
+    const int margin = qCeil(qMax(fx,fy) * CDefaults::mangaTileFilterMargin);
+    QRect srcRect(QPoint(qFloor(tileRect.left() * fx) - margin, qFloor(tileRect.top() * fy) - margin),
+                  QPoint(qCeil((tileRect.right() + 1) * fx) + margin - 1,
+                         qCeil((tileRect.bottom() + 1) * fy) + margin - 1));
+    srcRect = srcRect.intersected(src.rect());
+
+    const QPoint scaledOrigin(qRound(srcRect.left() / fx), qRound(srcRect.top() / fy));
+    const QSize scaledSize(qRound((srcRect.right() + 1) / fx) - scaledOrigin.x(),
+                           qRound((srcRect.bottom() + 1) / fy) - scaledOrigin.y());
+    if (scaledSize.isEmpty())
+        return QImage();
+
+    QImage scaled = ZMangaView::resizeImage(src.copy(srcRect),scaledSize,true,
+                                            static_cast<Blitz::ScaleFilterType>(key.filter),
+                                            key.page,currentPage);
+    if (scaled.isNull())
+        return QImage();
+    if (scaled.size() != scaledSize)
+        scaled = scaled.scaled(scaledSize,Qt::IgnoreAspectRatio,Qt::FastTransformation);
+
+    return scaled.copy(tileRect.translated(-scaledOrigin));
+}
+
 void ZMangaView::ownerResized(const QSize &size)
 {
     if (m_cleanup) return;
@@ -546,7 +752,12 @@ void ZMangaView::abortLoading()
 {
     if (m_cleanup) return;
     m_aborted = true;
+    m_networkLoadersActive -= m_fetchQueue.dropPending();
     Q_EMIT abortNetworkRequest();
+    if (m_fetchQueue.activeCount() == 0 && !m_finished && m_pageCount > 0) {
+        Q_EMIT loadingFinished();
+        m_finished = true;
+    }
 }
 
 void ZMangaView::setZoomDynamic(bool state)
@@ -603,17 +814,26 @@ void ZMangaView::viewRotateCW()
     Q_EMIT rotationUpdated(m_rotation*M_PI_2);
 }
 
-void ZMangaView::cacheGotPage(const QImage &pageImage, int num)
+void ZMangaView::cacheGotPage(const QImage &pageImage, int num, const QSize &nativeSize)
 {
     if (m_cleanup) return;
     if (m_processingPages.contains(num))
         m_processingPages.removeOne(num);
 
-    if (!pageImage.isNull() && m_iCacheImages.contains(num))
-        return;
+    // Full resolution image replaces preview, but never vice versa
+    if (!pageImage.isNull() && m_pageCache.contains(num)) {
+        if (!m_pageCache.isPreview(num))
+            return;
+        const QSize native = nativeSize.isValid() ? nativeSize : m_pageCache.nativeSize(num);
+        if (pageImage.size() != native)
+            return;
+    }
 
-    if (!pageImage.isNull())
-        m_iCacheImages[num]=pageImage;
+    if (!pageImage.isNull()) {
+        m_pageCache.insert(num,pageImage,nativeSize);
+        // Decoded size is known only now, so enforce budget after each insert
+        cacheSpillPages(m_pageCache.trim(cacheGetActivePages()));
+    }
 
     if (num==m_currentPage)
         displayCurrentPage();
@@ -621,31 +841,49 @@ void ZMangaView::cacheGotPage(const QImage &pageImage, int num)
 
 void ZMangaView::cacheDropUnusable()
 {
-    QList<int> toCache = cacheGetActivePages();
-    for (auto it = m_iCacheImages.keyBegin(), end = m_iCacheImages.keyEnd(); it != end; ++it) {
-        const int num = *it;
-        if (!toCache.contains(num))
-            m_iCacheImages.remove(num);
+    m_pageCache.setBudget(gSet->settings()->mangaCacheMemory * CDefaults::oneMB,
+                          gSet->settings()->mangaCacheSpillMemory * CDefaults::oneMB);
+    cacheSpillPages(m_pageCache.trim(cacheGetActivePages()));
+}
+
+void ZMangaView::cacheSpillPages(const QList<QPair<int, QImage> > &pages)
+{
+    // Evicted pages are compressed in background, restoring them is cheaper than full decode
+    const int generation = m_cacheGeneration;
+    for (const auto &page : pages) {
+        const int num = page.first;
+        const QImage image = page.second;
+        m_mangaThreadPool.start([this,num,image,generation](){
+            const ZPageCache::SpilledPage spilled = ZPageCache::compress(image);
+            QMetaObject::invokeMethod(this,[this,num,spilled,generation](){
+                if (m_cleanup || generation != m_cacheGeneration) return;
+                m_pageCache.insertSpilled(num,spilled);
+            },Qt::QueuedConnection);
+        });
     }
 }
 
 void ZMangaView::cacheFillNearest()
 {
-    QList<int> toCache = cacheGetActivePages();
-    int idx = 0;
-    while (idx<toCache.count()) {
-        if (m_iCacheImages.contains(toCache.at(idx))) {
-            toCache.removeAt(idx);
-        } else {
-            idx++;
-        }
-    }
+    const QList<int> toCache = cacheGetActivePages();
+    for (const int num : toCache) {
+        if (m_pageCache.contains(num) || m_processingPages.contains(num))
+            continue;
 
-    for (int i=0;i<toCache.count();i++) {
-        if (!m_processingPages.contains(toCache.at(i))) {
-            m_processingPages << toCache.at(i);
-            cacheGetPage(toCache.at(i));
+        // Pages still being fetched are decoded on arrival
+        bool loaded = false;
+        {
+            QMutexLocker locker(&m_pageDataLock);
+            loaded = (num < m_pageData.count()) && !m_pageData.at(num).second.isEmpty();
         }
+        if (!loaded) {
+            if (num == m_currentPage)
+                displayCurrentPage();
+            continue;
+        }
+
+        m_processingPages << num;
+        cacheGetPage(num,decodeSizeHint());
     }
 }
 
@@ -669,30 +907,60 @@ QList<int> ZMangaView::cacheGetActivePages() const
         }
     }
 
-    l.append(m_currentPage); // load current page at first
-
-    for (int i=0;i<cacheRadius;i++) {
-        // first pages, then last pages
-        const QList<int> pageNums ({ i, m_pageCount-i-1 });
-        for (const auto& num : pageNums) {
-            if (!l.contains(num) && (num>=0) && (num<m_pageCount))
-                l.append(num);
-        }
+    // Pages are ordered by importance and taken while estimated decoded size fits the budget.
+    // Current page and the nearest page in reading direction are always taken.
+    const qint64 budget = m_pageCache.budget();
+    qint64 estimated = 0L;
+    auto addPage = [this,&l,&estimated,budget](int num, bool force) -> bool {
+        if (num<0 || num>=m_pageCount || l.contains(num))
+            return true;
+        const qint64 size = m_pageCache.pageBytes(num);
+        if (!force && l.count()>1 && estimated + size > budget)
+            return false;
+        estimated += size;
+        l.append(num);
+        return true;
+    };
+
+    addPage(m_currentPage,true); // load current page at first
+    addPage(m_currentPage + m_readingDirection,true);
+
+    // read-ahead window, then pages behind, then first and last pages
+    bool fits = true;
+    for (int i=2;fits && i<=gSet->settings()->mangaCacheWidth;i++)
+        fits = addPage(m_currentPage + i*m_readingDirection,false);
+    for (int i=1;fits && i<=cacheRadius;i++)
+        fits = addPage(m_currentPage - i*m_readingDirection,false);
+    for (int i=0;fits && i<cacheRadius;i++) {
+        fits = addPage(i,false);
+        if (fits)
+            fits = addPage(m_pageCount-i-1,false);
     }
-    // pages around current page
-    for (int i=(m_currentPage-cacheRadius);i<(m_currentPage+cacheRadius);i++) {
-        if (i>=0 && i<m_pageCount && !l.contains(i))
-            l.append(i);
+
+    // Small pages leave room in the budget, so read further ahead
+    if (m_pageCache.averagePageBytes()>0) {
+        for (int i=gSet->settings()->mangaCacheWidth+1;fits && i<m_pageCount;i++)
+            fits = addPage(m_currentPage + i*m_readingDirection,false);
     }
+
     return l;
 }
 
 void ZMangaView::loadMangaPages(const QVector<CUrlWithName> &pages, const QString &title,
                                 const QUrl &referer, bool isFanbox)
 {
-    m_iCacheImages.clear();
+    m_pageCache.clear();
+    m_cacheGeneration++;
+    Q_EMIT abortNetworkRequest(); // replies from previous manga are ignored by generation
+    m_fetchQueue.clear();
+    m_tileCache.clear();
+    m_rotatedPage = RotatedPage();
+    m_magnifierLevel = QImage();
+    m_magnifierSourceKey = 0L;
+    m_tileGeneration++;
     m_pageData.clear();
     m_currentPage = 0;
+    m_readingDirection = 1;
     m_curUnscaledPixmap = QImage();
     m_pageCount = 0;
     m_processingPages.clear();
@@ -702,41 +970,91 @@ void ZMangaView::loadMangaPages(const QVector<CUrlWithName> &pages, const QStrin
     Q_EMIT loadedPage(-1);
 
     m_openedManga = title;
+    m_referer = referer;
+    m_isFanbox = isFanbox;
     m_pageData.resize(pages.count());
     m_pageCount = pages.count();
-    m_networkLoadersActive = 0;
     m_networkLoadedTotal = 0L;
+
+    // Pages are fetched by priority around current page, not all at once
+    QVector<QString> hosts;
+    hosts.reserve(pages.count());
     for (int i=0; i<pages.count(); i++) {
         const QUrl url(pages.at(i).first);
         m_pageData[i].first = url;
-        QNetworkRequest req(url);
-        req.setRawHeader("referer",referer.toString().toUtf8());
-        if (isFanbox)
-            req.setRawHeader("origin","https://www.fanbox.cc");
-        req.setAttribute(QNetworkRequest::RedirectPolicyAttribute,QNetworkRequest::SameOriginRedirectPolicy);
-        req.setMaximumRedirectsAllowed(CDefaults::httpMaxRedirects);
-        req.setAttribute(QNetworkRequest::HttpPipeliningAllowedAttribute,true);
-        QNetworkReply* rpl = gSet->net()->auxNetworkAccessManagerGet(req,true);
-        rpl->setProperty(CDefaults::propertyMangaPageNum,i);
-        connect(rpl, &QNetworkReply::finished, this, &ZMangaView::mangaPageDownloaded);
-        connect(rpl, &QNetworkReply::downloadProgress, this, &ZMangaView::replyProgress);
-        connect(this, &ZMangaView::abortNetworkRequest, rpl, &QNetworkReply::abort);
-        m_networkLoadersActive++;
+        hosts.append(url.host());
     }
+    m_fetchQueue.reset(hosts);
+    m_networkLoadersActive = pages.count();
+
     Q_EMIT loadingStarted();
     Q_EMIT loadingProgress(0);
     Q_EMIT loadingProgressSize(0L);
     setPage(0); // force display update with incomplete page
 }
 
+void ZMangaView::fetchNextPages()
+{
+    if (m_cleanup || m_aborted) return;
+
+    // Visible page does not wait for a free slot
+    if (m_fetchQueue.take(m_currentPage))
+        fetchPage(m_currentPage);
+
+    int num = -1;
+    while ((num = m_fetchQueue.takeNext(m_currentPage,m_readingDirection,
+                                        gSet->settings()->mangaFetchConcurrency,
+                                        gSet->settings()->mangaFetchPerHost)) >= 0) {
+        fetchPage(num);
+    }
+}
+
+void ZMangaView::fetchPage(int num)
+{
+    QUrl url;
+    {
+        QMutexLocker locker(&m_pageDataLock);
+        url = m_pageData.at(num).first;
+    }
+
+    QNetworkRequest req(url);
+    req.setRawHeader("referer",m_referer.toString().toUtf8());
+    if (m_isFanbox)
+        req.setRawHeader("origin","https://www.fanbox.cc");
+    req.setAttribute(QNetworkRequest::RedirectPolicyAttribute,QNetworkRequest::SameOriginRedirectPolicy);
+    req.setMaximumRedirectsAllowed(CDefaults::httpMaxRedirects);
+    req.setAttribute(QNetworkRequest::HttpPipeliningAllowedAttribute,true);
+    QNetworkReply* rpl = gSet->net()->auxNetworkAccessManagerGet(req,true);
+    rpl->setProperty(CDefaults::propertyMangaPageNum,num);
+    rpl->setProperty(CDefaults::propertyMangaFetchGeneration,m_cacheGeneration);
+    connect(rpl, &QNetworkReply::finished, this, &ZMangaView::mangaPageDownloaded);
+    connect(rpl, &QNetworkReply::downloadProgress, this, &ZMangaView::replyProgress);
+    connect(this, &ZMangaView::abortNetworkRequest, rpl, &QNetworkReply::abort);
+}
+
+void ZMangaView::fetchPageCompleted()
+{
+    m_networkLoadersActive--;
+    if (m_pageCount > 0)
+        Q_EMIT loadingProgress(100 * (m_pageCount - m_networkLoadersActive) / m_pageCount);
+    if (m_networkLoadersActive < 1 && !m_finished) {
+        Q_EMIT loadingFinished();
+        m_finished = true;
+    }
+}
+
 void ZMangaView::mangaPageDownloaded()
 {
     QScopedPointer<QNetworkReply,QScopedPointerDeleteLater> rpl(qobject_cast<QNetworkReply *>(sender()));
     if (m_cleanup) return;
+    if (rpl->property(CDefaults::propertyMangaFetchGeneration).toInt() != m_cacheGeneration)
+        return; // reply from previously opened manga
 
     int status = CGenericFuncs::getHttpStatusFromReply(rpl.data());
     bool numOk = false;
     int pageNum = rpl->property(CDefaults::propertyMangaPageNum).toInt(&numOk);
+    if (numOk)
+        m_fetchQueue.finished(pageNum);
     if ((rpl->error() != QNetworkReply::NoError) || (status >= CDefaults::httpCodeRedirect) || (!numOk)) {
         qWarning() << "Manga viewer network request failed: " << rpl->url();
     } else {
@@ -745,15 +1063,14 @@ void ZMangaView::mangaPageDownloaded()
             QMutexLocker locker(&m_pageDataLock);
             m_pageData[pageNum].second = data;
         }
-        if (m_currentPage == pageNum)
+        if (m_currentPage == pageNum) {
             setPage(pageNum);
+        } else {
+            cacheFillNearest(); // prefetched page is decoded if it is in active cache window
+        }
     }
-    m_networkLoadersActive--;
-    Q_EMIT loadingProgress(100 * (m_pageCount - m_networkLoadersActive) / m_pageCount);
-    if (m_networkLoadersActive < 1) {
-        Q_EMIT loadingFinished();
-        m_finished = true;
-    }
+    fetchPageCompleted();
+    fetchNextPages();
 }
 
 void ZMangaView::replyProgress(qint64 bytesReceived, qint64 bytesTotal)
@@ -770,21 +1087,129 @@ void ZMangaView::replyProgress(qint64 bytesReceived, qint64 bytesTotal)
     Q_EMIT loadingProgressSize(m_networkLoadedTotal);
 }
 
-void ZMangaView::cacheGetPage(int num)
+void ZMangaView::cacheGetFullPage(int num)
+{
+    if (m_processingPages.contains(num))
+        return;
+
+    m_processingPages << num;
+    cacheGetPage(num,QSize());
+}
+
+QSize ZMangaView::decodeSizeHint() const
+{
+    // Lens and arbitrary zoom need original pixels
+    if (!m_scroller || m_zoomDynamic)
+        return QSize();
+
+    const QSize viewport = m_scroller->viewport()->size();
+    QSize res;
+    switch (m_zoomMode) {
+        case zmFit:
+            res = viewport;
+            break;
+        case zmWidth:
+            res = QSize(viewport.width(),0);
+            break;
+        case zmHeight:
+            res = QSize(0,viewport.height());
+            break;
+        case zmOriginal:
+            return QSize();
+    }
+
+    // hint is applied to unrotated image
+    if ((m_rotation % 2) != 0)
+        res.transpose();
+    return res;
+}
+
+void ZMangaView::cacheGetPage(int num, const QSize &sizeHint)
 {
+    const ZPageCache::SpilledPage spilled = m_pageCache.spilledPage(num);
+    const bool spilledUsable = m_pageCache.isSpilled(num)
+                               && (sizeHint.isValid() || spilled.size == m_pageCache.nativeSize(num));
+    if (spilledUsable) {
+        QByteArray data;
+        {
+            QMutexLocker locker(&m_pageDataLock);
+            data = m_pageData.at(num).second;
+        }
+        m_mangaThreadPool.start([this,num,spilled,data](){
+            QImage img = ZPageCache::decompress(spilled);
+            if (img.isNull())
+                img = QImage::fromData(data);
+            QMetaObject::invokeMethod(this,[this,num,img](){
+                cacheGotPage(img,num,QSize());
+            },Qt::QueuedConnection);
+        });
+        return;
+    }
+
     QMutexLocker locker(&m_pageDataLock);
 
     auto *work = new ZImageLoaderRunnable;
     work->setAutoDelete(true);
     work->setPageData(m_pageData.at(num).second,num);
+    work->setSizeHint(sizeHint);
     connect(work,&ZImageLoaderRunnable::pageReady,this,&ZMangaView::cacheGotPage,Qt::QueuedConnection);
     m_mangaThreadPool.start(work);
 }
 
 void ZImageLoaderRunnable::run()
 {
-    const QImage img = QImage::fromData(m_pageData);
-    Q_EMIT pageReady(img,m_pageNum);
+    QBuffer buffer(&m_pageData);
+    buffer.open(QIODevice::ReadOnly);
+    QImageReader reader(&buffer);
+
+    QSize nativeSize = reader.size();
+    const QSize scaledSize = previewSize(nativeSize,m_sizeHint);
+    if (scaledSize.isValid())
+        reader.setScaledSize(scaledSize); // JPEG handler scales in DCT domain here
+
+    QImage img = reader.read();
+    if (img.isNull() && scaledSize.isValid()) {
+        qWarning() << "Manga viewer: scaled decoding failed, using full decode:" << reader.errorString();
+        img = QImage::fromData(m_pageData);
+        nativeSize = img.size();
+    }
+    if (!nativeSize.isValid())
+        nativeSize = img.size();
+
+    Q_EMIT pageReady(img,m_pageNum,nativeSize);
+}
+
+QSize ZImageLoaderRunnable::previewSize(const QSize &nativeSize, const QSize &sizeHint)
+{
+    if (nativeSize.isEmpty() || (sizeHint.width()<=0 && sizeHint.height()<=0))
+        return QSize();
+
+    QSize target;
+    if (sizeHint.width()>0 && sizeHint.height()>0) {
+        target = nativeSize.scaled(sizeHint,Qt::KeepAspectRatio);
+    } else if (sizeHint.width()>0) {
+        target = QSize(sizeHint.width(),1);
+    } else {
+        target = QSize(1,sizeHint.height());
+    }
+
+    // Largest power-of-two reduction still not smaller than displayed size
+    int shift = 0;
+    while (shift < CDefaults::mangaPreviewMaxShift
+           && (nativeSize.width() >> (shift + 1)) >= target.width()
+           && (nativeSize.height() >> (shift + 1)) >= target.height()) {
+        shift++;
+    }
+    if (shift == 0)
+        return QSize();
+
+    const int denom = 1 << shift;
+    return QSize((nativeSize.width() + denom - 1) / denom, (nativeSize.height() + denom - 1) / denom);
+}
+
+void ZImageLoaderRunnable::setSizeHint(const QSize &sizeHint)
+{
+    m_sizeHint = sizeHint;
 }
 
 void ZImageLoaderRunnable::setPageData(const QByteArray &data, int pageNum)
@@ -14,6 +14,9 @@
 #include <QList>
 #include <QAtomicInteger>
 #include "scalefilter.h"
+#include "zpagecache.h"
+#include "ztilecache.h"
+#include "zpagefetchqueue.h"
 #include "global/structures.h"
 #include "browser-utils/downloadwriter.h"
 
@@ -32,6 +35,13 @@ public:
 private:
     Q_DISABLE_COPY(ZMangaView)
 
+    struct RotatedPage {
+        int page { -1 };
+        int rotation { 0 };
+        qint64 sourceKey { 0L };
+        QImage image;
+    };
+
     ZoomMode m_zoomMode { zmFit };
     bool m_zoomDynamic { false };
     bool m_aborted { false };
@@ -39,22 +49,35 @@ private:
     bool m_cleanup { false };
     int m_rotation { 0 };
     int m_currentPage { 0 };
+    int m_readingDirection { 1 };
+    int m_cacheGeneration { 0 };
     int m_scrollAccumulator { 0 };
     int m_pageCount { 0 };
     int m_zoomAny { -1 };
     QAtomicInteger<int> m_networkLoadersActive;
     QAtomicInteger<qint64> m_networkLoadedTotal;
     QAtomicInteger<int> m_zipWorkersActive;
-    QImage m_curPixmap;
+    QAtomicInteger<int> m_tileGeneration;
+    QSize m_curPageSize;
+    QSize m_curNativeSize;
     QImage m_curUnscaledPixmap;
+    RotatedPage m_rotatedPage;
+    QImage m_magnifierLevel;
+    qint64 m_magnifierSourceKey { 0L };
+    qint64 m_magnifierPendingKey { 0L };
     QPoint m_zoomPos;
     QPointer<QScrollArea> m_scroller;
 
     QString m_openedManga;
+    QUrl m_referer;
+    bool m_isFanbox { false };
+    ZPageFetchQueue m_fetchQueue;
 
     QThreadPool m_mangaThreadPool;
 
-    QHash<int,QImage> m_iCacheImages;
+    ZPageCache m_pageCache;
+    ZTileCache m_tileCache;
+    ZTileKey m_tileParams;
     QList<QPair<QUrl,QByteArray> > m_pageData;
     QMutex m_pageDataLock;
     QList<int> m_processingPages;
@@ -63,10 +86,23 @@ private:
     void cacheFillNearest();
     QList<int> cacheGetActivePages() const;
     void displayCurrentPage();
-    void cacheGetPage(int num);   
+    void cacheGetPage(int num, const QSize &sizeHint);
+    void cacheGetFullPage(int num);
+    QSize decodeSizeHint() const;
+    void cacheSpillPages(const QList<QPair<int,QImage> > &pages);
+    QPoint pageOffset() const;
+    void updateMagnifierLevel();
+    void paintMagnifier(QPainter &painter, const QPoint &offset);
+    void paintTiles(QPainter &painter, const QRect &exposed, const QPoint &offset);
+    void requestTile(const ZTileKey &key, int priority);
+    void tileRendered(const ZTileKey &key, const QImage &tile, int generation);
+    static QImage renderTile(const QImage &src, const ZTileKey &key, const int *currentPage);
     static QImage resizeImage(const QImage &src, const QSize &targetSize, bool forceFilter,
                               Blitz::ScaleFilterType filter, int page = -1, const int *currentPage = nullptr);
     CDownloadWriter *makeWriterJob(const QString &zipName, const QString &fileName) const;
+    void fetchNextPages();
+    void fetchPage(int num);
+    void fetchPageCompleted();
 
 public:
     explicit ZMangaView(QWidget *parent = nullptr);
@@ -85,7 +121,6 @@ Q_SIGNALS:
     void keyPressed(int key);
     void rotationUpdated(double angle);
     void auxMessage(const QString& msg);
-    void requestRedrawPageEx(const QImage &scaled, int page);
 
     void abortNetworkRequest();
     void loadingStarted();
@@ -101,11 +136,10 @@ Q_SIGNALS:
 private Q_SLOTS:
     void writerCompleted(bool success);
     void writerError(const QString &message);
-    void cacheGotPage(const QImage &pageImage, int num);
+    void cacheGotPage(const QImage &pageImage, int num, const QSize &nativeSize);
     void mangaPageDownloaded();
     void replyProgress(qint64 bytesReceived, qint64 bytesTotal);
     void redrawPage();
-    void redrawPageEx(const QImage &scaled, int page);
 
 public Q_SLOTS:
     void setZoomMode(int mode);
@@ -140,11 +174,14 @@ class ZImageLoaderRunnable : public QObject, public QRunnable
 private:
     int m_pageNum { -1 };
     QByteArray m_pageData;
+    QSize m_sizeHint;
 public:
     void run() override;
     void setPageData(const QByteArray& data, int pageNum);
+    void setSizeHint(const QSize& sizeHint);
+    static QSize previewSize(const QSize& nativeSize, const QSize& sizeHint);
 Q_SIGNALS:
-    void pageReady(const QImage &image, int pageNum);
+    void pageReady(const QImage &image, int pageNum, const QSize &nativeSize);
 };
 
 #endif // ZMANGAVIEW_H
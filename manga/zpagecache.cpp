@@ -0,0 +1,226 @@
+#include <algorithm>
+#include <cstring>
+
+#include "zpagecache.h"
+
+namespace CDefaults {
+const int mangaSpillCompressionLevel = 1;
+}
+
+void ZPageCache::setBudget(qint64 budget, qint64 spillBudget)
+{
+    m_budget = qMax<qint64>(0,budget);
+    m_spillBudget = qMax<qint64>(0,spillBudget);
+
+    while (m_spilledBytes > m_spillBudget && !m_spillOrder.isEmpty())
+        removeSpilled(m_spillOrder.first());
+}
+
+qint64 ZPageCache::budget() const
+{
+    return m_budget;
+}
+
+qint64 ZPageCache::spillBudget() const
+{
+    return m_spillBudget;
+}
+
+qint64 ZPageCache::bytes() const
+{
+    return m_bytes;
+}
+
+qint64 ZPageCache::pageBytes(int page) const
+{
+    const auto it = m_images.constFind(page);
+    if (it != m_images.constEnd())
+        return imageBytes(it.value().image);
+
+    return averagePageBytes();
+}
+
+qint64 ZPageCache::averagePageBytes() const
+{
+    if (m_decodedCount == 0)
+        return 0L;
+
+    return m_decodedBytesTotal / m_decodedCount;
+}
+
+bool ZPageCache::contains(int page) const
+{
+    return m_images.contains(page);
+}
+
+bool ZPageCache::isSpilled(int page) const
+{
+    return m_spilled.contains(page);
+}
+
+QImage ZPageCache::image(int page)
+{
+    auto it = m_images.find(page);
+    if (it == m_images.end())
+        return QImage();
+
+    it.value().lastUse = ++m_useCounter;
+    return it.value().image;
+}
+
+QSize ZPageCache::nativeSize(int page) const
+{
+    return m_nativeSizes.value(page);
+}
+
+bool ZPageCache::isPreview(int page) const
+{
+    const auto it = m_images.constFind(page);
+    if (it == m_images.constEnd())
+        return false;
+
+    return (it.value().image.size() != m_nativeSizes.value(page));
+}
+
+ZPageCache::SpilledPage ZPageCache::spilledPage(int page) const
+{
+    return m_spilled.value(page);
+}
+
+void ZPageCache::insert(int page, const QImage &image, const QSize &nativeSize)
+{
+    if (image.isNull())
+        return;
+
+    if (nativeSize.isValid()) {
+        m_nativeSizes.insert(page,nativeSize);
+    } else if (!m_nativeSizes.contains(page)) {
+        m_nativeSizes.insert(page,image.size());
+    }
+
+    const qint64 size = imageBytes(image);
+    auto it = m_images.find(page);
+    if (it != m_images.end()) {
+        m_bytes -= imageBytes(it.value().image);
+    } else {
+        it = m_images.insert(page,Entry());
+    }
+
+    it.value().image = image;
+    it.value().lastUse = ++m_useCounter;
+    m_bytes += size;
+
+    m_decodedBytesTotal += size;
+    m_decodedCount++;
+}
+
+void ZPageCache::insertSpilled(int page, const SpilledPage &spilled)
+{
+    const qint64 size = spilled.data.size();
+    if (size == 0 || size > m_spillBudget)
+        return;
+
+    removeSpilled(page);
+    while (m_spilledBytes + size > m_spillBudget && !m_spillOrder.isEmpty())
+        removeSpilled(m_spillOrder.first());
+
+    m_spilled.insert(page,spilled);
+    m_spillOrder.append(page);
+    m_spilledBytes += size;
+}
+
+void ZPageCache::removeSpilled(int page)
+{
+    const auto it = m_spilled.constFind(page);
+    if (it == m_spilled.constEnd())
+        return;
+
+    m_spilledBytes -= it.value().data.size();
+    m_spilled.erase(it);
+    m_spillOrder.removeOne(page);
+}
+
+QList<QPair<int, QImage> > ZPageCache::trim(const QList<int> &pinnedPages)
+{
+    QList<QPair<int,QImage> > res;
+    if (m_bytes <= m_budget)
+        return res;
+
+    // Unpinned pages go first in LRU order, then pinned ones from the least important.
+    // The first pinned page is the displayed one and stays in cache regardless of budget.
+    QList<int> victims;
+    victims.reserve(m_images.count());
+    for (auto it = m_images.constBegin(), end = m_images.constEnd(); it != end; ++it) {
+        if (!pinnedPages.contains(it.key()))
+            victims.append(it.key());
+    }
+    std::sort(victims.begin(),victims.end(),[this](int a, int b){
+        return m_images.value(a).lastUse < m_images.value(b).lastUse;
+    });
+    for (int i = pinnedPages.count() - 1; i > 0; i--) {
+        if (m_images.contains(pinnedPages.at(i)))
+            victims.append(pinnedPages.at(i));
+    }
+
+    for (const int page : qAsConst(victims)) {
+        if (m_bytes <= m_budget)
+            break;
+
+        const QImage image = m_images.take(page).image;
+        m_bytes -= imageBytes(image);
+        if (m_spillBudget > 0 && !m_spilled.contains(page))
+            res.append(qMakePair(page,image));
+    }
+
+    return res;
+}
+
+void ZPageCache::clear()
+{
+    m_images.clear();
+    m_spilled.clear();
+    m_nativeSizes.clear();
+    m_spillOrder.clear();
+    m_bytes = 0L;
+    m_spilledBytes = 0L;
+    m_decodedBytesTotal = 0L;
+    m_decodedCount = 0;
+}
+
+qint64 ZPageCache::imageBytes(const QImage &image)
+{
+    return static_cast<qint64>(image.sizeInBytes());
+}
+
+ZPageCache::SpilledPage ZPageCache::compress(const QImage &image)
+{
+    SpilledPage res;
+    if (image.isNull())
+        return res;
+
+    // Fast zlib level keeps raw pixels restorable much faster than a full PNG/JPEG decode
+    res.size = image.size();
+    res.bytesPerLine = image.bytesPerLine();
+    res.format = image.format();
+    res.colorTable = image.colorTable();
+    res.data = qCompress(image.constBits(),static_cast<qsizetype>(image.sizeInBytes()),
+                         CDefaults::mangaSpillCompressionLevel);
+    return res;
+}
+
+QImage ZPageCache::decompress(const SpilledPage &spilled)
+{
+    if (spilled.data.isEmpty() || spilled.format == QImage::Format_Invalid)
+        return QImage();
+
+    const QByteArray raw = qUncompress(spilled.data);
+    QImage res(spilled.size,spilled.format);
+    if (res.isNull() || res.bytesPerLine() != spilled.bytesPerLine
+            || static_cast<qsizetype>(res.sizeInBytes()) != raw.size())
+        return QImage();
+
+    std::memcpy(res.bits(),raw.constData(),static_cast<size_t>(raw.size()));
+    if (!spilled.colorTable.isEmpty())
+        res.setColorTable(spilled.colorTable);
+    return res;
+}
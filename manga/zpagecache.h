@@ -0,0 +1,72 @@
+#ifndef ZPAGECACHE_H
+#define ZPAGECACHE_H
+
+#include <QImage>
+#include <QHash>
+#include <QList>
+#include <QPair>
+#include <QByteArray>
+
+class ZPageCache
+{
+public:
+    struct SpilledPage {
+        QByteArray data;
+        QSize size;
+        qsizetype bytesPerLine { 0 };
+        QImage::Format format { QImage::Format_Invalid };
+        QList<QRgb> colorTable;
+    };
+
+private:
+    struct Entry {
+        QImage image;
+        quint64 lastUse { 0 };
+    };
+
+    QHash<int,Entry> m_images;
+    QHash<int,SpilledPage> m_spilled;
+    QHash<int,QSize> m_nativeSizes;
+    QList<int> m_spillOrder;
+    qint64 m_bytes { 0L };
+    qint64 m_spilledBytes { 0L };
+    qint64 m_budget { 0L };
+    qint64 m_spillBudget { 0L };
+    qint64 m_decodedBytesTotal { 0L };
+    int m_decodedCount { 0 };
+    quint64 m_useCounter { 0 };
+
+    void removeSpilled(int page);
+
+public:
+    ZPageCache() = default;
+    ~ZPageCache() = default;
+
+    void setBudget(qint64 budget, qint64 spillBudget);
+    qint64 budget() const;
+    qint64 spillBudget() const;
+    qint64 bytes() const;
+    qint64 pageBytes(int page) const;
+    qint64 averagePageBytes() const;
+
+    bool contains(int page) const;
+    bool isSpilled(int page) const;
+    QImage image(int page);
+    QSize nativeSize(int page) const;
+    bool isPreview(int page) const;
+    SpilledPage spilledPage(int page) const;
+
+    void insert(int page, const QImage &image, const QSize &nativeSize = QSize());
+    void insertSpilled(int page, const SpilledPage &spilled);
+    QList<QPair<int,QImage> > trim(const QList<int> &pinnedPages);
+    void clear();
+
+    static qint64 imageBytes(const QImage &image);
+    static SpilledPage compress(const QImage &image);
+    static QImage decompress(const SpilledPage &spilled);
+
+private:
+    Q_DISABLE_COPY(ZPageCache)
+};
+
+#endif // ZPAGECACHE_H
@@ -0,0 +1,92 @@
+#include <climits>
+#include "zpagefetchqueue.h"
+
+void ZPageFetchQueue::reset(const QVector<QString> &pageHosts)
+{
+    clear();
+    m_pageHosts = pageHosts;
+    m_pending.reserve(pageHosts.count());
+    for (int i = 0; i < pageHosts.count(); i++)
+        m_pending.append(i);
+}
+
+void ZPageFetchQueue::clear()
+{
+    m_pending.clear();
+    m_active.clear();
+    m_pageHosts.clear();
+    m_hostActive.clear();
+}
+
+int ZPageFetchQueue::dropPending()
+{
+    const int res = m_pending.count();
+    m_pending.clear();
+    return res;
+}
+
+int ZPageFetchQueue::pendingCount() const
+{
+    return m_pending.count();
+}
+
+int ZPageFetchQueue::activeCount() const
+{
+    return m_active.count();
+}
+
+bool ZPageFetchQueue::isPending(int page) const
+{
+    return m_pending.contains(page);
+}
+
+int ZPageFetchQueue::takeNext(int currentPage, int direction, int maxActive, int maxPerHost)
+{
+    if (m_active.count() >= maxActive)
+        return -1;
+
+    // Pages ahead in reading direction go before pages at the same distance behind
+    int best = -1;
+    int bestRank = INT_MAX;
+    for (const int page : qAsConst(m_pending)) {
+        if (m_hostActive.value(m_pageHosts.at(page)) >= maxPerHost)
+            continue;
+
+        const int delta = (page - currentPage) * direction;
+        const int rank = (delta >= 0) ? delta * 2 : (-delta) * 2 + 1;
+        if (rank < bestRank) {
+            bestRank = rank;
+            best = page;
+        }
+    }
+
+    if (best >= 0)
+        start(best);
+    return best;
+}
+
+bool ZPageFetchQueue::take(int page)
+{
+    if (!m_pending.contains(page))
+        return false;
+
+    start(page);
+    return true;
+}
+
+void ZPageFetchQueue::start(int page)
+{
+    m_pending.removeOne(page);
+    m_active.insert(page);
+    m_hostActive[m_pageHosts.at(page)]++;
+}
+
+void ZPageFetchQueue::finished(int page)
+{
+    if (!m_active.remove(page))
+        return;
+
+    const QString host = m_pageHosts.at(page);
+    if (--m_hostActive[host] <= 0)
+        m_hostActive.remove(host);
+}
@@ -0,0 +1,39 @@
+#ifndef ZPAGEFETCHQUEUE_H
+#define ZPAGEFETCHQUEUE_H
+
+#include <QList>
+#include <QVector>
+#include <QHash>
+#include <QSet>
+#include <QString>
+
+class ZPageFetchQueue
+{
+private:
+    QList<int> m_pending;
+    QSet<int> m_active;
+    QVector<QString> m_pageHosts;
+    QHash<QString,int> m_hostActive;
+
+    void start(int page);
+
+public:
+    ZPageFetchQueue() = default;
+    ~ZPageFetchQueue() = default;
+
+    void reset(const QVector<QString> &pageHosts);
+    void clear();
+    int dropPending();
+    int pendingCount() const;
+    int activeCount() const;
+    bool isPending(int page) const;
+
+    int takeNext(int currentPage, int direction, int maxActive, int maxPerHost);
+    bool take(int page);
+    void finished(int page);
+
+private:
+    Q_DISABLE_COPY(ZPageFetchQueue)
+};
+
+#endif // ZPAGEFETCHQUEUE_H
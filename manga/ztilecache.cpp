@@ -0,0 +1,74 @@
+#include "ztilecache.h"
+
+bool ZTileKey::operator==(const ZTileKey &other) const
+{
+    return (page == other.page) && (rotation == other.rotation) && (filter == other.filter)
+            && (sourceKey == other.sourceKey) && (pageSize == other.pageSize) && (column == other.column) && (row == other.row);
+}
+
+QRect ZTileKey::rect() const
+{
+    const QRect tile(column * CDefaults::mangaTileSize, row * CDefaults::mangaTileSize,
+                     CDefaults::mangaTileSize, CDefaults::mangaTileSize);
+    return tile.intersected(QRect(QPoint(0,0),pageSize));
+}
+
+size_t qHash(const ZTileKey &key, size_t seed)
+{
+    return qHashMulti(seed, key.page, key.rotation, key.filter, key.sourceKey, key.pageSize.width(),
+                      key.pageSize.height(), key.column, key.row);
+}
+
+ZTileCache::ZTileCache(int maxCostKB)
+    : m_tiles(maxCostKB)
+{
+}
+
+bool ZTileCache::contains(const ZTileKey &key) const
+{
+    return m_tiles.contains(key);
+}
+
+QImage ZTileCache::tile(const ZTileKey &key) const
+{
+    const QImage* res = m_tiles.object(key);
+    if (res == nullptr)
+        return QImage();
+
+    return *res;
+}
+
+void ZTileCache::insert(const ZTileKey &key, const QImage &image)
+{
+    m_pending.remove(key);
+    if (image.isNull())
+        return;
+
+    const qsizetype cost = qMax<qsizetype>(1,image.sizeInBytes() / 1024);
+    m_tiles.insert(key,new QImage(image),cost);
+}
+
+bool ZTileCache::isPending(const ZTileKey &key) const
+{
+    return m_pending.contains(key);
+}
+
+void ZTileCache::setPending(const ZTileKey &key, bool pending)
+{
+    if (pending) {
+        m_pending.insert(key);
+    } else {
+        m_pending.remove(key);
+    }
+}
+
+void ZTileCache::clearPending()
+{
+    m_pending.clear();
+}
+
+void ZTileCache::clear()
+{
+    m_tiles.clear();
+    m_pending.clear();
+}
@@ -0,0 +1,53 @@
+#ifndef ZTILECACHE_H
+#define ZTILECACHE_H
+
+#include <QImage>
+#include <QCache>
+#include <QSet>
+#include <QHash>
+#include <QRect>
+
+namespace CDefaults {
+const int mangaTileSize = 512;
+const int mangaTileCacheSize = 256 * 1024; // KB
+}
+
+struct ZTileKey
+{
+    int page { -1 };
+    int rotation { 0 };
+    int filter { 0 };
+    qint64 sourceKey { 0L };
+    QSize pageSize;
+    int column { 0 };
+    int row { 0 };
+
+    bool operator==(const ZTileKey &other) const;
+    QRect rect() const;
+};
+
+size_t qHash(const ZTileKey &key, size_t seed = 0);
+
+class ZTileCache
+{
+private:
+    QCache<ZTileKey,QImage> m_tiles;
+    QSet<ZTileKey> m_pending;
+
+public:
+    explicit ZTileCache(int maxCostKB = CDefaults::mangaTileCacheSize);
+    ~ZTileCache() = default;
+
+    bool contains(const ZTileKey &key) const;
+    QImage tile(const ZTileKey &key) const;
+    void insert(const ZTileKey &key, const QImage &image);
+    bool isPending(const ZTileKey &key) const;
+    void setPending(const ZTileKey &key, bool pending);
+    void clearPending();
+    void clear();
+
+private:
+    Q_DISABLE_COPY(ZTileCache)
+};
+
+#endif // ZTILECACHE_H
@@ -1,9 +1,18 @@
-#include <QFileInfo>
+#include <algorithm>
+#include <execution>
+
 #include <QDir>
 #include <QFile>
+#include <QDirIterator>
+#include <QByteArrayMatcher>
 
 #include "defaultsearch.h"
 #include "utils/genericfuncs.h"
+#include "utils/contentdetector.h"
+
+namespace CDefaults {
+const int defaultSearchBatchSize = 256;
+}
 
 CDefaultSearch::CDefaultSearch(QObject *parent)
     : CAbstractThreadedSearch(parent)
@@ -15,33 +24,62 @@ void CDefaultSearch::setSearchDir(const QDir &newSearchDir)
     m_searchDir = newSearchDir;
 }
 
-void CDefaultSearch::searchInDir(const QDir &dir, const QString &qr)
+bool CDefaultSearch::isLimitReached() const
 {
-    if (m_resultCounter>m_maxLimit) return;
+    return (m_resultCounter.loadAcquire() > m_maxLimit);
+}
 
-    static const QStringList anyFile( { QSL("*") } );
+bool CDefaultSearch::searchInFile(const QString &filename, const QString &qr) const
+{
+    QFile f(filename);
+    if (!f.open(QIODevice::ReadOnly))
+        return false;
 
-    const QFileInfoList dl = dir.entryInfoList(anyFile,QDir::Dirs | QDir::NoDotAndDotDot);
-    for (const auto &fi : dl) {
-        if (m_resultCounter>m_maxLimit) return;
-        if (fi.isDir() && fi.isReadable())
-            searchInDir(QDir(fi.filePath()),qr);
+    // Mapped file content is used without copying, readAll is fallback for special files
+    QByteArray buf;
+    const qint64 size = f.size();
+    uchar* map = nullptr;
+    if (size > 0)
+        map = f.map(0,size);
+    if (map) {
+        buf = QByteArray::fromRawData(reinterpret_cast<const char *>(map),static_cast<qsizetype>(size));
+    } else {
+        buf = f.readAll();
     }
 
-    const QFileInfoList fl = dir.entryInfoList(anyFile,QDir::Files | QDir::Readable | QDir::NoDotAndDotDot);
-    for (const auto &fi : fl) {
-        if (m_resultCounter>m_maxLimit) return;
-        if (!(fi.isFile() && fi.isReadable())) continue;
-
-        QFile f(fi.filePath());
-        if (f.open(QIODevice::ReadOnly)) {
-            if (CGenericFuncs::detectDecodeToUnicode(f.readAll()).contains(qr)) {
-                Q_EMIT addHit({ { QSL("jp:fullfilename"),fi.absoluteFilePath() } });
-                m_resultCounter++;
-            }
-            f.close();
-        }
+    // Byte-level prefilter with query encoded to the same codepage used for decoding,
+    // query that cannot be encoded exactly falls back to the full scan
+    bool candidate = true;
+    const QString encoding = CContentDetector::encodingName(buf);
+    const QByteArray pattern = CContentDetector::encodeForByteSearch(qr,encoding);
+    if (!pattern.isEmpty()) {
+        const QByteArrayMatcher matcher(pattern);
+        candidate = (matcher.indexIn(buf.constData(),buf.size()) >= 0);
     }
+
+    bool res = false;
+    if (candidate)
+        res = CContentDetector::decodeToUnicode(buf,encoding).contains(qr);
+
+    buf.clear();
+    if (map)
+        f.unmap(map);
+    f.close();
+
+    return res;
+}
+
+void CDefaultSearch::searchInFiles(const QStringList &files, const QString &qr)
+{
+    std::for_each(std::execution::par,files.constBegin(),files.constEnd(),
+                  [this,&qr](const QString& filename){
+        if (isLimitReached()) return;
+
+        if (searchInFile(filename,qr)) {
+            if (m_resultCounter.fetchAndAddOrdered(1) <= m_maxLimit)
+                Q_EMIT addHit({ { QSL("jp:fullfilename"),filename } });
+        }
+    });
 }
 
 void CDefaultSearch::doSearch(const QString &qr, int maxLimit)
@@ -50,8 +88,22 @@ void CDefaultSearch::doSearch(const QString &qr, int maxLimit)
     setWorking(true);
 
     m_maxLimit = maxLimit;
-    m_resultCounter = 0;
-    searchInDir(m_searchDir,qr);
+    m_resultCounter.storeRelease(0);
+
+    // Directory walker collects batches for parallel scanning
+    QStringList batch;
+    batch.reserve(CDefaults::defaultSearchBatchSize);
+    QDirIterator it(m_searchDir.absolutePath(),QDir::Files | QDir::Readable | QDir::NoDotAndDotDot,
+                    QDirIterator::Subdirectories);
+    while (it.hasNext() && !isLimitReached()) {
+        batch.append(it.next());
+        if (batch.count() >= CDefaults::defaultSearchBatchSize) {
+            searchInFiles(batch,qr);
+            batch.clear();
+        }
+    }
+    if (!batch.isEmpty() && !isLimitReached())
+        searchInFiles(batch,qr);
 
     setWorking(false);
 
@@ -4,6 +4,8 @@
 #include <QObject>
 #include <QDir>
 #include <QString>
+#include <QStringList>
+#include <QAtomicInteger>
 #include "abstractthreadedsearch.h"
 
 class CDefaultSearch : public CAbstractThreadedSearch
@@ -16,10 +18,12 @@ public:
 
 private:
     QDir m_searchDir;
-    int m_resultCounter { 0 };
+    QAtomicInteger<int> m_resultCounter { 0 };
     int m_maxLimit { 0 };
 
-    void searchInDir(const QDir &dir, const QString &qr);
+    bool isLimitReached() const;
+    void searchInFiles(const QStringList &files, const QString &qr);
+    bool searchInFile(const QString &filename, const QString &qr) const;
 
 public Q_SLOTS:
     void doSearch(const QString &qr, int maxLimit) override;
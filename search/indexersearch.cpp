@@ -72,6 +72,11 @@ CStructures::SearchEngine CIndexerSearch::getCurrentIndexerService()
     return m_engineMode;
 }
 
+void CIndexerSearch::setHitBuffer(const QSharedPointer<CSearchHitBuffer> &buffer)
+{
+    m_hitBuffer = buffer;
+}
+
 void CIndexerSearch::addHit(const CStringHash &meta)
 {
     CStringHash result = meta;
@@ -105,7 +110,8 @@ void CIndexerSearch::addHit(const CStringHash &meta)
         result[QSL("title")]=fi.fileName();
 
     m_resultCount++;
-    Q_EMIT gotResult(result);
+    if (m_hitBuffer)
+        m_hitBuffer->push(result);
 }
 
 void CIndexerSearch::engineError(const QString &message)
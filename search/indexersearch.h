@@ -9,8 +9,10 @@
 #include <QDir>
 #include <QFileInfo>
 #include <QScopedPointer>
+#include <QSharedPointer>
 
 #include "abstractthreadedsearch.h"
+#include "searchmodel.h"
 #include "global/structures.h"
 
 namespace CDefaults {
@@ -27,9 +29,11 @@ public:
     bool isValidConfig();
     bool isWorking() const;
     CStructures::SearchEngine getCurrentIndexerService();
+    void setHitBuffer(const QSharedPointer<CSearchHitBuffer> &buffer);
     
 private:
     QScopedPointer<CAbstractThreadedSearch,QScopedPointerDeleteLater> m_engine;
+    QSharedPointer<CSearchHitBuffer> m_hitBuffer;
     QString m_query;
     QElapsedTimer m_searchTimer;
 
@@ -43,7 +47,6 @@ private:
 
 Q_SIGNALS:
     void searchFinished(const CStringHash &stats, const QString &query);
-    void gotResult(const CStringHash& result);
     void gotError(const QString& message);
     void startThreadedSearch(const QString &qr, int maxLimit);
 
@@ -3,6 +3,50 @@
 #include "searchmodel.h"
 #include "utils/genericfuncs.h"
 
+namespace CDefaults {
+const int searchHitDrainIntervalMS = 40;
+}
+
+CSearchHitBuffer::CSearchHitBuffer(QObject *parent)
+    : QObject(parent)
+{
+    m_drainTimer.setSingleShot(true);
+    m_drainTimer.setInterval(CDefaults::searchHitDrainIntervalMS);
+    connect(&m_drainTimer,&QTimer::timeout,this,&CSearchHitBuffer::flush);
+}
+
+void CSearchHitBuffer::push(const CStringHash &hit)
+{
+    bool firstHit = false;
+    {
+        QMutexLocker locker(&m_mutex);
+        firstHit = m_hits.isEmpty();
+        m_hits.append(hit);
+    }
+
+    // Only first hit of a batch schedules draining in the owner thread
+    if (firstHit) {
+        QMetaObject::invokeMethod(this,[this](){
+            if (!m_drainTimer.isActive())
+                m_drainTimer.start();
+        },Qt::QueuedConnection);
+    }
+}
+
+void CSearchHitBuffer::flush()
+{
+    m_drainTimer.stop();
+
+    QVector<CStringHash> hits;
+    {
+        QMutexLocker locker(&m_mutex);
+        hits.swap(m_hits);
+    }
+
+    if (!hits.isEmpty())
+        Q_EMIT hitsReady(hits);
+}
+
 CSearchModel::CSearchModel(QObject *parent, QTableView *view)
     : QAbstractTableModel(parent),
       m_table(view)
@@ -154,6 +198,8 @@ QStringList CSearchModel::getDistinctValues(const QString &snippetKey)
 
 void CSearchModel::deleteAllItems()
 {
+    if (m_snippets.isEmpty()) return;
+
     beginRemoveRows(QModelIndex(),0,rowCount()-1);
     m_snippets.clear();
     endRemoveRows();
@@ -166,6 +212,8 @@ void CSearchModel::addItem(const CStringHash &srcSnippet)
 
 void CSearchModel::addItems(const QVector<CStringHash> &srcSnippets)
 {
+    if (srcSnippets.isEmpty()) return;
+
     int posidx = m_snippets.count();
     beginInsertRows(QModelIndex(),posidx,posidx+srcSnippets.count()-1);
     m_snippets.append(srcSnippets);
@@ -5,8 +5,32 @@
 #include <QAbstractTableModel>
 #include <QTableView>
 #include <QSortFilterProxyModel>
+#include <QMutex>
+#include <QTimer>
 #include "global/structures.h"
 
+class CSearchHitBuffer : public QObject
+{
+    Q_OBJECT
+    Q_DISABLE_COPY(CSearchHitBuffer)
+private:
+    QMutex m_mutex;
+    QVector<CStringHash> m_hits;
+    QTimer m_drainTimer;
+
+public:
+    explicit CSearchHitBuffer(QObject *parent = nullptr);
+    ~CSearchHitBuffer() override = default;
+    void push(const CStringHash& hit);
+
+Q_SIGNALS:
+    void hitsReady(const QVector<CStringHash> &hits);
+
+public Q_SLOTS:
+    void flush();
+
+};
+
 class CSearchModel : public QAbstractTableModel
 {
     Q_OBJECT
@@ -62,7 +62,12 @@ CSearchTab::CSearchTab(CMainWindow *parent) :
     connect(ui->listResults, &QTableView::activated, this, &CSearchTab::execSnippet);
     connect(ui->editSearch->lineEdit(), &QLineEdit::returnPressed, ui->buttonSearch, &QPushButton::click);
 
+    // Hits are coalesced by buffer and inserted in batches from UI thread
+    hitBuffer = QSharedPointer<CSearchHitBuffer>(new CSearchHitBuffer(),&QObject::deleteLater);
+    connect(hitBuffer.data(), &CSearchHitBuffer::hitsReady, this, &CSearchTab::gotSearchResults);
+
     engine.reset(new CIndexerSearch());
+    engine->setHitBuffer(hitBuffer);
     auto *thread = new QThread();
     engine->moveToThread(thread);
     connect(engine.data(),&CIndexerSearch::destroyed,thread,&QThread::quit);
@@ -71,8 +76,6 @@ CSearchTab::CSearchTab(CMainWindow *parent) :
             this, &CSearchTab::searchFinished, Qt::QueuedConnection);
     connect(this, &CSearchTab::startSearch,
             engine.data(), &CIndexerSearch::doSearch, Qt::QueuedConnection);
-    connect(engine.data(), &CIndexerSearch::gotResult,
-            this, &CSearchTab::gotSearchResult, Qt::QueuedConnection);
     connect(engine.data(), &CIndexerSearch::gotError,
             this, &CSearchTab::gotSearchError,Qt::QueuedConnection);
     thread->setObjectName(QSL("SearchTabEngine"));
@@ -145,9 +148,9 @@ void CSearchTab::selectDir()
     if (!dir.isEmpty()) ui->editDir->setText(dir);
 }
 
-void CSearchTab::gotSearchResult(const CStringHash& item)
+void CSearchTab::gotSearchResults(const QVector<CStringHash> &items)
 {
-    model->addItem(item);
+    model->addItems(items);
 }
 
 void CSearchTab::gotSearchError(const QString &message)
@@ -162,6 +165,11 @@ void CSearchTab::searchFinished(const CStringHash &stats, const QString& query)
     const int maxColumnWidth = 400;
     static const QRegularExpression seconds(QSL("[s]"));
 
+    // Deliver remaining hits and sort whole results list once
+    hitBuffer->flush();
+    sort->setDynamicSortFilter(true);
+    sort->invalidate();
+
     ui->buttonSearch->setEnabled(true);
     ui->searchBar->hide();
     ui->snippetBrowser->clear();
@@ -344,6 +352,9 @@ void CSearchTab::doSearch()
 
     ui->editSearch->setCurrentIndex(0);
 
+    // Proxy sorting is deferred until search finished
+    sort->setDynamicSortFilter(false);
+
     QDir fsdir = QDir(QSL("/"));
     if (!ui->editDir->text().isEmpty())
         fsdir.setPath(ui->editDir->text());
@@ -392,10 +403,13 @@ void CSearchTab::applySnippetIdx(const QModelIndex &index)
         QString s = snip[QSL("abstract")];
         QString tranState = CGenericFuncs::bool2str(gSet->actions()->actionSnippetAutotranslate->isChecked());
         if (s.isEmpty() || tranState!=snip.value(QSL("abstract:tran"))) {
+            // Engine abstract is kept separately, so it is highlighted only once
+            const QString source = snip.value(QSL("abstract:source"),s);
+            snip[QSL("abstract:source")] = source;
             snip[QSL("abstract:untran")]=
-                    createSpecSnippet(snip[QSL("jp:fullfilename")],true,s);
+                    createSpecSnippet(snip[QSL("jp:fullfilename")],true,source);
             snip[QSL("abstract")]=
-                    createSpecSnippet(snip[QSL("jp:fullfilename")],false,s);
+                    createSpecSnippet(snip[QSL("jp:fullfilename")],false,source);
             s = snip[QSL("abstract")];
             snip[QSL("abstract:tran")] =
                     CGenericFuncs::bool2str(gSet->actions()->actionSnippetAutotranslate->isChecked());
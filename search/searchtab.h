@@ -32,6 +32,7 @@ private:
     Ui::SearchTab *ui;
     CSearchModel *model;
     CSearchProxyFilterModel *sort;
+    QSharedPointer<CSearchHitBuffer> hitBuffer;
     QString lastQuery;
     QString selectedUri;
 
@@ -63,7 +64,7 @@ public Q_SLOTS:
     void snippetMenu(const QPoint& pos);
     void applyFilter();
     void applySnippet(const QItemSelection & selected, const QItemSelection & deselected);
-    void gotSearchResult(const CStringHash &item);
+    void gotSearchResults(const QVector<CStringHash> &items);
     void gotSearchError(const QString &message);
 };
 
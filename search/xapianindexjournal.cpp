@@ -0,0 +1,291 @@
+#include <algorithm>
+#include <QFile>
+#include <QSaveFile>
+#include <QDataStream>
+#include <QDirIterator>
+#include <QFileInfo>
+#include <QDir>
+
+extern "C" {
+#include <sys/types.h>
+#include <sys/stat.h>
+}
+
+#include "xapianindexjournal.h"
+#include "global/structures.h"
+
+#include <QDebug>
+
+namespace CDefaults {
+const quint32 xapianJournalMagic = 0x4A504A4E; // 'JPJN'
+const quint32 xapianJournalVersion = 1;
+}
+
+namespace {
+
+bool statPath(const QString &path, struct stat &attrib)
+{
+    // QFileInfo too slow
+    return (stat(QFile::encodeName(path).constData(),&attrib) == 0);
+}
+
+qint64 mtimeNs(const struct stat &attrib)
+{
+    return static_cast<qint64>(attrib.st_mtim.tv_sec) * 1000000000L
+            + static_cast<qint64>(attrib.st_mtim.tv_nsec);
+}
+
+}
+
+CXapianIndexJournal::CXapianIndexJournal(const QString &fileName)
+    : m_fileName(fileName)
+{
+}
+
+bool CXapianIndexJournal::load(const QByteArray &databaseUuid)
+{
+    clear();
+
+    QFile f(m_fileName);
+    if (!f.open(QIODevice::ReadOnly))
+        return false;
+
+    QDataStream in(&f);
+    quint32 magic = 0;
+    quint32 version = 0;
+    QByteArray uuid;
+    in >> magic >> version >> uuid;
+    if (magic != CDefaults::xapianJournalMagic || version != CDefaults::xapianJournalVersion) {
+        qWarning() << QSL("XapianJournal: Unsupported journal format, full rescan required.");
+        return false;
+    }
+    if (uuid != databaseUuid) {
+        qWarning() << QSL("XapianJournal: Journal belongs to another database, full rescan required.");
+        return false;
+    }
+
+    qint32 dirsCount = 0;
+    in >> dirsCount;
+    m_dirs.reserve(dirsCount);
+    for (qint32 i = 0; i < dirsCount && in.status() == QDataStream::Ok; i++) {
+        QString path;
+        DirEntry dir;
+        qint32 filesCount = 0;
+        in >> path >> dir.mtime >> dir.subdirs >> filesCount;
+        dir.files.reserve(filesCount);
+        for (qint32 j = 0; j < filesCount && in.status() == QDataStream::Ok; j++) {
+            QString name;
+            FileEntry file;
+            in >> name >> file.inode >> file.mtime >> file.size >> file.docID;
+            dir.files.insert(name,file);
+        }
+        m_dirs.insert(path,dir);
+    }
+
+    if (in.status() != QDataStream::Ok) {
+        qWarning() << QSL("XapianJournal: Journal file is truncated, full rescan required.");
+        clear();
+        return false;
+    }
+
+    return true;
+}
+
+bool CXapianIndexJournal::save(const QByteArray &databaseUuid) const
+{
+    QSaveFile f(m_fileName);
+    if (!f.open(QIODevice::WriteOnly)) {
+        qWarning() << QSL("XapianJournal: Unable to create journal file %1").arg(m_fileName);
+        return false;
+    }
+
+    QDataStream out(&f);
+    out << CDefaults::xapianJournalMagic << CDefaults::xapianJournalVersion << databaseUuid;
+    out << static_cast<qint32>(m_dirs.count());
+    for (auto it = m_dirs.constBegin(), end = m_dirs.constEnd(); it != end; ++it) {
+        const DirEntry &dir = it.value();
+        out << it.key() << dir.mtime << dir.subdirs << static_cast<qint32>(dir.files.count());
+        for (auto fit = dir.files.constBegin(), fend = dir.files.constEnd(); fit != fend; ++fit) {
+            const FileEntry &file = fit.value();
+            out << fit.key() << file.inode << file.mtime << file.size << file.docID;
+        }
+    }
+
+    if (out.status() != QDataStream::Ok || !f.commit()) {
+        qWarning() << QSL("XapianJournal: Unable to write journal file %1").arg(m_fileName);
+        return false;
+    }
+
+    return true;
+}
+
+void CXapianIndexJournal::clear()
+{
+    m_dirs.clear();
+}
+
+bool CXapianIndexJournal::isEmpty() const
+{
+    return m_dirs.isEmpty();
+}
+
+int CXapianIndexJournal::filesCount() const
+{
+    int res = 0;
+    for (const auto &dir : qAsConst(m_dirs))
+        res += dir.files.count();
+    return res;
+}
+
+bool CXapianIndexJournal::reconcile(const QString &rootDir, Changes &changes,
+                                    const DocIDFunc &docIDFunc, const AbortFunc &isAborted,
+                                    bool fullScan)
+{
+    QStringList pending({ rootDir });
+    while (!pending.isEmpty()) {
+        if (isAborted())
+            return false;
+
+        const QString path = pending.takeLast();
+        struct stat attrib {};
+        if (!statPath(path,attrib) || !S_ISDIR(attrib.st_mode)) {
+            removeDir(path,changes);
+            continue;
+        }
+
+        // Directory mtime changes on every create, delete or rename of its entries,
+        // so an unchanged directory is not listed again. Files edited in place keep
+        // directory mtime, so known files are still checked one by one.
+        const qint64 dirMtime = mtimeNs(attrib);
+        const auto known = m_dirs.find(path);
+        if (!fullScan && known != m_dirs.end() && known.value().mtime == dirMtime) {
+            DirEntry &dir = known.value();
+            for (auto fit = dir.files.begin(); fit != dir.files.end();) {
+                FileEntry file;
+                if (updateFile(path + u'/' + fit.key(),&(fit.value()),file,changes,docIDFunc)) {
+                    fit.value() = file;
+                    ++fit;
+                } else {
+                    changes.removedDocIDs.push_back(fit.value().docID.toStdString());
+                    fit = dir.files.erase(fit);
+                }
+
+                if (isAborted())
+                    return false;
+            }
+            pending.append(dir.subdirs);
+            continue;
+        }
+
+        const DirEntry oldDir = (known != m_dirs.end()) ? known.value() : DirEntry();
+        DirEntry dir;
+        dir.mtime = dirMtime;
+        dir.files.reserve(oldDir.files.count());
+
+        QDirIterator it(path, QDir::Files | QDir::Dirs | QDir::NoDotAndDotDot | QDir::Readable);
+        while (it.hasNext()) {
+            const QString filename = it.next();
+            const QFileInfo fi = it.fileInfo();
+            if (fi.isDir()) {
+                if (!fi.isSymLink())
+                    dir.subdirs.append(filename);
+                continue;
+            }
+
+            const QString name = it.fileName();
+            const auto oldFile = oldDir.files.constFind(name);
+            FileEntry file;
+            if (updateFile(filename,(oldFile != oldDir.files.constEnd()) ? &(oldFile.value()) : nullptr,
+                           file,changes,docIDFunc)) {
+                dir.files.insert(name,file);
+            }
+
+            if (isAborted())
+                return false;
+        }
+
+        for (auto fit = oldDir.files.constBegin(), fend = oldDir.files.constEnd(); fit != fend; ++fit) {
+            if (!dir.files.contains(fit.key()))
+                changes.removedDocIDs.push_back(fit.value().docID.toStdString());
+        }
+        for (const auto &subdir : qAsConst(oldDir.subdirs)) {
+            if (!dir.subdirs.contains(subdir))
+                removeDir(subdir,changes);
+        }
+
+        pending.append(dir.subdirs);
+        m_dirs.insert(path,dir);
+    }
+
+    return true;
+}
+
+bool CXapianIndexJournal::updateFile(const QString &filename, const FileEntry *oldFile, FileEntry &file,
+                                     Changes &changes, const DocIDFunc &docIDFunc)
+{
+    struct stat fattrib {};
+    if (!statPath(filename,fattrib) || !S_ISREG(fattrib.st_mode))
+        return false;
+
+    file.inode = static_cast<quint64>(fattrib.st_ino);
+    file.mtime = mtimeNs(fattrib);
+    file.size = static_cast<qint64>(fattrib.st_size);
+
+    if (oldFile != nullptr
+            && oldFile->inode == file.inode
+            && oldFile->mtime == file.mtime
+            && oldFile->size == file.size) {
+        file.docID = oldFile->docID;
+        return true;
+    }
+
+    std::string docID;
+    if (!docIDFunc(filename,docID))
+        return false;
+    if (oldFile != nullptr && oldFile->docID.toStdString() != docID)
+        changes.removedDocIDs.push_back(oldFile->docID.toStdString());
+    file.docID = QByteArray::fromStdString(docID);
+    changes.addedFiles.emplace_back(docID,filename);
+    return true;
+}
+
+void CXapianIndexJournal::pruneRoots(const QStringList &rootDirs, Changes &changes)
+{
+    QStringList cleanRoots;
+    cleanRoots.reserve(rootDirs.count());
+    for (const auto &root : rootDirs)
+        cleanRoots.append(QDir::cleanPath(root));
+
+    for (auto it = m_dirs.begin(); it != m_dirs.end();) {
+        if (isUnderRoot(QDir::cleanPath(it.key()),cleanRoots)) {
+            ++it;
+            continue;
+        }
+        for (const auto &file : qAsConst(it.value().files))
+            changes.removedDocIDs.push_back(file.docID.toStdString());
+        it = m_dirs.erase(it);
+    }
+}
+
+void CXapianIndexJournal::removeDir(const QString &path, Changes &changes)
+{
+    const auto it = m_dirs.constFind(path);
+    if (it == m_dirs.constEnd())
+        return;
+
+    const DirEntry dir = it.value();
+    m_dirs.erase(it);
+
+    for (const auto &file : qAsConst(dir.files))
+        changes.removedDocIDs.push_back(file.docID.toStdString());
+    for (const auto &subdir : qAsConst(dir.subdirs))
+        removeDir(subdir,changes);
+}
+
+bool CXapianIndexJournal::isUnderRoot(const QString &cleanPath, const QStringList &cleanRoots)
+{
+    return std::any_of(cleanRoots.constBegin(),cleanRoots.constEnd(),[cleanPath](const QString& root){
+        return (cleanPath == root)
+                || cleanPath.startsWith(root.endsWith(u'/') ? root : root + u'/');
+    });
+}
@@ -0,0 +1,61 @@
+#ifndef XAPIANINDEXJOURNAL_H
+#define XAPIANINDEXJOURNAL_H
+
+#include <string>
+#include <vector>
+#include <functional>
+#include <QString>
+#include <QStringList>
+#include <QByteArray>
+#include <QHash>
+
+class CXapianIndexJournal
+{
+    Q_DISABLE_COPY(CXapianIndexJournal)
+public:
+    using DocIDFunc = std::function<bool(const QString &filename, std::string &docID)>;
+    using AbortFunc = std::function<bool()>;
+
+    struct Changes {
+        std::vector<std::pair<std::string,QString> > addedFiles;
+        std::vector<std::string> removedDocIDs;
+    };
+
+    explicit CXapianIndexJournal(const QString &fileName);
+    ~CXapianIndexJournal() = default;
+
+    bool load(const QByteArray &databaseUuid);
+    bool save(const QByteArray &databaseUuid) const;
+    void clear();
+    bool isEmpty() const;
+    int filesCount() const;
+
+    bool reconcile(const QString &rootDir, Changes &changes, const DocIDFunc &docIDFunc,
+                   const AbortFunc &isAborted, bool fullScan);
+    void pruneRoots(const QStringList &rootDirs, Changes &changes);
+
+private:
+    struct FileEntry {
+        quint64 inode { 0 };
+        qint64 mtime { 0L };
+        qint64 size { 0L };
+        QByteArray docID;
+    };
+
+    struct DirEntry {
+        qint64 mtime { 0L };
+        QStringList subdirs;
+        QHash<QString,FileEntry> files;
+    };
+
+    QString m_fileName;
+    QHash<QString,DirEntry> m_dirs;
+
+    void removeDir(const QString &path, Changes &changes);
+    static bool updateFile(const QString &filename, const FileEntry *oldFile, FileEntry &file,
+                           Changes &changes, const DocIDFunc &docIDFunc);
+    static bool isUnderRoot(const QString &cleanPath, const QStringList &cleanRoots);
+
+};
+
+#endif // XAPIANINDEXJOURNAL_H
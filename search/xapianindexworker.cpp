@@ -4,13 +4,14 @@
 
 #include "xapianindexworker_p.h"
 #include "xapianindexworker.h"
+#include "xapianindexjournal.h"
 
 #include <QMutex>
 #include <QMutexLocker>
-#include <QDirIterator>
 #include <QCryptographicHash>
 #include <QStandardPaths>
 #include <QScopeGuard>
+#include <QThread>
 
 extern "C" {
 #include <sys/types.h>
@@ -26,7 +27,11 @@ extern "C" {
 
 namespace CDefaults {
 const int progressMsgFrequency = 1000;
+const size_t xapianIndexQueueSize = 256;
 const auto docIDPrefix = "QFH";
+const int xapianExcerptMaxLength = 16*1024;
+const auto xapianSchemaKey = "jpreader_schema";
+const auto xapianSchemaVersion = "2"; // excerpt moved from value slot to document data
 }
 
 CXapianIndexWorker::CXapianIndexWorker(QObject *parent, bool cleanupDatabase)
@@ -38,7 +43,11 @@ CXapianIndexWorker::CXapianIndexWorker(QObject *parent, bool cleanupDatabase)
     d->m_cleanupDatabase = cleanupDatabase;
     d->m_stemLang = gSet->settings()->xapianStemmerLang.toStdString();
     d->m_indexDirs = gSet->settings()->xapianIndexDirList;
+    d->m_commitBatchSize = qMax(1,gSet->settings()->xapianCommitBatchSize);
     d->m_cacheDir.setPath(QStandardPaths::writableLocation(QStandardPaths::CacheLocation));
+
+    // Background indexing should not delay interactive workers
+    setWorkerPriority(wpLow);
 }
 
 CXapianIndexWorker::~CXapianIndexWorker() = default;
@@ -73,6 +82,18 @@ void CXapianIndexWorker::startMain()
 
     try {
         d->m_db.reset(new Xapian::WritableDatabase(dbFile.toStdString(), dbMode));
+
+        // Documents with older stored layout are rebuilt from scratch
+        if (d->m_db->get_metadata(CDefaults::xapianSchemaKey) != CDefaults::xapianSchemaVersion) {
+            if (d->m_db->get_doccount() > 0) {
+                qInfo() << QSL("XapianIndexer: Index schema changed, rebuilding index.");
+                d->m_db->close();
+                d->m_db.reset(new Xapian::WritableDatabase(dbFile.toStdString(),
+                                                           Xapian::DB_CREATE_OR_OVERWRITE));
+                d->m_cleanupDatabase = true;
+            }
+            d->m_db->set_metadata(CDefaults::xapianSchemaKey,CDefaults::xapianSchemaVersion);
+        }
     } catch (const Xapian::Error &err) {
         errMsg = QString::fromStdString(err.get_msg());
     } catch (const std::string &s) {
@@ -87,7 +108,28 @@ void CXapianIndexWorker::startMain()
         return;
     }
 
-    auto dbCleanup = qScopeGuard([this,d]{
+    // Journal is bound to the database instance, recreated database needs full rescan
+    CXapianIndexJournal journal(d->m_cacheDir.filePath(QSL("xapian_journal")));
+    QByteArray dbUuid;
+    try {
+        dbUuid = QByteArray::fromStdString(d->m_db->get_uuid());
+    } catch (const Xapian::Error &err) {
+        errMsg = QString::fromStdString(err.get_msg());
+    } catch (const std::string &s) {
+        errMsg = QString::fromStdString(s);
+    } catch (const char *s) {
+        errMsg = QString::fromUtf8(s);
+    }
+    if (!errMsg.isEmpty()) {
+        errMsg = QSL("XapianIndexer: Xapian database UUID exception: %1").arg(errMsg);
+        Q_EMIT errorOccured(errMsg);
+        qCritical() << errMsg;
+        return;
+    }
+    const bool journalLoaded = !d->m_cleanupDatabase && journal.load(dbUuid);
+    bool journalComplete = false;
+
+    auto dbCleanup = qScopeGuard([this,d,&journal,&journalComplete,&dbUuid]{
         QString errMsgSG;
         try {
             d->m_db->commit();
@@ -103,84 +145,53 @@ void CXapianIndexWorker::startMain()
             errMsgSG = QSL("XapianIndexer: Xapian database sync exception: %1").arg(errMsgSG);
             Q_EMIT errorOccured(errMsgSG);
             qCritical() << errMsgSG;
+        } else if (journalComplete) {
+            // Journal must never describe documents that are not committed
+            journal.save(dbUuid);
         }
         Q_EMIT finished();
     });
 
-    std::map<std::string,QString> fsFiles;
+    CXapianIndexJournal::Changes changes;
+    if (journalLoaded && !d->m_fastIncrementalIndex)
+        journal.pruneRoots(d->m_indexDirs,changes);
+
+    const auto docIDFunc = [this](const QString& filename, std::string &docID){
+        QString fsuffix;
+        qint64 fsize = 0;
+        return fileMeta(filename,docID,fsize,fsuffix);
+    };
+    const auto abortFunc = [this]{
+        return isAborted();
+    };
+    // Directories queued through forceScanDirList are always listed again
     for (const auto &dir : qAsConst(d->m_indexDirs)) {
-        QDirIterator it(dir, QDir::Files | QDir::Readable, QDirIterator::Subdirectories);
-        while (it.hasNext()) {
-            const QString fi = it.next();
-            std::string docID;
-            QString fsuffix;
-            qint64 fsize = 0;
-            if (fileMeta(fi,docID,fsize,fsuffix))
-                fsFiles.emplace(docID,fi);
-            if (isAborted()) {
-                qWarning() << QSL("XapianIndexer: Aborting.");
-                return;
-            }
-        }
-    }
-    qInfo() << QSL("XapianIndexer: Filesystem scan: %1 files (%2 ms).").arg(fsFiles.size()).arg(tmr.elapsed());
-
-    tmr.restart();
-    std::map<std::string,QString> baseIDs;
-    const std::string prefix(CDefaults::docIDPrefix);
-    try {
-        for (auto it = d->m_db->allterms_begin(prefix), end = d->m_db->allterms_end(prefix); it != end; ++it) {
-            baseIDs.emplace(*it,QString());
-            if (isAborted()) {
-                qWarning() << QSL("XapianIndexer: Aborting.");
-                return;
-            }
+        if (!journal.reconcile(dir,changes,docIDFunc,abortFunc,d->m_fastIncrementalIndex)) {
+            qWarning() << QSL("XapianIndexer: Aborting.");
+            return;
         }
-    } catch (const Xapian::Error &err) {
-        errMsg = QString::fromStdString(err.get_msg());
-    } catch (const std::string &s) {
-        errMsg = QString::fromStdString(s);
-    } catch (const char *s) {
-        errMsg = QString::fromUtf8(s);
     }
-    if (!errMsg.isEmpty()) {
-        errMsg = QSL("XapianIndexer: Xapian database initial scan exception: %1").arg(errMsg);
-        Q_EMIT errorOccured(errMsg);
-        qCritical() << errMsg;
-        return;
-    }
-    qInfo() << QSL("XapianIndexer: Base contents: %1 files (%2 ms).").arg(baseIDs.size()).arg(tmr.elapsed());
+    qInfo() << QSL("XapianIndexer: Filesystem scan: %1 files, %2 changed (%3 ms).")
+               .arg(journal.filesCount()).arg(changes.addedFiles.size()).arg(tmr.elapsed());
 
-    tmr.restart();
     std::vector<std::pair<std::string,QString> > newFiles;
-    std::set_difference(fsFiles.cbegin(),fsFiles.cend(),baseIDs.cbegin(),baseIDs.cend(),
-                        std::back_inserter(newFiles),
-                        [](const auto& s1, const auto& s2){
-        return s1.first < s2.first;
-    });
-    qInfo() << QSL("XapianIndexer: Files to add: %1 (%2 ms).").arg(newFiles.size()).arg(tmr.elapsed());
-
-    if (!d->m_fastIncrementalIndex) {
-        tmr.restart();
-        std::vector<std::pair<std::string,QString> > deletedFiles;
-        std::set_difference(baseIDs.cbegin(),baseIDs.cend(),fsFiles.cbegin(),fsFiles.cend(),
-                            std::back_inserter(deletedFiles),
-                            [](const auto& s1, const auto& s2){
-            return s1.first < s2.first;
-        });
-        qInfo() << QSL("XapianIndexer: Files to remove from database: %1 (%2 ms).").arg(deletedFiles.size()).arg(tmr.elapsed());
-
+    std::vector<std::string> deletedFiles;
+    if (journalLoaded) {
+        newFiles.swap(changes.addedFiles);
+        deletedFiles.swap(changes.removedDocIDs);
+    } else {
+        // Without journal all files are reported as changed, compare them with database contents once
         tmr.restart();
+        const std::map<std::string,QString> fsFiles(changes.addedFiles.cbegin(),changes.addedFiles.cend());
+        std::map<std::string,QString> baseIDs;
+        const std::string prefix(CDefaults::docIDPrefix);
         try {
-            if (!deletedFiles.empty()) {
-                for (const auto& fpair : deletedFiles) {
-                    d->m_db->delete_document(fpair.first);
-                    if (isAborted()) {
-                        qWarning() << QSL("XapianIndexer: Aborting.");
-                        return;
-                    }
+            for (auto it = d->m_db->allterms_begin(prefix), end = d->m_db->allterms_end(prefix); it != end; ++it) {
+                baseIDs.emplace(*it,QString());
+                if (isAborted()) {
+                    qWarning() << QSL("XapianIndexer: Aborting.");
+                    return;
                 }
-                qInfo() << QSL("XapianIndexer: Deleted files was removed from base (%1 ms).").arg(tmr.elapsed());
             }
         } catch (const Xapian::Error &err) {
             errMsg = QString::fromStdString(err.get_msg());
@@ -190,21 +201,82 @@ void CXapianIndexWorker::startMain()
             errMsg = QString::fromUtf8(s);
         }
         if (!errMsg.isEmpty()) {
-            errMsg = QSL("XapianIndexer: Xapian database deleted cleanup exception: %1").arg(errMsg);
+            errMsg = QSL("XapianIndexer: Xapian database initial scan exception: %1").arg(errMsg);
             Q_EMIT errorOccured(errMsg);
             qCritical() << errMsg;
             return;
         }
+        qInfo() << QSL("XapianIndexer: Base contents: %1 files (%2 ms).").arg(baseIDs.size()).arg(tmr.elapsed());
+
+        std::set_difference(fsFiles.cbegin(),fsFiles.cend(),baseIDs.cbegin(),baseIDs.cend(),
+                            std::back_inserter(newFiles),
+                            [](const auto& s1, const auto& s2){
+            return s1.first < s2.first;
+        });
+
+        if (!d->m_fastIncrementalIndex) {
+            std::vector<std::pair<std::string,QString> > deletedPairs;
+            std::set_difference(baseIDs.cbegin(),baseIDs.cend(),fsFiles.cbegin(),fsFiles.cend(),
+                                std::back_inserter(deletedPairs),
+                                [](const auto& s1, const auto& s2){
+                return s1.first < s2.first;
+            });
+            deletedFiles.reserve(deletedPairs.size());
+            for (const auto& fpair : deletedPairs)
+                deletedFiles.push_back(fpair.first);
+        }
+    }
+    qInfo() << QSL("XapianIndexer: Files to add: %1, files to remove from database: %2.")
+               .arg(newFiles.size()).arg(deletedFiles.size());
+
+    tmr.restart();
+    try {
+        if (!deletedFiles.empty()) {
+            for (const auto& docID : deletedFiles) {
+                d->m_db->delete_document(docID);
+                if (isAborted()) {
+                    qWarning() << QSL("XapianIndexer: Aborting.");
+                    return;
+                }
+            }
+            qInfo() << QSL("XapianIndexer: Deleted files was removed from base (%1 ms).").arg(tmr.elapsed());
+        }
+    } catch (const Xapian::Error &err) {
+        errMsg = QString::fromStdString(err.get_msg());
+    } catch (const std::string &s) {
+        errMsg = QString::fromStdString(s);
+    } catch (const char *s) {
+        errMsg = QString::fromUtf8(s);
+    }
+    if (!errMsg.isEmpty()) {
+        errMsg = QSL("XapianIndexer: Xapian database deleted cleanup exception: %1").arg(errMsg);
+        Q_EMIT errorOccured(errMsg);
+        qCritical() << errMsg;
+        return;
     }
 
     tmr.restart();
     if (!newFiles.empty()) {
         QAtomicInteger<int> cnt(0);
         qInfo() << QSL("XapianIndexer: Indexing %1 files...").arg(newFiles.size());
+
+        // Documents are built in parallel, the single writer thread owns all database updates
+        d->m_producersFinished = false;
+        d->m_writeFailed = false;
+        QThread* writer = QThread::create([this](){
+            writeDocuments();
+        });
+        writer->setObjectName(QSL("XapianWriter"));
+        writer->start();
+
         std::for_each(std::execution::par, newFiles.begin(), newFiles.end(),
                       [this,&cnt](const auto& fpair) {
-            if (handleFile(fpair.second))
+            if (isAborted()) return;
+            CXapianIndexedDocument document;
+            if (handleFile(fpair.second,document)) {
+                enqueueDocument(std::move(document));
                 cnt++;
+            }
             if (cnt % CDefaults::progressMsgFrequency == 0) {
                 const QString msg = tr("Xapian: Indexed %1 files...").arg(cnt);
                 qInfo() << msg;
@@ -215,12 +287,29 @@ void CXapianIndexWorker::startMain()
                 return;
             }
         });
+
+        {
+            QMutexLocker queueLocker(&d->m_queueMutex);
+            d->m_producersFinished = true;
+            d->m_queueNotEmpty.wakeAll();
+        }
+        writer->wait();
+        delete writer;
+
         qInfo() << QSL("XapianIndexer: Indexed %1 files to database (%2 ms).").arg(cnt).arg(tmr.elapsed());
     }
+    // Partial fast scan without loaded journal does not describe the whole index.
+    // Journal already lists files that failed to be written, they are retried on the next scan.
+    journalComplete = !isAborted() && !d->m_writeFailed && (journalLoaded || !d->m_fastIncrementalIndex);
     qInfo() << QSL("XapianIndexer: Scan finished.");
 #endif
 }
 
+CAbstractThreadWorker::WorkerCategory CXapianIndexWorker::workerCategory() const
+{
+    return wcIndexer;
+}
+
 QString CXapianIndexWorker::workerDescription() const
 {
     const Q_D(CXapianIndexWorker);
@@ -261,18 +350,19 @@ bool CXapianIndexWorker::fileMeta(const QString& filename, std::string &docID, q
     return true;
 }
 
-bool CXapianIndexWorker::handleFile(const QString &filename)
+bool CXapianIndexWorker::handleFile(const QString &filename, CXapianIndexedDocument &document)
 {
     const Q_D(CXapianIndexWorker);
 
 #ifdef WITH_XAPIAN
     QString mime;
+    QString title;
     QByteArray textContent;
+    QByteArray excerpt;
 
-    std::string docID;
     qint64 fileSize = 0;
     QString fileSuffix;
-    if (!fileMeta(filename,docID,fileSize,fileSuffix))
+    if (!fileMeta(filename,document.docID,fileSize,fileSuffix))
         return false;
 
     // ****** Read file
@@ -285,9 +375,11 @@ bool CXapianIndexWorker::handleFile(const QString &filename)
         mime = CGenericFuncs::detectMIME(textContent);
         if (mime.startsWith(QSL("text/html"),Qt::CaseInsensitive)) // HTML file
         {
-            CHTMLNode doc(CHTMLParser::parseHTML(CGenericFuncs::detectDecodeToUnicode(textContent)));
+            const QString source = CGenericFuncs::detectDecodeToUnicode(textContent);
+            title = CGenericFuncs::extractFileTitle(source);
+            const CHTMLDocument doc(source);
             QString html;
-            CHTMLParser::generatePlainText(doc,html);
+            doc.generatePlainText(html);
             textContent = html.toUtf8();
         } else if (fileSuffix.toLower() != QSL(".txt")) { // and TXT files are supported
             // skip other files
@@ -298,20 +390,23 @@ bool CXapianIndexWorker::handleFile(const QString &filename)
         textContent.clear();
     }
 
-    Xapian::Document doc;
     QString errMsg;
 
     try {
         if (!textContent.isEmpty()) {
             const QByteArray utf8Content = CGenericFuncs::detectDecodeToUtf8(textContent);
             if (!utf8Content.isEmpty()) {
-                // ******* Add file to database
+                // ******* Tokenize file
                 Xapian::TermGenerator generator;
                 if (!d->m_stemLang.empty())
                     generator.set_stemmer(Xapian::Stem(d->m_stemLang));
                 generator.set_flags(Xapian::TermGenerator::FLAG_CJK_WORDS);
-                generator.set_document(doc);
+                generator.set_document(document.document);
                 generator.index_text(utf8Content.toStdString());
+
+                // Compressed leading part of plain text for query-time snippets
+                excerpt = qCompress(QString::fromUtf8(utf8Content)
+                                    .left(CDefaults::xapianExcerptMaxLength).toUtf8());
             } else {
                 qCritical() << QSL("XapianIndexer: Unable to decode file %1 to UTF-8").arg(filename);
                 textContent.clear(); // codepage error
@@ -326,19 +421,106 @@ bool CXapianIndexWorker::handleFile(const QString &filename)
     }
     if (!errMsg.isEmpty()) {
         qCritical() << QSL("XapianIndexer: Xapian term generator exception: %1").arg(errMsg);
+        document.document = Xapian::Document();
         textContent.clear(); // xapian error
+        excerpt.clear();
     }
 
     // Write empty document for failed or unknown file to avoid rescan.
+    // Excerpt is kept in document data, so it is read only for returned hits.
+    QByteArray data = filename.toUtf8();
+    if (!excerpt.isEmpty()) {
+        data.append(CDefaults::xapianDataSeparator);
+        data.append(excerpt);
+    }
+    document.document.set_data(data.toStdString());
+    document.document.add_boolean_term(document.docID);
+    if (!title.isEmpty())
+        document.document.add_value(CDefaults::xapianValueTitle,title.toStdString());
+    document.document.add_value(CDefaults::xapianValueFileSize,QString::number(fileSize).toStdString());
+    document.contentSize = textContent.size();
 
-    try {
-        doc.set_data(filename.toStdString());
-        doc.add_boolean_term(docID);
-        static QMutex dbMutex;
+#else
+    Q_UNUSED(filename)
+    Q_UNUSED(document)
+#endif
+    return true;
+}
+
+void CXapianIndexWorker::enqueueDocument(CXapianIndexedDocument &&document)
+{
+    Q_D(CXapianIndexWorker);
+
+#ifdef WITH_XAPIAN
+    QMutexLocker locker(&d->m_queueMutex);
+    while (d->m_queue.size() >= CDefaults::xapianIndexQueueSize)
+        d->m_queueNotFull.wait(&d->m_queueMutex);
+
+    d->m_queue.push_back(std::move(document));
+    d->m_queueNotEmpty.wakeOne();
+#else
+    Q_UNUSED(document)
+#endif
+}
+
+void CXapianIndexWorker::writeDocuments()
+{
+    Q_D(CXapianIndexWorker);
+
+#ifdef WITH_XAPIAN
+    int uncommitted = 0;
+    for (;;) {
+        std::deque<CXapianIndexedDocument> batch;
         {
-            QMutexLocker locker(&dbMutex);
-            d->m_db->replace_document(docID,doc);
+            QMutexLocker locker(&d->m_queueMutex);
+            while (d->m_queue.empty() && !d->m_producersFinished)
+                d->m_queueNotEmpty.wait(&d->m_queueMutex);
+            if (d->m_queue.empty())
+                break;
+
+            batch.swap(d->m_queue);
+            d->m_queueNotFull.wakeAll();
+        }
+
+        for (const auto &item : batch) {
+            QString errMsg;
+            try {
+                d->m_db->replace_document(item.docID,item.document);
+            } catch (const Xapian::Error &err) {
+                errMsg = QString::fromStdString(err.get_msg());
+            } catch (const std::string &s) {
+                errMsg = QString::fromStdString(s);
+            } catch (const char *s) {
+                errMsg = QString::fromUtf8(s);
+            }
+            if (!errMsg.isEmpty()) {
+                qCritical() << QSL("XapianIndexer: Xapian database writing exception: %1").arg(errMsg);
+                d->m_writeFailed = true;
+                continue;
+            }
+
+            if (item.contentSize > 0)
+                addLoadedRequest(item.contentSize);
+
+            // Periodic commits keep already indexed files safe if indexing is interrupted
+            if (++uncommitted >= d->m_commitBatchSize) {
+                if (!commitDatabase())
+                    d->m_writeFailed = true;
+                uncommitted = 0;
+            }
         }
+    }
+#endif
+}
+
+bool CXapianIndexWorker::commitDatabase()
+{
+    Q_D(CXapianIndexWorker);
+
+#ifdef WITH_XAPIAN
+    QString errMsg;
+    try {
+        d->m_db->commit();
     } catch (const Xapian::Error &err) {
         errMsg = QString::fromStdString(err.get_msg());
     } catch (const std::string &s) {
@@ -347,13 +529,11 @@ bool CXapianIndexWorker::handleFile(const QString &filename)
         errMsg = QString::fromUtf8(s);
     }
     if (!errMsg.isEmpty()) {
-        qCritical() << QSL("XapianIndexer: Xapian database writing exception: %1").arg(errMsg);
-        textContent.clear();
+        errMsg = QSL("XapianIndexer: Xapian database commit exception: %1").arg(errMsg);
+        Q_EMIT errorOccured(errMsg);
+        qCritical() << errMsg;
+        return false;
     }
-
-    if (!textContent.isEmpty())
-        addLoadedRequest(textContent.size());
-
 #endif
     return true;
 }
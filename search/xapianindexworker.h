@@ -7,7 +7,16 @@
 #include <QScopedPointer>
 #include "abstractthreadworker.h"
 
+namespace CDefaults {
+// Document value slots filled at index time, used by search for results without disk access.
+// Document data holds file name, then zero byte and compressed text excerpt for snippets.
+const unsigned int xapianValueTitle = 0;
+const unsigned int xapianValueFileSize = 2;
+const char xapianDataSeparator = '\0';
+}
+
 class CXapianIndexWorkerPrivate;
+struct CXapianIndexedDocument;
 
 class CXapianIndexWorker : public CAbstractThreadWorker
 {
@@ -19,7 +28,10 @@ private:
     QScopedPointer<CXapianIndexWorkerPrivate> dptr;
 
     bool fileMeta(const QString& filename, std::string &docID, qint64 &size, QString &suffix);
-    bool handleFile(const QString& filename);
+    bool handleFile(const QString& filename, CXapianIndexedDocument &document);
+    void enqueueDocument(CXapianIndexedDocument &&document);
+    void writeDocuments();
+    bool commitDatabase();
 
 public:
     explicit CXapianIndexWorker(QObject *parent = nullptr, bool cleanupDatabase = false);
@@ -31,6 +43,7 @@ public:
 protected:
     void startMain() override;
     QString workerDescription() const override;
+    WorkerCategory workerCategory() const override;
 
 };
 
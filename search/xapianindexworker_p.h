@@ -5,9 +5,21 @@
 #include <xapian.h>
 #endif
 
+#include <deque>
 #include <QObject>
 #include <QScopedPointer>
 #include <QDir>
+#include <QMutex>
+#include <QWaitCondition>
+
+#ifdef WITH_XAPIAN
+struct CXapianIndexedDocument
+{
+    std::string docID;
+    Xapian::Document document;
+    qint64 contentSize { 0L };
+};
+#endif
 
 class CXapianIndexWorkerPrivate : public QObject
 {
@@ -16,7 +28,16 @@ class CXapianIndexWorkerPrivate : public QObject
 public:
 #ifdef WITH_XAPIAN
     QScopedPointer<Xapian::WritableDatabase> m_db;
+
+    // Bounded queue between parallel document builders and the single database writer
+    std::deque<CXapianIndexedDocument> m_queue;
 #endif
+    QMutex m_queueMutex;
+    QWaitCondition m_queueNotEmpty;
+    QWaitCondition m_queueNotFull;
+    bool m_producersFinished { false };
+    bool m_writeFailed { false };
+    int m_commitBatchSize { 0 };
     QStringList m_indexDirs;
     QDir m_cacheDir;
     std::string m_stemLang;
@@ -1,13 +1,100 @@
 #ifdef WITH_XAPIAN
+#include <vector>
 #include <xapian.h>
 #endif
 
 #include <QStandardPaths>
 #include <QScopeGuard>
 #include <QScopedPointer>
+#include <QMutex>
+#include <QCache>
 #include "xapiansearch.h"
+#include "xapianindexworker.h"
 #include "global/control.h"
 
+namespace CDefaults {
+const size_t xapianSnippetLength = 400;
+const int xapianQueryCacheMaxHits = 4096;
+}
+
+#ifdef WITH_XAPIAN
+namespace {
+
+// Long-lived read-only database handles shared by all search tabs.
+// Xapian handle is not thread-safe, so each query takes its own idle handle,
+// and the mutex guards only handle list and results cache.
+class CXapianSharedDatabase
+{
+public:
+    QMutex mutex;
+    std::vector<Xapian::Database> idle;
+    QCache<QString,QVector<CStringHash> > results { CDefaults::xapianQueryCacheMaxHits };
+    QString revisionKey;
+
+    static CXapianSharedDatabase* instance()
+    {
+        static CXapianSharedDatabase inst;
+        return &inst;
+    }
+
+    Xapian::Database acquire(const std::string &dbFile)
+    {
+        // mutex must be locked
+        Xapian::Database db;
+        if (idle.empty()) {
+            db = Xapian::Database(dbFile, Xapian::DB_OPEN);
+        } else {
+            db = idle.back();
+            idle.pop_back();
+            db.reopen();
+        }
+
+        // Fresh handle may see newer revision than the one cached results came from
+        const QString key = revision(db);
+        if (key != revisionKey) {
+            results.clear();
+            revisionKey = key;
+        }
+        return db;
+    }
+
+    static QString revision(const Xapian::Database &db)
+    {
+        return QSL("%1:%2").arg(QString::fromStdString(db.get_uuid())).arg(db.get_revision());
+    }
+
+    static QString resultsKey(const Xapian::Database &db, const QString &query)
+    {
+        // Handles from different revisions can be used at once, so results are bound to revision
+        return revision(db) + u'\n' + query;
+    }
+
+    void release(const Xapian::Database &db)
+    {
+        // mutex must be locked
+        idle.push_back(db);
+    }
+
+    void reset()
+    {
+        // mutex must be locked
+        results.clear();
+        revisionKey.clear();
+        for (auto &db : idle) {
+            try {
+                db.close();
+            } catch (const Xapian::Error &err) {
+                qWarning() << QSL("XapianSearch: Xapian database close exception: %1")
+                              .arg(QString::fromStdString(err.get_msg()));
+            }
+        }
+        idle.clear();
+    }
+};
+
+}
+#endif
+
 CXapianSearch::CXapianSearch(QObject *parent)
     : CAbstractThreadedSearch(parent)
 {
@@ -25,37 +112,41 @@ void CXapianSearch::doSearch(const QString &qr, int maxLimit)
     const QString dbFile = m_cacheDir.filePath(QSL("xapian_index"));
 
     QString errMsg;
-    QScopedPointer<Xapian::Database> db_ro;
+    CXapianSharedDatabase* shared = CXapianSharedDatabase::instance();
 
-    auto dbCleanup = qScopeGuard([this,&errMsg,&db_ro]{
+    auto searchCleanup = qScopeGuard([this,&errMsg]{
         if (!errMsg.isEmpty()) {
             errMsg = QSL("XapianSearch: Xapian query exception: %1").arg(errMsg);
             Q_EMIT errorOccured(errMsg);
             qCritical() << errMsg;
         }
 
-        QString errMsgSG;
-        try {
-            if (db_ro)
-                db_ro->close();
-
-        } catch (const Xapian::Error &err) {
-            errMsgSG = QString::fromStdString(err.get_msg());
-        } catch (const std::string &s) {
-            errMsgSG = QString::fromStdString(s);
-        } catch (const char *s) {
-            errMsgSG = QString::fromUtf8(s);
-        }
-        if (!errMsgSG.isEmpty()) {
-            errMsgSG = QSL("XapianSearch: Xapian query database sync exception: %1").arg(errMsgSG);
-            Q_EMIT errorOccured(errMsgSG);
-            qCritical() << errMsgSG;
-        }
-
         Q_EMIT finished();
     });
 
     try {
+        const QString queryKey = QSL("%1\n%2\n%3").arg(QString::fromStdString(m_stemLang),
+                                                        QString::number(maxLimit),qr);
+        Xapian::Database db;
+        QString cacheKey;
+        QVector<CStringHash> cachedHits;
+        bool cached = false;
+        {
+            QMutexLocker locker(&(shared->mutex));
+            db = shared->acquire(dbFile.toStdString());
+            cacheKey = CXapianSharedDatabase::resultsKey(db,queryKey);
+            if (const QVector<CStringHash>* hits = shared->results.object(cacheKey)) {
+                cachedHits = *hits;
+                cached = true;
+                shared->release(db);
+            }
+        }
+        if (cached) {
+            for (const auto& hit : qAsConst(cachedHits))
+                Q_EMIT addHit(hit);
+            return;
+        }
+
         Xapian::QueryParser qp;
         if (!m_stemLang.empty()) {
             qp.set_stemmer(Xapian::Stem(m_stemLang));
@@ -63,16 +154,54 @@ void CXapianSearch::doSearch(const QString &qr, int maxLimit)
         }
         Xapian::Query query = qp.parse_query(qr.toStdString(),Xapian::QueryParser::FLAG_CJK_WORDS);
 
-        db_ro.reset(new Xapian::Database(dbFile.toStdString(), Xapian::DB_OPEN));
-
-        Xapian::Enquire enquire(*db_ro);
+        Xapian::Enquire enquire(db);
         enquire.set_query(query);
         const Xapian::MSet result = enquire.get_mset(0,maxLimit);
+
+        Xapian::Stem stemmer;
+        if (!m_stemLang.empty())
+            stemmer = Xapian::Stem(m_stemLang);
+        unsigned snippetFlags = Xapian::MSet::SNIPPET_BACKGROUND_MODEL | Xapian::MSet::SNIPPET_EXHAUSTIVE;
+#if XAPIAN_AT_LEAST(1,4,11)
+        snippetFlags |= Xapian::MSet::SNIPPET_CJK_NGRAM;
+#endif
+
+        QScopedPointer<QVector<CStringHash> > hits(new QVector<CStringHash>());
+        hits->reserve(static_cast<int>(result.size()));
         for (auto it = result.begin(), end = result.end(); it != end; ++it) {
-            Q_EMIT addHit({ { QSL("jp:fullfilename"), QString::fromStdString(it.get_document().get_data()) },
-                            { QSL("relevancyrating"), QSL("%1%").arg(it.get_percent()) } });
+            const Xapian::Document doc = it.get_document();
+            const QByteArray data = QByteArray::fromStdString(doc.get_data());
+            const auto separator = data.indexOf(CDefaults::xapianDataSeparator);
+            CStringHash hit { { QSL("jp:fullfilename"), QString::fromUtf8(data.left(separator)) },
+                              { QSL("relevancyrating"), QSL("%1%").arg(it.get_percent()) } };
+
+            // Documents from older index versions have no stored values, fallback to file access
+            const std::string title = doc.get_value(CDefaults::xapianValueTitle);
+            if (!title.empty())
+                hit[QSL("title")] = QString::fromStdString(title);
+
+            const std::string fileSize = doc.get_value(CDefaults::xapianValueFileSize);
+            if (!fileSize.empty())
+                hit[QSL("fbytes")] = QString::fromStdString(fileSize);
+
+            if (separator >= 0) {
+                const QByteArray text = qUncompress(data.mid(separator + 1));
+                if (!text.isEmpty()) {
+                    hit[QSL("abstract")] = QString::fromStdString(
+                                               result.snippet(text.toStdString(),CDefaults::xapianSnippetLength,
+                                                              stemmer,snippetFlags,std::string(),std::string()));
+                }
+            }
+
+            hits->append(hit);
+            Q_EMIT addHit(hit);
         }
 
+        QMutexLocker locker(&(shared->mutex));
+        const int cost = qMax(1,static_cast<int>(hits->size()));
+        shared->results.insert(cacheKey,hits.take(),cost);
+        shared->release(db);
+
     } catch (const Xapian::Error &err) {
         errMsg = QString::fromStdString(err.get_msg());
     } catch (const std::string &s) {
@@ -81,6 +210,12 @@ void CXapianSearch::doSearch(const QString &qr, int maxLimit)
         errMsg = QString::fromUtf8(s);
     }
 
+    // Broken or replaced database will be opened again with next query
+    if (!errMsg.isEmpty()) {
+        QMutexLocker locker(&(shared->mutex));
+        shared->reset();
+    }
+
 #else
     Q_UNUSED(qr);
     Q_UNUSED(maxLimit);
@@ -0,0 +1,26 @@
+TARGET = tst_openaiprotocol
+TEMPLATE = app
+
+QT += testlib network
+QT -= gui
+
+CONFIG += testcase \
+    console \
+    warn_on \
+    exceptions \
+    rtti \
+    stl \
+    c++17
+
+DEFINES += QT_DEPRECATED_WARNINGS
+DEFINES += QT_DISABLE_DEPRECATED_BEFORE=0x060200
+DEFINES += QT_NO_CAST_TO_ASCII QT_NO_CAST_FROM_BYTEARRAY
+
+INCLUDEPATH += ../..
+
+HEADERS += \
+    ../../translator-workers/openaiprotocol.h
+
+SOURCES += \
+    tst_openaiprotocol.cpp \
+    ../../translator-workers/openaiprotocol.cpp
@@ -0,0 +1,327 @@
+#include <QtTest>
+#include <QTcpServer>
+#include <QTcpSocket>
+#include <QNetworkAccessManager>
+#include <QNetworkReply>
+#include <QJsonDocument>
+#include <QJsonObject>
+#include <QJsonArray>
+#include <QTimer>
+
+#include "translator-workers/openaiprotocol.h"
+#include "global/structures.h"
+
+namespace CDefaults {
+const int mockReplyTimeout = 5000;
+const int mockStreamChunkSize = 7;
+const int mockStreamDeltaLength = 5;
+}
+
+/* Minimal chat completions endpoint. Every segment of numbered batch is "translated"
+ * by wrapping it in angle brackets, so the client can check segment order and content. */
+class CMockCompletionsServer : public QTcpServer
+{
+    Q_OBJECT
+public:
+    QStringList receivedContents;
+    QList<bool> receivedStreamFlags;
+
+    explicit CMockCompletionsServer(QObject *parent = nullptr)
+        : QTcpServer(parent)
+    {
+        connect(this,&QTcpServer::newConnection,this,[this](){
+            while (QTcpSocket* socket = nextPendingConnection())
+                handleConnection(socket);
+        });
+    }
+
+    static QString translated(const QString &src)
+    {
+        return QSL("<%1>").arg(src);
+    }
+
+private:
+    void handleConnection(QTcpSocket *socket)
+    {
+        auto buffer = QSharedPointer<QByteArray>::create();
+        connect(socket,&QTcpSocket::disconnected,socket,&QObject::deleteLater);
+        connect(socket,&QTcpSocket::readyRead,this,[this,socket,buffer](){
+            buffer->append(socket->readAll());
+            const auto headerEnd = buffer->indexOf("\r\n\r\n");
+            if (headerEnd < 0) return;
+
+            qsizetype contentLength = 0;
+            const QList<QByteArray> headers = buffer->left(headerEnd).split('\n');
+            for (const auto &header : headers) {
+                if (header.trimmed().toLower().startsWith("content-length:"))
+                    contentLength = header.mid(header.indexOf(':') + 1).trimmed().toLongLong();
+            }
+            if (buffer->size() < headerEnd + 4 + contentLength) return;
+
+            reply(socket,buffer->mid(headerEnd + 4,contentLength));
+            buffer->clear();
+        });
+    }
+
+    void reply(QTcpSocket *socket, const QByteArray &body)
+    {
+        const QJsonObject request = QJsonDocument::fromJson(body).object();
+        const QJsonArray messages = request.value(QSL("messages")).toArray();
+        const QString content = messages.last().toObject().value(QSL("content")).toString();
+        const bool streaming = request.value(QSL("stream")).toBool();
+        receivedContents.append(content);
+        receivedStreamFlags.append(streaming);
+
+        const QHash<int,QString> segments = COpenAIProtocol::parseBatchContent(content);
+        QStringList answer;
+        for (int i = 1; i <= segments.count(); i++)
+            answer.append(QSL("[[%1]]\n%2").arg(i).arg(translated(segments.value(i))));
+        const QString answerText = answer.join(u'\n');
+
+        if (!streaming) {
+            const QJsonObject message({ { QSL("role"), QSL("assistant") },
+                                        { QSL("content"), answerText } });
+            const QJsonObject root({ { QSL("choices"),
+                                       QJsonArray({ QJsonObject({ { QSL("message"), message } }) }) } });
+            const QByteArray data = QJsonDocument(root).toJson(QJsonDocument::Compact);
+            socket->write(QByteArrayLiteral("HTTP/1.1 200 OK\r\nContent-Type: application/json\r\n"
+                                             "Connection: close\r\nContent-Length: ")
+                          + QByteArray::number(data.size()) + QByteArrayLiteral("\r\n\r\n") + data);
+            socket->disconnectFromHost();
+            return;
+        }
+
+        // Small content deltas, delivered in chunks that split SSE lines and UTF-8 sequences
+        QByteArray events(": keep-alive\n\n");
+        for (qsizetype pos = 0; pos < answerText.length(); pos += CDefaults::mockStreamDeltaLength) {
+            const QJsonObject delta({ { QSL("content"), answerText.mid(pos,CDefaults::mockStreamDeltaLength) } });
+            const QJsonObject chunk({ { QSL("choices"),
+                                        QJsonArray({ QJsonObject({ { QSL("delta"), delta } }) }) } });
+            events.append("data: ").append(QJsonDocument(chunk).toJson(QJsonDocument::Compact)).append("\r\n\r\n");
+        }
+        events.append("data: [DONE]\n\n");
+
+        socket->write(QByteArrayLiteral("HTTP/1.1 200 OK\r\nContent-Type: text/event-stream\r\n"
+                                         "Connection: close\r\n\r\n"));
+        auto *timer = new QTimer(socket);
+        auto pos = QSharedPointer<qsizetype>::create(0);
+        connect(timer,&QTimer::timeout,socket,[socket,timer,events,pos](){
+            socket->write(events.mid(*pos,CDefaults::mockStreamChunkSize));
+            socket->flush();
+            *pos += CDefaults::mockStreamChunkSize;
+            if (*pos >= events.size()) {
+                timer->stop();
+                socket->disconnectFromHost();
+            }
+        });
+        timer->start(1);
+    }
+};
+
+class COpenAIProtocolTest : public QObject
+{
+    Q_OBJECT
+
+private:
+    static void makeTemplate(bool streaming, QByteArray &prefix, QByteArray &suffix);
+    static QStringList testSources();
+
+private Q_SLOTS:
+    void templateSplicing();
+    void batchContent();
+    void eventStreamParsing();
+    void mockServerBatched();
+    void mockServerStreamed();
+};
+
+void COpenAIProtocolTest::makeTemplate(bool streaming, QByteArray &prefix, QByteArray &suffix)
+{
+    // Same layout as translator request templates
+    QJsonObject root;
+    root[QSL("model")] = QSL("mock-model");
+    root[QSL("messages")] = QJsonArray({
+                                QJsonObject({ { QSL("role"), QSL("system") },
+                                              { QSL("content"), QSL("Translate \"it\".") } }),
+                                QJsonObject({ { QSL("role"), QSL("user") },
+                                              { QSL("content"), COpenAIProtocol::contentPlaceholder() } }) });
+    root[QSL("temperature")] = 0.5;
+    if (streaming)
+        root[QSL("stream")] = true;
+
+    QVERIFY(COpenAIProtocol::splitBodyTemplate(QJsonDocument(root).toJson(QJsonDocument::Compact),
+                                               prefix,suffix));
+}
+
+QStringList COpenAIProtocolTest::testSources()
+{
+    return QStringList({ QSL("First paragraph."),
+                         QSL("Quote \" and backslash \\ and tab\t."),
+                         QSL("日本語のテキストです。"),
+                         QSL("Two\nlines") });
+}
+
+void COpenAIProtocolTest::templateSplicing()
+{
+    QByteArray prefix;
+    QByteArray suffix;
+    makeTemplate(false,prefix,suffix);
+    QVERIFY(!prefix.contains(COpenAIProtocol::contentPlaceholder().toLatin1()));
+    QVERIFY(!suffix.contains(COpenAIProtocol::contentPlaceholder().toLatin1()));
+
+    QByteArray unused;
+    QVERIFY(!COpenAIProtocol::splitBodyTemplate(QByteArrayLiteral("{\"a\":1}"),unused,unused));
+
+    for (const QString &content : testSources()) {
+        const QByteArray body = COpenAIProtocol::spliceBody(prefix,content,suffix);
+        QJsonParseError error {};
+        const QJsonDocument doc = QJsonDocument::fromJson(body,&error);
+        QCOMPARE(error.error,QJsonParseError::NoError);
+
+        const QJsonArray messages = doc.object().value(QSL("messages")).toArray();
+        QCOMPARE(messages.count(),2);
+        QCOMPARE(messages.at(1).toObject().value(QSL("content")).toString(),content);
+        QCOMPARE(messages.at(0).toObject().value(QSL("content")).toString(),QSL("Translate \"it\"."));
+    }
+}
+
+void COpenAIProtocolTest::batchContent()
+{
+    const QStringList sources = testSources();
+    const QHash<int,QString> segments = COpenAIProtocol::parseBatchContent(
+                                            COpenAIProtocol::makeBatchContent(sources));
+    QCOMPARE(segments.count(),sources.count());
+    for (int i = 0; i < sources.count(); i++)
+        QCOMPARE(segments.value(i+1),sources.at(i));
+
+    // Models may add spaces around markers and drop segments
+    const QHash<int,QString> loose = COpenAIProtocol::parseBatchContent(
+                                         QSL(" [[1]] \nOne\n\n[[3]]\t\nThree\n"));
+    QCOMPARE(loose.count(),2);
+    QCOMPARE(loose.value(1),QSL("One"));
+    QCOMPARE(loose.value(3),QSL("Three"));
+    QVERIFY(!loose.contains(2));
+
+    QCOMPARE(COpenAIProtocol::completedBatchSegments(QString()),0);
+    QCOMPARE(COpenAIProtocol::completedBatchSegments(QSL("[[1]]\nOne")),0);
+    QCOMPARE(COpenAIProtocol::completedBatchSegments(QSL("[[1]]\nOne\n[[2")),0);
+    QCOMPARE(COpenAIProtocol::completedBatchSegments(QSL("[[1]]\nOne\n[[2]]\n")),1);
+    QCOMPARE(COpenAIProtocol::completedBatchSegments(QSL("[[1]]\nOne\n[[2]]\nTwo\n[[3]]\nTh")),2);
+}
+
+void COpenAIProtocolTest::eventStreamParsing()
+{
+    COpenAIProtocol::StreamState state;
+    COpenAIProtocol::parseEventStream(QByteArrayLiteral(
+                                          ": comment\r\n\r\n"
+                                          "data: {\"choices\":[{\"delta\":{\"role\":\"assistant\"}}]}\r\n\r\n"
+                                          "data: {\"choices\":[{\"delta\":{\"content\":\"Hel\"}}]}\n\n"
+                                          "data:{\"choices\":[{\"delta\":{\"content\":\"lo\"}}]}\n\n"
+                                          "data: [DONE]\n\n"
+                                          "data: {\"choices\":[{\"delta\":{\"content\":\"ignored\"}}]}\n\n"),
+                                      state);
+    QVERIFY(state.finished);
+    QVERIFY(!state.failed);
+    QCOMPARE(state.content,QSL("Hello"));
+
+    // Last line without newline is still parsed, but stream without [DONE] is incomplete
+    COpenAIProtocol::StreamState interrupted;
+    COpenAIProtocol::parseEventStream(QByteArrayLiteral(
+                                          "data: {\"choices\":[{\"delta\":{\"content\":\"A\"}}]}\n\n"
+                                          "data: {\"choices\":[{\"delta\":{\"content\":\"B\"}}]}"),
+                                      interrupted);
+    QVERIFY(!interrupted.finished);
+    QCOMPARE(interrupted.content,QSL("AB"));
+
+    COpenAIProtocol::StreamState failed;
+    COpenAIProtocol::parseEventStream(QByteArrayLiteral(
+                                          "data: {\"choices\":[{\"delta\":{\"content\":\"A\"}}]}\n\n"
+                                          "data: {\"error\":{\"message\":\"overloaded\"}}\n\n"
+                                          "data: [DONE]\n\n"),
+                                      failed);
+    QVERIFY(failed.failed);
+    QVERIFY(!failed.finished);
+    QCOMPARE(failed.errorMessage,QSL("overloaded"));
+}
+
+void COpenAIProtocolTest::mockServerBatched()
+{
+    CMockCompletionsServer server;
+    QVERIFY(server.listen(QHostAddress::LocalHost));
+
+    QByteArray prefix;
+    QByteArray suffix;
+    makeTemplate(false,prefix,suffix);
+    const QStringList sources = testSources();
+
+    QNetworkAccessManager nam;
+    QNetworkRequest rq(QUrl(QSL("http://127.0.0.1:%1/v1/chat/completions").arg(server.serverPort())));
+    rq.setRawHeader("Content-Type","application/json");
+    QScopedPointer<QNetworkReply> reply(nam.post(rq,COpenAIProtocol::spliceBody(
+                                                     prefix,COpenAIProtocol::makeBatchContent(sources),suffix)));
+    QSignalSpy finished(reply.data(),&QNetworkReply::finished);
+    QVERIFY(finished.wait(CDefaults::mockReplyTimeout));
+    QCOMPARE(reply->error(),QNetworkReply::NoError);
+
+    QCOMPARE(server.receivedContents.count(),1);
+    QCOMPARE(server.receivedContents.first(),COpenAIProtocol::makeBatchContent(sources));
+    QVERIFY(!server.receivedStreamFlags.first());
+
+    const QJsonArray choices = QJsonDocument::fromJson(reply->readAll()).object()
+                               .value(QSL("choices")).toArray();
+    QCOMPARE(choices.count(),1);
+    const QHash<int,QString> segments = COpenAIProtocol::parseBatchContent(
+                                            choices.first().toObject().value(QSL("message")).toObject()
+                                            .value(QSL("content")).toString());
+    QCOMPARE(segments.count(),sources.count());
+    for (int i = 0; i < sources.count(); i++)
+        QCOMPARE(segments.value(i+1),CMockCompletionsServer::translated(sources.at(i)));
+}
+
+void COpenAIProtocolTest::mockServerStreamed()
+{
+    CMockCompletionsServer server;
+    QVERIFY(server.listen(QHostAddress::LocalHost));
+
+    QByteArray prefix;
+    QByteArray suffix;
+    makeTemplate(true,prefix,suffix);
+    const QStringList sources = testSources();
+
+    QNetworkAccessManager nam;
+    QNetworkRequest rq(QUrl(QSL("http://127.0.0.1:%1/v1/chat/completions").arg(server.serverPort())));
+    rq.setRawHeader("Content-Type","application/json");
+    rq.setRawHeader("Accept","text/event-stream");
+    QScopedPointer<QNetworkReply> reply(nam.post(rq,COpenAIProtocol::spliceBody(
+                                                     prefix,COpenAIProtocol::makeBatchContent(sources),suffix)));
+
+    // Same incremental path as translator streaming handler
+    COpenAIProtocol::StreamState state;
+    QList<int> progress;
+    connect(reply.data(),&QNetworkReply::readyRead,this,[&reply,&state,&progress](){
+        COpenAIProtocol::appendStreamData(state,reply->readAll());
+        const int completed = COpenAIProtocol::completedBatchSegments(state.content);
+        if (progress.isEmpty() || progress.last() != completed)
+            progress.append(completed);
+    });
+
+    QSignalSpy finished(reply.data(),&QNetworkReply::finished);
+    QVERIFY(finished.wait(CDefaults::mockReplyTimeout));
+    QCOMPARE(reply->error(),QNetworkReply::NoError);
+    QVERIFY(server.receivedStreamFlags.first());
+
+    QVERIFY(state.finished);
+    QVERIFY(!state.failed);
+    const QHash<int,QString> segments = COpenAIProtocol::parseBatchContent(state.content);
+    QCOMPARE(segments.count(),sources.count());
+    for (int i = 0; i < sources.count(); i++)
+        QCOMPARE(segments.value(i+1),CMockCompletionsServer::translated(sources.at(i)));
+
+    // Segments were reported one by one while the stream was still running
+    QVERIFY(progress.count() > 1);
+    QVERIFY(std::is_sorted(progress.constBegin(),progress.constEnd()));
+    QCOMPARE(progress.last(),sources.count() - 1);
+}
+
+QTEST_GUILESS_MAIN(COpenAIProtocolTest)
+
+#include "tst_openaiprotocol.moc"
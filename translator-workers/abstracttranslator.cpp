@@ -29,6 +29,9 @@ int CAbstractTranslator::getTranslatorRetryCount() const
 
 bool CAbstractTranslator::isAborted()
 {
+    if (m_abortCallback) // translator owned by batch engine thread
+        return m_abortCallback();
+
     auto *sequencedTranslator = qobject_cast<CTranslator *>(parent());
 
     if (sequencedTranslator==nullptr) // singleshot translator - no abortion
@@ -71,6 +74,11 @@ void CAbstractTranslator::clearErrorMsg()
     m_tranError.clear();
 }
 
+void CAbstractTranslator::setAbortCallback(const std::function<bool ()> &callback)
+{
+    m_abortCallback = callback;
+}
+
 CLangPair CAbstractTranslator::language() const
 {
     return m_lang;
@@ -115,6 +123,36 @@ QString CAbstractTranslator::tranString(const QString &src)
     return tranStringPrivate(src);
 }
 
+QStringList CAbstractTranslator::tranStrings(const QStringList &sources)
+{
+    int len = 0;
+    for (const auto &src : sources)
+        len += src.length();
+
+    const CStructures::TranslationEngine eng = engine();
+    QMetaObject::invokeMethod(gSet,[eng,len](){
+        gSet->net()->addTranslatorStatistics(eng, len);
+    },Qt::QueuedConnection);
+    return tranStringsPrivate(sources);
+}
+
+QStringList CAbstractTranslator::tranStringsPrivate(const QStringList &sources)
+{
+    // Engines without native batch support translate strings one by one
+    QStringList res;
+    res.reserve(sources.count());
+    for (const auto &src : sources) {
+        if (src.isEmpty()) {
+            res.append(src);
+            continue;
+        }
+        res.append(tranStringPrivate(src));
+        if (!getErrorMsg().isEmpty())
+            break;
+    }
+    return res;
+}
+
 unsigned long CAbstractTranslator::getRandomDelay(int min, int max)
 {
     int m_min = min;
@@ -178,7 +216,8 @@ CAbstractTranslator* CAbstractTranslator::translatorFactory(QObject* parent,
         res = new COpenAITranslator(parent, tranDirection, gSet->settings()->openaiTranslationModel,
                                     gSet->settings()->openaiAPIKey, gSet->settings()->openaiTemperature,
                                     gSet->settings()->openaiTopP, gSet->settings()->openaiPresencePenalty,
-                                    gSet->settings()->openaiFrequencyPenalty);
+                                    gSet->settings()->openaiFrequencyPenalty, gSet->settings()->openaiBaseUrl,
+                                    gSet->settings()->openaiBatchParagraphs, gSet->settings()->openaiStreaming);
     }
 
     return res;
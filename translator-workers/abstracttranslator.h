@@ -3,6 +3,7 @@
 
 #include <QObject>
 #include <QString>
+#include <functional>
 #include "global/structures.h"
 
 namespace CDefaults {
@@ -21,6 +22,7 @@ private:
     QString m_tranError;
     CLangPair m_lang;
     int m_translatorRetryCount { CDefaults::abstractTranslatorRetryCount };
+    std::function<bool()> m_abortCallback;
 
 protected:
     void setErrorMsg(const QString& msg);
@@ -35,6 +37,7 @@ public:
 
     virtual bool initTran()=0;
     virtual QString tranStringPrivate(const QString& src)=0;
+    virtual QStringList tranStringsPrivate(const QStringList& sources);
     virtual void doneTranPrivate(bool lazyClose)=0;
     virtual bool isReady()=0;
     virtual CStructures::TranslationEngine engine()=0;
@@ -43,10 +46,12 @@ public:
     void doneTran(bool lazyClose = false);
     QString getErrorMsg() const;
     QString tranString(const QString& src);
+    QStringList tranStrings(const QStringList& sources);
     unsigned long getRandomDelay(int min = CDefaults::tranMinRetryDelay,
                                  int max = CDefaults::tranMaxRetryDelay);
     int getTranslatorRetryCount() const;
     CLangPair language() const;
+    void setAbortCallback(const std::function<bool()>& callback);
 
     static CAbstractTranslator* translatorFactory(QObject *parent,
                                                   CStructures::TranslationEngine engine,
@@ -54,6 +59,7 @@ public:
 
 Q_SIGNALS:
     void translatorBytesTransferred(qint64 size);
+    void translatorStringsProgress(int done);
 
 };
 
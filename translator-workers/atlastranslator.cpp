@@ -1,9 +1,135 @@
 #include <QRegularExpression>
 #include <QUrl>
+#include <QThread>
+#include <QDateTime>
+#include <QMutexLocker>
 
 #include "atlastranslator.h"
 #include "global/control.h"
 #include "global/network.h"
+#include "utils/genericfuncs.h"
+
+QMutex CAtlasConnectionPool::m_mutex;
+QHash<QString,QVector<CAtlasConnectionPool::Connection> > CAtlasConnectionPool::m_connections;
+QThread* CAtlasConnectionPool::m_thread = nullptr;
+QObject* CAtlasConnectionPool::m_owner = nullptr;
+
+QObject *CAtlasConnectionPool::owner()
+{
+    // m_mutex must be locked
+    if (m_owner == nullptr) {
+        m_thread = new QThread();
+        m_thread->setObjectName(QSL("ATLAS_pool"));
+        m_owner = new QObject();
+        m_owner->moveToThread(m_thread);
+        QObject::connect(m_thread,&QThread::finished,m_owner,&QObject::deleteLater);
+        m_thread->start();
+    }
+    return m_owner;
+}
+
+void CAtlasConnectionPool::moveFromPool(QSslSocket *socket, QThread *target)
+{
+    // Only the owning thread can push object to another thread
+    QObject* context = nullptr;
+    QThread* poolThread = nullptr;
+    {
+        QMutexLocker locker(&m_mutex);
+        context = m_owner;
+        poolThread = m_thread;
+    }
+    if (context == nullptr || QThread::currentThread() == poolThread) {
+        socket->moveToThread(target);
+        return;
+    }
+    QMetaObject::invokeMethod(context,[socket,target](){
+        socket->moveToThread(target);
+    },Qt::BlockingQueuedConnection);
+}
+
+QSslSocket *CAtlasConnectionPool::acquire(const QString &key)
+{
+    const qint64 now = QDateTime::currentMSecsSinceEpoch();
+    for (;;) {
+        Connection connection;
+        {
+            QMutexLocker locker(&m_mutex);
+            auto it = m_connections.find(key);
+            if (it == m_connections.end() || it.value().isEmpty())
+                return nullptr;
+            connection = it.value().takeLast();
+        }
+
+        // Pull parked socket into current thread and check for server-side disconnect
+        moveFromPool(connection.socket,QThread::currentThread());
+        connection.socket->waitForReadyRead(0);
+        if ((now - connection.releasedAt) < CDefaults::atlasPoolIdleTimeout &&
+                connection.socket->state() == QAbstractSocket::ConnectedState &&
+                connection.socket->bytesAvailable() == 0) {
+            return connection.socket;
+        }
+
+        discard(connection.socket);
+    }
+}
+
+bool CAtlasConnectionPool::release(const QString &key, QSslSocket *socket)
+{
+    QObject* context = nullptr;
+    {
+        QMutexLocker locker(&m_mutex);
+        if (m_connections.value(key).count() >= CDefaults::atlasPoolMaxConnections)
+            return false;
+        context = owner();
+    }
+
+    socket->disconnect();
+    socket->moveToThread(context->thread());
+
+    Connection connection;
+    connection.socket = socket;
+    connection.releasedAt = QDateTime::currentMSecsSinceEpoch();
+
+    QMutexLocker locker(&m_mutex);
+    m_connections[key].append(connection);
+    return true;
+}
+
+void CAtlasConnectionPool::cleanup()
+{
+    QVector<QSslSocket*> sockets;
+    QThread* thread = nullptr;
+    QObject* context = nullptr;
+    {
+        QMutexLocker locker(&m_mutex);
+        for (const auto &list : qAsConst(m_connections)) {
+            for (const auto &connection : list)
+                sockets.append(connection.socket);
+        }
+        m_connections.clear();
+        thread = m_thread;
+        context = m_owner;
+        m_thread = nullptr;
+        m_owner = nullptr;
+    }
+    if (thread == nullptr) return;
+
+    // Parked sockets are deleted in their own thread
+    QMetaObject::invokeMethod(context,[sockets](){
+        for (QSslSocket* socket : sockets)
+            discard(socket);
+    },Qt::BlockingQueuedConnection);
+
+    thread->quit();
+    thread->wait();
+    delete thread;
+}
+
+void CAtlasConnectionPool::discard(QSslSocket *socket)
+{
+    socket->abort();
+    delete socket;
+}
 
 CAtlasTranslator::CAtlasTranslator(QObject *parent, const QString& host, quint16 port,
                                    const CLangPair &lang) :
@@ -14,27 +140,41 @@ CAtlasTranslator::CAtlasTranslator(QObject *parent, const QString& host, quint16
     if (gSet)
         m_emptyRestore=gSet->settings()->emptyRestore;
 
-    QSslConfiguration conf = m_sock.sslConfiguration();
-    conf.setProtocol(gSet->settings()->atlProto);
-    m_sock.setSslConfiguration(conf);
-    m_sock.ignoreSslErrors(gSet->net()->ignoredSslErrorsList());
-
-    connect(&m_sock,qOverload<const QList<QSslError>&>(&QSslSocket::sslErrors),
-            this,&CAtlasTranslator::sslError);
-    connect(&m_sock,&QSslSocket::errorOccurred,this,&CAtlasTranslator::socketError);
     connect(this,&CAtlasTranslator::sslCertErrors,gSet->net(),&CGlobalNetwork::sslCertErrors);
 }
 
 CAtlasTranslator::~CAtlasTranslator()
 {
-    if (m_sock.isOpen())
+    if (isSocketOpen())
         doneTran();
 }
 
+QString CAtlasTranslator::connectionKey() const
+{
+    return QSL("%1:%2:%3:%4:%5")
+            .arg(m_atlHost)
+            .arg(m_atlPort)
+            .arg(language().toString(),
+                 gSet->settings()->atlToken,
+                 CGenericFuncs::bool2str(gSet->settings()->proxyUseTranslator));
+}
+
+void CAtlasTranslator::setupSocket(QSslSocket *socket)
+{
+    connect(socket,qOverload<const QList<QSslError>&>(&QSslSocket::sslErrors),
+            this,&CAtlasTranslator::sslError);
+    connect(socket,&QSslSocket::errorOccurred,this,&CAtlasTranslator::socketError);
+}
+
+bool CAtlasTranslator::isSocketOpen() const
+{
+    return (!m_sock.isNull() && m_sock->isOpen());
+}
+
 bool CAtlasTranslator::initTran()
 {
     if (m_inited) return true;
-    if (m_sock.isOpen()) return true;
+    if (isSocketOpen()) return true;
 
     if (!language().isValid() || !language().isAtlasAcceptable()) {
         setErrorMsg(QSL("ATLAS: Unacceptable language pair. "
@@ -43,14 +183,31 @@ bool CAtlasTranslator::initTran()
         return false;
     }
 
+    // Reuse connection with completed INIT/DIR handshake
+    QSslSocket* pooled = CAtlasConnectionPool::acquire(connectionKey());
+    if (pooled) {
+        m_sock.reset(pooled);
+        setupSocket(m_sock.data());
+        m_inited = true;
+        clearErrorMsg();
+        return true;
+    }
+
+    m_sock.reset(new QSslSocket());
+    QSslConfiguration conf = m_sock->sslConfiguration();
+    conf.setProtocol(gSet->settings()->atlProto);
+    m_sock->setSslConfiguration(conf);
+    m_sock->ignoreSslErrors(gSet->net()->ignoredSslErrorsList());
+    setupSocket(m_sock.data());
+
     if (gSet->settings()->proxyUseTranslator) {
-        m_sock.setProxy(QNetworkProxy::DefaultProxy);
+        m_sock->setProxy(QNetworkProxy::DefaultProxy);
     } else {
-        m_sock.setProxy(QNetworkProxy::NoProxy);
+        m_sock->setProxy(QNetworkProxy::NoProxy);
     }
 
-    m_sock.connectToHostEncrypted(m_atlHost,m_atlPort);
-    if (!m_sock.waitForEncrypted()) {
+    m_sock->connectToHostEncrypted(m_atlHost,m_atlPort);
+    if (!m_sock->waitForEncrypted()) {
         setErrorMsg(QSL("ATLAS: SSL connection timeout"));
         qCritical() << "ATLAS: SSL connection timeout";
         return false;
@@ -60,21 +217,21 @@ bool CAtlasTranslator::initTran()
     // INIT command and response
     buf = QSL("INIT:%1\r\n").arg(gSet->settings()->atlToken).toLatin1();
     Q_EMIT translatorBytesTransferred(buf.size());
-    m_sock.write(buf);
-    m_sock.flush();
-    if (!m_sock.canReadLine()) {
-        if (!m_sock.waitForReadyRead()) {
+    m_sock->write(buf);
+    m_sock->flush();
+    if (!m_sock->canReadLine()) {
+        if (!m_sock->waitForReadyRead()) {
             setErrorMsg(QSL("ATLAS: initialization timeout"));
             qCritical() << "ATLAS: initialization timeout";
-            m_sock.close();
+            m_sock->close();
             return false;
         }
     }
-    buf = m_sock.readLine().simplified();
+    buf = m_sock->readLine().simplified();
     if (buf.isEmpty() || (!QString::fromLatin1(buf).startsWith(QSL("OK")))) {
         setErrorMsg(QSL("ATLAS: initialization error"));
         qCritical() << "ATLAS: initialization error";
-        m_sock.close();
+        m_sock->close();
         return false;
     }
 
@@ -86,21 +243,21 @@ bool CAtlasTranslator::initTran()
         trandir = QSL("DIR:EJ\r\n");
     buf = trandir.toLatin1();
     Q_EMIT translatorBytesTransferred(buf.size());
-    m_sock.write(buf);
-    m_sock.flush();
-    if (!m_sock.canReadLine()) {
-        if (!m_sock.waitForReadyRead()) {
+    m_sock->write(buf);
+    m_sock->flush();
+    if (!m_sock->canReadLine()) {
+        if (!m_sock->waitForReadyRead()) {
             setErrorMsg(QSL("ATLAS: direction timeout error"));
             qCritical() << "ATLAS: direction timeout error";
-            m_sock.close();
+            m_sock->close();
             return false;
         }
     }
-    buf = m_sock.readLine().simplified();
+    buf = m_sock->readLine().simplified();
     if (buf.isEmpty() || (!QString::fromLatin1(buf).startsWith(QSL("OK")))) {
         setErrorMsg(QSL("ATLAS: direction error"));
         qCritical() << "ATLAS: direction error";
-        m_sock.close();
+        m_sock->close();
         return false;
     }
     m_inited = true;
@@ -108,93 +265,189 @@ bool CAtlasTranslator::initTran()
     return true;
 }
 
-QString CAtlasTranslator::tranStringPrivate(const QString &src)
+bool CAtlasTranslator::writeRequest(const QString &src, bool &isEmpty)
 {
-    static const QRegularExpression resResponsePreamble(QSL("^RES:"));
+    // TR command
+    const QString s = QString::fromLatin1(QUrl::toPercentEncoding(src," ")).trimmed();
+    isEmpty = s.isEmpty();
+    if (isEmpty) return true;
 
-    if (!m_sock.isOpen()) {
-        setErrorMsg(QSL("ERROR: ATLAS socket not opened"));
-        return QSL("ERROR:TRAN_ATLAS_SOCK_NOT_OPENED");
-    }
-
-    // TR command and response
-    QString s = QString::fromLatin1(QUrl::toPercentEncoding(src," ")).trimmed();
-    if (s.isEmpty()) return QString();
-    QByteArray buf = QSL("TR:%1\r\n").arg(s).toLatin1();
+    const QByteArray buf = QSL("TR:%1\r\n").arg(s).toLatin1();
     Q_EMIT translatorBytesTransferred(buf.size());
-    m_sock.write(buf);
-    m_sock.flush();
+    return (m_sock->write(buf) == buf.size());
+}
+
+bool CAtlasTranslator::readResponse(const QString &src, QString &result)
+{
+    static const QRegularExpression resResponsePreamble(QSL("^RES:"));
+
+    QByteArray buf;
     QByteArray sumbuf;
     while(true) {
-        if (!m_sock.canReadLine()) {
-            if (!m_sock.waitForReadyRead(CDefaults::translatorConnectionTimeout)) {
+        if (!m_sock->canReadLine()) {
+            if (!m_sock->waitForReadyRead(CDefaults::translatorConnectionTimeout)) {
                 qCritical() << "ATLAS: translation timeout error";
-                m_sock.close();
+                m_sock->close();
                 setErrorMsg(QSL("ERROR: ATLAS socket error"));
-                return QSL("ERROR:TRAN_ATLAS_SOCKET_ERROR");
+                result = QSL("ERROR:TRAN_ATLAS_SOCKET_ERROR");
+                return false;
             }
         }
-        buf = m_sock.readLine();
+        buf = m_sock->readLine();
         sumbuf.append(buf);
         if (buf.endsWith("\r\n")||buf.endsWith("\r")) break;
     }
     sumbuf = sumbuf.simplified();
     sumbuf.replace(u'+',u' ');
-    s = QString::fromLatin1(sumbuf);
+    QString s = QString::fromLatin1(sumbuf);
     if (sumbuf.isEmpty() || !s.contains(resResponsePreamble)) {
         if (s.contains(QSL("NEED_RESTART"))) {
             qCritical() << "ATLAS: translation engine slipped. Please restart again.";
-            m_sock.close();
+            m_sock->close();
             setErrorMsg(QSL("ERROR: ATLAS slipped"));
-            return QSL("ERROR:ATLAS_SLIPPED");
+            result = QSL("ERROR:ATLAS_SLIPPED");
+            return false;
         }
 
         qCritical() << "ATLAS: translation error";
-        m_sock.close();
+        m_sock->close();
         setErrorMsg(QSL("ERROR: ATLAS translation error"));
-        return QSL("ERROR:TRAN_ATLAS_TRAN_ERROR");
+        result = QSL("ERROR:TRAN_ATLAS_TRAN_ERROR");
+        return false;
     }
 
     s = s.remove(resResponsePreamble);
-    QString res = QUrl::fromPercentEncoding(s.toLatin1());
-    if (res.trimmed().isEmpty() && m_emptyRestore)
-        return src;
+    result = QUrl::fromPercentEncoding(s.toLatin1());
+    if (result.trimmed().isEmpty() && m_emptyRestore)
+        result = src;
+    return true;
+}
+
+QString CAtlasTranslator::tranStringPrivate(const QString &src)
+{
+    if (!isSocketOpen()) {
+        setErrorMsg(QSL("ERROR: ATLAS socket not opened"));
+        return QSL("ERROR:TRAN_ATLAS_SOCK_NOT_OPENED");
+    }
+
+    bool isEmpty = false;
+    if (!writeRequest(src,isEmpty)) {
+        qCritical() << "ATLAS: socket write error";
+        m_sock->close();
+        setErrorMsg(QSL("ERROR: ATLAS socket error"));
+        return QSL("ERROR:TRAN_ATLAS_SOCKET_ERROR");
+    }
+    if (isEmpty) return QString();
+    m_sock->flush();
+
+    QString res;
+    readResponse(src,res);
     return res;
 }
 
-void CAtlasTranslator::doneTranPrivate(bool lazyClose)
+QStringList CAtlasTranslator::tranStringsPrivate(const QStringList &sources)
 {
-    m_inited = false;
+    // Keep several TR requests in flight, server replies strictly in request order
+    if (!isSocketOpen()) {
+        setErrorMsg(QSL("ERROR: ATLAS socket not opened"));
+        return QStringList();
+    }
 
-    if (!m_sock.isOpen()) return;
-
-    if (!lazyClose) {
-        // FIN command and response
-        QByteArray buf = QSL("FIN\r\n").toLatin1();
-        Q_EMIT translatorBytesTransferred(buf.size());
-        m_sock.write(buf);
-        m_sock.flush();
-        if (!m_sock.canReadLine()) {
-            if (!m_sock.waitForReadyRead()) {
-                qCritical() << "ATLAS: finalization timeout error";
-                m_sock.close();
-                return;
+    QStringList res;
+    res.reserve(sources.count());
+    for (int i = 0; i < sources.count(); i++)
+        res.append(QString());
+
+    QVector<int> inFlight;
+    inFlight.reserve(CDefaults::atlasPipelineDepth);
+    int next = 0;
+    int inFlightHead = 0;
+    while (next < sources.count() || inFlightHead < inFlight.count()) {
+        bool written = false;
+        while (next < sources.count() && (inFlight.count() - inFlightHead) < CDefaults::atlasPipelineDepth) {
+            bool isEmpty = false;
+            if (!writeRequest(sources.at(next),isEmpty)) {
+                qCritical() << "ATLAS: socket write error";
+                m_sock->close();
+                setErrorMsg(QSL("ERROR: ATLAS socket error"));
+                return QStringList();
             }
+            if (!isEmpty) {
+                inFlight.append(next);
+                written = true;
+            }
+            next++;
         }
-        buf = m_sock.readLine().simplified();
-        if (buf.isEmpty() || (!QString::fromLatin1(buf).startsWith(QSL("OK")))) {
-            qCritical() << "ATLAS: finalization error";
-            m_sock.close();
+        if (written)
+            m_sock->flush();
+
+        if (inFlightHead >= inFlight.count())
+            break;
+
+        const int idx = inFlight.at(inFlightHead++);
+        QString result;
+        if (!readResponse(sources.at(idx),result))
+            return QStringList();
+        res[idx] = result;
+    }
+
+    return res;
+}
+
+void CAtlasTranslator::doneTranPrivate(bool lazyClose)
+{
+    const bool inited = m_inited;
+    m_inited = false;
+
+    if (!isSocketOpen()) {
+        m_sock.reset();
+        return;
+    }
+
+    // Lazy close drops the connection without FIN, it is used after translation errors
+    if (lazyClose) {
+        m_sock->abort();
+        m_sock.reset();
+        return;
+    }
+
+    // Healthy connection goes back to pool, handshake is performed once per session
+    if (inited && getErrorMsg().isEmpty() &&
+            m_sock->state() == QAbstractSocket::ConnectedState &&
+            m_sock->bytesAvailable() == 0) {
+        QSslSocket* socket = m_sock.take();
+        if (CAtlasConnectionPool::release(connectionKey(),socket))
+            return;
+        m_sock.reset(socket);
+        setupSocket(m_sock.data());
+    }
+
+    // FIN command and response
+    QByteArray buf = QSL("FIN\r\n").toLatin1();
+    Q_EMIT translatorBytesTransferred(buf.size());
+    m_sock->write(buf);
+    m_sock->flush();
+    if (!m_sock->canReadLine()) {
+        if (!m_sock->waitForReadyRead()) {
+            qCritical() << "ATLAS: finalization timeout error";
+            m_sock.reset();
             return;
         }
     }
+    buf = m_sock->readLine().simplified();
+    if (buf.isEmpty() || (!QString::fromLatin1(buf).startsWith(QSL("OK")))) {
+        qCritical() << "ATLAS: finalization error";
+        m_sock.reset();
+        return;
+    }
 
-    m_sock.close();
+    m_sock->close();
+    m_sock.reset();
 }
 
 bool CAtlasTranslator::isReady()
 {
-    return (m_inited && m_sock.isOpen());
+    return (m_inited && isSocketOpen());
 }
 
 CStructures::TranslationEngine CAtlasTranslator::engine()
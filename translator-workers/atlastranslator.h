@@ -3,14 +3,49 @@
 
 #include <QObject>
 #include <QSslSocket>
+#include <QThread>
 #include <QString>
+#include <QHash>
+#include <QMutex>
+#include <QVector>
+#include <QScopedPointer>
 #include "abstracttranslator.h"
 
 namespace CDefaults {
 const unsigned int atlasMinRetryDelay = 3000;
 const unsigned int atlasMaxRetryDelay = 5000;
+const int atlasPipelineDepth = 8;
+const int atlasPoolMaxConnections = 8;
+const qint64 atlasPoolIdleTimeout = 60000;
 }
 
+/* Handshaked ATLAS connections, shared between translator instances.
+ * Idle sockets live in the pool thread with running event loop and are moved
+ * into the thread of the next user. */
+class CAtlasConnectionPool
+{
+public:
+    static QSslSocket* acquire(const QString& key);
+    static bool release(const QString& key, QSslSocket* socket);
+    static void cleanup();
+
+private:
+    struct Connection {
+        QSslSocket* socket { nullptr };
+        qint64 releasedAt { 0L };
+    };
+
+    static QMutex m_mutex;
+    static QHash<QString,QVector<Connection> > m_connections;
+    static QThread* m_thread;
+    static QObject* m_owner;
+
+    CAtlasConnectionPool() = delete;
+    static QObject* owner();
+    static void moveFromPool(QSslSocket* socket, QThread* target);
+    static void discard(QSslSocket* socket);
+};
+
 class CAtlasTranslator : public CAbstractTranslator
 {
     Q_OBJECT
@@ -21,7 +56,7 @@ public:
         JpnToEngTran
     };
 private:
-    QSslSocket m_sock;
+    QScopedPointer<QSslSocket> m_sock;
     QString m_atlHost;
     quint16 m_atlPort;
     bool m_inited { false };
@@ -29,12 +64,19 @@ private:
 
     Q_DISABLE_COPY(CAtlasTranslator)
 
+    QString connectionKey() const;
+    void setupSocket(QSslSocket* socket);
+    bool isSocketOpen() const;
+    bool writeRequest(const QString& src, bool& isEmpty);
+    bool readResponse(const QString& src, QString& result);
+
 public:
     explicit CAtlasTranslator(QObject *parent, const QString &host, quint16 port, const CLangPair& lang);
     ~CAtlasTranslator() override;
 
     bool initTran() override;
     QString tranStringPrivate(const QString& src) override;
+    QStringList tranStringsPrivate(const QStringList& sources) override;
     void doneTranPrivate(bool lazyClose) override;
     bool isReady() override;
     CStructures::TranslationEngine engine() override;
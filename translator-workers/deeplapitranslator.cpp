@@ -25,7 +25,12 @@ QUrl CDeeplAPITranslator::queryUrl(const QString &method) const
     return QUrl(QSL("https://%1/v2/%2").arg(host,method));
 }
 
-QString CDeeplAPITranslator::tranStringInternal(const QString &src)
+bool CDeeplAPITranslator::supportsConcurrentRequests() const
+{
+    return true;
+}
+
+bool CDeeplAPITranslator::prepareTranslation(const QString &src, QNetworkRequest &request, QByteArray &body)
 {
     QUrl rqurl = queryUrl(QSL("translate"));
 
@@ -50,28 +55,27 @@ QString CDeeplAPITranslator::tranStringInternal(const QString &src)
     rq.setRawHeader("Accept","application/json");
     rq.setRawHeader("Content-Type","application/x-www-form-urlencoded");
 
-    bool aborted = false;
-    int status = CDefaults::httpCodeClientUnknownError;
-    auto requestMaker = [rq]() -> QNetworkRequest {
-        return rq;
-    };
-    QByteArray ra = processRequest(requestMaker,rqData.toString(QUrl::FullyEncoded).toUtf8(),
-                                   &status,&aborted);
+    request = rq;
+    body = rqData.toString(QUrl::FullyEncoded).toUtf8();
+    return true;
+}
 
+QString CDeeplAPITranslator::parseTranslation(const QByteArray &replyBody, int httpStatus, bool aborted)
+{
     if (aborted) {
         setErrorMsg(QSL("ERROR: DeepL API translator aborted by user request"));
         return QSL("ERROR:TRAN_DEEPL_API_ABORTED");
     }
-    if (status == CDefaults::httpQuotaExceeded) {
+    if (httpStatus == CDefaults::httpQuotaExceeded) {
         setErrorMsg(tr("ERROR: DeepL API quota exceeded"));
         return QSL("ERROR:TRAN_DEEPL_API_QUOTA_EXCEEDED");
     }
-    if (ra.isEmpty()) {
+    if (replyBody.isEmpty()) {
         setErrorMsg(tr("ERROR: DeepL API translator empty response"));
         return QSL("ERROR:TRAN_DEEPL_API_NETWORK_ERROR");
     }
 
-    QJsonDocument jdoc = QJsonDocument::fromJson(ra);
+    QJsonDocument jdoc = QJsonDocument::fromJson(replyBody);
 
     if (jdoc.isNull() || jdoc.isEmpty()) {
         setErrorMsg(tr("ERROR: DeepL API translator JSON error"));
@@ -83,19 +87,19 @@ QString CDeeplAPITranslator::tranStringInternal(const QString &src)
     if (err.isString()) {
         setErrorMsg(tr("ERROR: DeepL API translator internal error.\nMessage: %1,\nHTTP status: %2")
                     .arg(err.toString())
-                    .arg(status));
+                    .arg(httpStatus));
         return QSL("ERROR:TRAN_DEEPL_API_GENERIC_ERROR");
     }
 
-    if (status != CDefaults::httpCodeFound) {
-        setErrorMsg(QSL("ERROR: DeepL API translator HTTP generic error.\nHTTP status: %1").arg(status));
+    if (httpStatus != CDefaults::httpCodeFound) {
+        setErrorMsg(QSL("ERROR: DeepL API translator HTTP generic error.\nHTTP status: %1").arg(httpStatus));
         return QSL("ERROR:TRAN_DEEPL_API_HTTP_ERROR");
     }
 
     const QJsonArray translations = jroot.value(QSL("translations")).toArray();
     if (translations.isEmpty()) {
         setErrorMsg(QSL("ERROR: DeepL API translator result member missing from JSON response, "
-                        "HTTP status: %1").arg(status));
+                        "HTTP status: %1").arg(httpStatus));
         return QSL("ERROR:TRAN_DEEPL_API_RESPONSE_ERROR");
     }
 
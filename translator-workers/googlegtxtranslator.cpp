@@ -25,7 +25,12 @@ CStructures::TranslationEngine CGoogleGTXTranslator::engine()
     return CStructures::teGoogleGTX;
 }
 
-QString CGoogleGTXTranslator::tranStringInternal(const QString &src)
+bool CGoogleGTXTranslator::supportsConcurrentRequests() const
+{
+    return true;
+}
+
+bool CGoogleGTXTranslator::prepareTranslation(const QString &src, QNetworkRequest &request, QByteArray &body)
 {
     QUrl rqurl = QUrl(QString::fromUtf8(QByteArray::fromBase64(
         "aHR0cHM6Ly90cmFuc2xhdGUuZ29vZ2xlYXBpcy5jb20vdHJhbnNsYXRlX2Evc2luZ2xl")));
@@ -41,28 +46,27 @@ QString CGoogleGTXTranslator::tranStringInternal(const QString &src)
     rq.setHeader(QNetworkRequest::ContentTypeHeader,
                  "application/x-www-form-urlencoded");
 
-    bool aborted = false;
-    int status = CDefaults::httpCodeClientUnknownError;
-    auto requestMaker = [rq]() -> QNetworkRequest {
-        return rq;
-    };
-    QByteArray ra = processRequest(requestMaker,rqData.toString(QUrl::FullyEncoded).toUtf8(),
-                                   &status,&aborted);
+    request = rq;
+    body = rqData.toString(QUrl::FullyEncoded).toUtf8();
+    return true;
+}
 
+QString CGoogleGTXTranslator::parseTranslation(const QByteArray &replyBody, int httpStatus, bool aborted)
+{
     if (aborted) {
         setErrorMsg(QSL("ERROR: Yandex translator aborted by user request"));
         return QSL("ERROR:TRAN_GOOGLE_GTX_ABORTED");
     }
-    if (ra.isEmpty() || status>=CDefaults::httpCodeClientError) {
+    if (replyBody.isEmpty() || httpStatus>=CDefaults::httpCodeClientError) {
         setErrorMsg(QSL("ERROR: Yandex translator network error"));
         return QSL("ERROR:TRAN_GOOGLE_GTX_NETWORK_ERROR");
     }
 
-    QJsonDocument jdoc = QJsonDocument::fromJson(ra);
+    QJsonDocument jdoc = QJsonDocument::fromJson(replyBody);
 
     if (jdoc.isNull() || jdoc.isEmpty() || !jdoc.isArray()) {
         setErrorMsg(QSL("ERROR: Google GTX translator JSON error"));
-        qWarning() << ra;
+        qWarning() << replyBody;
         return QSL("ERROR:TRAN_GOOGLE_GTX_JSON_ERROR");
     }
 
@@ -7,7 +7,9 @@ class CGoogleGTXTranslator : public CWebAPIAbstractTranslator
 {
     Q_OBJECT
 protected:
-    QString tranStringInternal(const QString& src) override;
+    bool supportsConcurrentRequests() const override;
+    bool prepareTranslation(const QString& src, QNetworkRequest &request, QByteArray &body) override;
+    QString parseTranslation(const QByteArray &replyBody, int httpStatus, bool aborted) override;
     bool isValidCredentials() override;
 
 public:
@@ -0,0 +1,134 @@
+#include <QJsonDocument>
+#include <QJsonObject>
+#include <QJsonArray>
+#include <QRegularExpression>
+
+#include "openaiprotocol.h"
+#include "global/structures.h"
+
+namespace CDefaults {
+const auto openaiContentPlaceholder = "%%JPREADER_CONTENT%%";
+}
+
+QByteArray COpenAIProtocol::jsonString(const QString &str)
+{
+    // Let Qt escape the string, then strip array brackets
+    const QByteArray res = QJsonDocument(QJsonArray({ str })).toJson(QJsonDocument::Compact);
+    return res.mid(1,res.length()-2);
+}
+
+QString COpenAIProtocol::contentPlaceholder()
+{
+    return QString::fromLatin1(CDefaults::openaiContentPlaceholder);
+}
+
+bool COpenAIProtocol::splitBodyTemplate(const QByteArray &body, QByteArray &prefix, QByteArray &suffix)
+{
+    const QByteArray placeholder = jsonString(contentPlaceholder());
+    const auto pos = body.indexOf(placeholder);
+    if (pos < 0)
+        return false;
+
+    prefix = body.left(pos);
+    suffix = body.mid(pos + placeholder.length());
+    return true;
+}
+
+QByteArray COpenAIProtocol::spliceBody(const QByteArray &prefix, const QString &content, const QByteArray &suffix)
+{
+    const QByteArray data = jsonString(content);
+    QByteArray res;
+    res.reserve(prefix.length() + data.length() + suffix.length());
+    res.append(prefix).append(data).append(suffix);
+    return res;
+}
+
+QString COpenAIProtocol::makeBatchContent(const QStringList &sources)
+{
+    QString res;
+    for (int i = 0; i < sources.count(); i++) {
+        if (i>0)
+            res.append(u'\n');
+        res.append(QSL("[[%1]]\n%2").arg(i+1).arg(sources.at(i)));
+    }
+    return res;
+}
+
+QHash<int, QString> COpenAIProtocol::parseBatchContent(const QString &content)
+{
+    static const QRegularExpression markerRx(QSL("^[ \\t]*\\[\\[(\\d+)\\]\\][ \\t]*$"),
+                                             QRegularExpression::MultilineOption);
+
+    QHash<int,QString> res;
+    int segment = -1;
+    qsizetype segmentStart = 0;
+    auto it = markerRx.globalMatch(content);
+    while (it.hasNext()) {
+        const QRegularExpressionMatch match = it.next();
+        if (segment>0)
+            res.insert(segment,content.mid(segmentStart,match.capturedStart() - segmentStart).trimmed());
+        segment = match.captured(1).toInt();
+        segmentStart = match.capturedEnd();
+    }
+    if (segment>0)
+        res.insert(segment,content.mid(segmentStart).trimmed());
+
+    return res;
+}
+
+int COpenAIProtocol::completedBatchSegments(const QString &partialContent)
+{
+    // Segment is complete when the marker line of the next one arrives
+    static const QRegularExpression markerRx(QSL("^[ \\t]*\\[\\[\\d+\\]\\][ \\t]*\\n"),
+                                             QRegularExpression::MultilineOption);
+
+    int markers = 0;
+    auto it = markerRx.globalMatch(partialContent);
+    while (it.hasNext()) {
+        it.next();
+        markers++;
+    }
+    return qMax(0,markers - 1);
+}
+
+void COpenAIProtocol::appendStreamData(StreamState &state, const QByteArray &data)
+{
+    // Server-sent events: each 'data:' line holds one JSON chunk with content delta,
+    // partial line waits for next chunk
+    state.pendingLine.append(data);
+    qsizetype lineEnd = -1;
+    while (!state.finished && !state.failed && (lineEnd = state.pendingLine.indexOf('\n')) >= 0) {
+        const QByteArray line = state.pendingLine.left(lineEnd).trimmed();
+        state.pendingLine.remove(0,lineEnd + 1);
+        if (!line.startsWith("data:"))
+            continue;
+
+        const QByteArray payload = line.mid(5).trimmed();
+        if (payload == "[DONE]") {
+            state.finished = true;
+            break;
+        }
+
+        const QJsonObject jchunk = QJsonDocument::fromJson(payload).object();
+        const QJsonValue err = jchunk.value(QSL("error"));
+        if (err.isObject()) {
+            state.errorMessage = err.toObject().value(QSL("message")).toString();
+            state.failed = true;
+            break;
+        }
+
+        const QJsonArray choices = jchunk.value(QSL("choices")).toArray();
+        for (const auto& t : choices) {
+            const QJsonValue text = t.toObject().value(QSL("delta")).toObject().value(QSL("content"));
+            if (text.isString())
+                state.content.append(text.toString());
+        }
+    }
+}
+
+void COpenAIProtocol::parseEventStream(const QByteArray &body, StreamState &state)
+{
+    appendStreamData(state,body);
+    if (!state.pendingLine.isEmpty())
+        appendStreamData(state,QByteArrayLiteral("\n"));
+}
@@ -0,0 +1,38 @@
+#ifndef OPENAIPROTOCOL_H
+#define OPENAIPROTOCOL_H
+
+#include <QString>
+#include <QStringList>
+#include <QByteArray>
+#include <QHash>
+
+/* Chat completions wire format helpers, independent from network and global state:
+ * request body templates, numbered batch segments and server-sent events stream. */
+class COpenAIProtocol
+{
+public:
+    struct StreamState {
+        QByteArray pendingLine;
+        QString content;
+        QString errorMessage;
+        bool finished { false };
+        bool failed { false };
+    };
+
+    static QByteArray jsonString(const QString &str);
+    static QString contentPlaceholder();
+    static bool splitBodyTemplate(const QByteArray &body, QByteArray &prefix, QByteArray &suffix);
+    static QByteArray spliceBody(const QByteArray &prefix, const QString &content, const QByteArray &suffix);
+
+    static QString makeBatchContent(const QStringList &sources);
+    static QHash<int,QString> parseBatchContent(const QString &content);
+    static int completedBatchSegments(const QString &partialContent);
+
+    static void appendStreamData(StreamState &state, const QByteArray &data);
+    static void parseEventStream(const QByteArray &body, StreamState &state);
+
+private:
+    COpenAIProtocol() = delete;
+};
+
+#endif // OPENAIPROTOCOL_H
@@ -2,7 +2,10 @@
 #define COPENAITRANSLATOR_H
 
 #include <QObject>
+#include <QHash>
+#include <QVector>
 #include "webapiabstracttranslator.h"
+#include "openaiprotocol.h"
 #include "global/settings.h"
 
 
@@ -18,22 +21,51 @@ class COpenAITranslator : public CWebAPIAbstractTranslator
     double m_presencePenalty { CDefaults::openaiPresencePenalty };
     double m_frequencyPenalty { CDefaults::openaiFrequencyPenalty };
 
+    QString m_baseUrl;
+    bool m_batchParagraphs { CDefaults::openaiBatchParagraphs };
+    bool m_streaming { CDefaults::openaiStreaming };
+
+    // Request headers and JSON body around user content are built once per session
+    QNetworkRequest m_requestTemplate;
+    QByteArray m_singleBodyPrefix;
+    QByteArray m_singleBodySuffix;
+    QByteArray m_batchBodyPrefix;
+    QByteArray m_batchBodySuffix;
+
+    struct StreamState {
+        COpenAIProtocol::StreamState stream;
+        int completed { 0 };
+    };
+    bool m_batchRequests { false };
+    QVector<StreamState> m_streamStates;
+
 public:
     COpenAITranslator(QObject *parent, const CLangPair &lang, const QString &translationModel,
                       const QString &apiKey, double temperature = CDefaults::openaiTemperature,
                       double topP = CDefaults::openaiTopP, double presencePenalty = CDefaults::openaiPresencePenalty,
-                      double frequencyPenalty = CDefaults::openaiFrequencyPenalty);
+                      double frequencyPenalty = CDefaults::openaiFrequencyPenalty,
+                      const QString &baseUrl = QString(),
+                      bool batchParagraphs = CDefaults::openaiBatchParagraphs,
+                      bool streaming = CDefaults::openaiStreaming);
     bool initTran() override;
     CStructures::TranslationEngine engine() override;
+    QStringList tranStringsPrivate(const QStringList& sources) override;
 
-    static void getAvailableModels(QObject *control, const QString &apiKey);
+    static void getAvailableModels(QObject *control, const QString &apiKey, const QString &baseUrl);
     QString getModelName() const override;
 
 protected:
-    QString tranStringInternal(const QString& src) override;
+    bool supportsConcurrentRequests() const override;
+    bool prepareTranslation(const QString& src, QNetworkRequest &request, QByteArray &body) override;
+    QString parseTranslation(const QByteArray &replyBody, int httpStatus, bool aborted) override;
+    bool isStreamingTranslation() const override;
+    void streamTranslation(int index, const QByteArray &data, bool restarted) override;
     bool isValidCredentials() override;
 
 private:
+    void buildRequestTemplates();
+    QString parseStreamedContent(const QByteArray &replyBody, int httpStatus);
+    static QUrl apiUrl(const QString &baseUrl, const QString &endpoint);
 };
 
 #endif // COPENAITRANSLATOR_H
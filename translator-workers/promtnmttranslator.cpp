@@ -30,7 +30,12 @@ QUrl CPromtNmtTranslator::queryUrl(const QString &method) const
     return QUrl(QSL("%1/Services/v1/rest.svc/%2").arg(m_serverUrl,method));
 }
 
-QString CPromtNmtTranslator::tranStringInternal(const QString &src)
+bool CPromtNmtTranslator::supportsConcurrentRequests() const
+{
+    return true;
+}
+
+bool CPromtNmtTranslator::prepareTranslation(const QString &src, QNetworkRequest &request, QByteArray &body)
 {
     QUrl rqurl = queryUrl(QSL("TranslateText"));
 
@@ -44,20 +49,21 @@ QString CPromtNmtTranslator::tranStringInternal(const QString &src)
     reqtext[QSL("from")] = language().langFrom.bcp47Name();
     reqtext[QSL("to")] = language().langTo.bcp47Name();
     QJsonDocument doc(reqtext);
-    QByteArray body = doc.toJson(QJsonDocument::Compact);
+    body = doc.toJson(QJsonDocument::Compact);
 
-    bool aborted = false;
-    int status = CDefaults::httpCodeClientUnknownError;
-    auto requestMaker = [rq]() -> QNetworkRequest {
-        return rq;
-    };
-    QByteArray ra = processRequest(requestMaker,body,&status,&aborted);
+    request = rq;
+    return true;
+}
+
+QString CPromtNmtTranslator::parseTranslation(const QByteArray &replyBody, int httpStatus, bool aborted)
+{
+    QByteArray ra = replyBody;
 
     if (aborted) {
         setErrorMsg(QSL("ERROR: Promt NMT translator aborted by user request"));
         return QSL("ERROR:TRAN_PROMT_NMT_ABORTED");
     }
-    if (ra.isEmpty() || status>=CDefaults::httpCodeClientError) {
+    if (ra.isEmpty() || httpStatus>=CDefaults::httpCodeClientError) {
         setErrorMsg(tr("ERROR: Promt NMT translator network error"));
         return QSL("ERROR:TRAN_PROMT_NMT_NETWORK_ERROR");
     }
@@ -79,19 +85,19 @@ QString CPromtNmtTranslator::tranStringInternal(const QString &src)
     if (err.isString()) {
         setErrorMsg(tr("ERROR: Promt NMT translator JSON error #%1, HTTP status: %2")
                     .arg(err.toString())
-                    .arg(status));
+                    .arg(httpStatus));
         return QSL("ERROR:TRAN_PROMT_NMT_JSON_ERROR");
     }
 
-    if (status!=CDefaults::httpCodeFound) {
-        setErrorMsg(QSL("ERROR: Promt NMT translator HTTP generic error, HTTP status: %1").arg(status));
+    if (httpStatus!=CDefaults::httpCodeFound) {
+        setErrorMsg(QSL("ERROR: Promt NMT translator HTTP generic error, HTTP status: %1").arg(httpStatus));
         return QSL("ERROR:TRAN_PROMT_NMT_HTTP_ERROR");
     }
 
     QString res = jroot.value(QSL("text")).toString();
     if (res.isEmpty()) {
         setErrorMsg(QSL("ERROR: Promt NMT translator result member missing from JSON response, "
-                        "HTTP status: %1").arg(status));
+                        "HTTP status: %1").arg(httpStatus));
         return QSL("ERROR:TRAN_PROMT_NMT_RESPONSE_ERROR");
     }
 
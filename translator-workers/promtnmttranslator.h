@@ -13,7 +13,9 @@ private:
     QUrl queryUrl(const QString& method) const;
 
 protected:
-    QString tranStringInternal(const QString& src) override;
+    bool supportsConcurrentRequests() const override;
+    bool prepareTranslation(const QString& src, QNetworkRequest &request, QByteArray &body) override;
+    QString parseTranslation(const QByteArray &replyBody, int httpStatus, bool aborted) override;
     bool isValidCredentials() override;
 
 public:
@@ -0,0 +1,139 @@
+#include <QMutexLocker>
+#include <QtMath>
+#include "translatorratelimiter.h"
+#include "utils/genericfuncs.h"
+
+namespace CDefaults {
+const double rateLimiterLatencyWeight = 0.2;
+const double rateLimiterBackoffFactor = 0.5;
+const double rateLimiterLatencyBackoffFactor = 0.8;
+const double rateLimiterBaselineDrift = 0.01;
+const double rateLimiterPayloadUnit = 1024.0;
+}
+
+CTranslatorRateLimiter::CTranslatorRateLimiter()
+{
+    m_clock.start();
+}
+
+CTranslatorRateLimiter *CTranslatorRateLimiter::instance()
+{
+    static CTranslatorRateLimiter inst;
+    return &inst;
+}
+
+CTranslatorRateLimiter::EngineState &CTranslatorRateLimiter::engineState(CStructures::TranslationEngine engine,
+                                                                          qint64 now, int parallelRequests)
+{
+    auto it = m_engines.find(static_cast<int>(engine));
+    if (it == m_engines.end()) {
+        // Start from configured parallelism, AIMD only corrects it afterwards
+        EngineState state;
+        state.window = qBound(1.0,static_cast<double>(parallelRequests),CDefaults::rateLimiterMaxWindow);
+        state.lastRefill = now;
+        it = m_engines.insert(static_cast<int>(engine),state);
+    }
+
+    // Token bucket holds one second of requests at current rate
+    EngineState &state = it.value();
+    const double burst = qMax(1.0,state.rate);
+    state.tokens = qMin(burst,state.tokens + state.rate * static_cast<double>(now - state.lastRefill) / 1000.0);
+    state.lastRefill = now;
+    return state;
+}
+
+void CTranslatorRateLimiter::decrease(EngineState &state, qint64 now, double factor)
+{
+    // Decrease at most once per round trip, replies from one congested window carry the same signal
+    if (now - state.lastDecrease < static_cast<qint64>(state.roundTripAvg))
+        return;
+
+    state.window = qMax(1.0,state.window * factor);
+    state.rate = qMax(CDefaults::rateLimiterMinRate,state.rate * factor);
+    state.tokens = qMin(state.tokens,qMax(1.0,state.rate));
+    state.lastDecrease = now;
+}
+
+int CTranslatorRateLimiter::tryAcquire(CStructures::TranslationEngine engine, int parallelRequests)
+{
+    QMutexLocker locker(&m_mutex);
+    const qint64 now = m_clock.elapsed();
+    EngineState &state = engineState(engine,now,parallelRequests);
+
+    if (now < state.blockedUntil)
+        return static_cast<int>(state.blockedUntil - now);
+
+    if (state.inFlight >= qFloor(state.window))
+        return CDefaults::rateLimiterPollInterval;
+
+    if (state.tokens < 1.0)
+        return qMax(1,qCeil((1.0 - state.tokens) * 1000.0 / state.rate));
+
+    state.tokens -= 1.0;
+    state.inFlight++;
+    return 0;
+}
+
+void CTranslatorRateLimiter::release(CStructures::TranslationEngine engine, qint64 latency, qint64 payloadSize,
+                                     int httpStatus, qint64 retryAfter)
+{
+    QMutexLocker locker(&m_mutex);
+    const qint64 now = m_clock.elapsed();
+    EngineState &state = engineState(engine,now);
+    state.inFlight = qMax(0,state.inFlight - 1);
+
+    if (httpStatus == CDefaults::httpCodeTooManyRequests
+            || httpStatus == CDefaults::httpCodeClientUnknownError
+            || httpStatus >= CDefaults::httpCodeServerError) {
+        decrease(state,now,CDefaults::rateLimiterBackoffFactor);
+        if (retryAfter > 0)
+            state.blockedUntil = qMax(state.blockedUntil,now + retryAfter);
+        return;
+    }
+
+    if (httpStatus >= CDefaults::httpCodeClientError)
+        return; // request errors say nothing about provider load
+
+    const double roundTrip = static_cast<double>(latency);
+    if (state.roundTripAvg <= 0.0) {
+        state.roundTripAvg = roundTrip;
+    } else {
+        state.roundTripAvg += CDefaults::rateLimiterLatencyWeight * (roundTrip - state.roundTripAvg);
+    }
+
+    // Provider time grows with text length, so congestion is judged by latency per payload unit.
+    // Requests smaller than one unit are dominated by fixed overhead and are counted as one unit.
+    const double units = qMax(1.0,static_cast<double>(payloadSize) / CDefaults::rateLimiterPayloadUnit);
+    const double normalized = roundTrip / units;
+
+    // Baseline slowly drifts up, so changed routes don't look like congestion forever
+    if (state.latencyMin < 0.0) {
+        state.latencyMin = normalized;
+    } else {
+        state.latencyMin = qMin(normalized,
+                                state.latencyMin * (1.0 + CDefaults::rateLimiterBaselineDrift) + 1.0);
+    }
+    if (state.latencyAvg <= 0.0) {
+        state.latencyAvg = normalized;
+    } else {
+        state.latencyAvg += CDefaults::rateLimiterLatencyWeight * (normalized - state.latencyAvg);
+    }
+
+    // Growing latency means queueing at provider side, back off before it starts throttling
+    const double baseline = qMax(1.0,state.latencyMin);
+    if (state.latencyAvg > CDefaults::rateLimiterCongestionFactor * baseline) {
+        decrease(state,now,CDefaults::rateLimiterLatencyBackoffFactor);
+        return;
+    }
+
+    // Additive increase by about one request per window round
+    state.window = qMin(CDefaults::rateLimiterMaxWindow,state.window + 1.0 / state.window);
+    state.rate = qMin(CDefaults::rateLimiterMaxRate,state.rate + CDefaults::rateLimiterRateIncrease / state.window);
+}
+
+void CTranslatorRateLimiter::cancel(CStructures::TranslationEngine engine)
+{
+    QMutexLocker locker(&m_mutex);
+    EngineState &state = engineState(engine,m_clock.elapsed());
+    state.inFlight = qMax(0,state.inFlight - 1);
+}
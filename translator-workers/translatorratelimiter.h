@@ -0,0 +1,56 @@
+#ifndef TRANSLATORRATELIMITER_H
+#define TRANSLATORRATELIMITER_H
+
+#include <QHash>
+#include <QMutex>
+#include <QElapsedTimer>
+#include "global/structures.h"
+
+namespace CDefaults {
+const double rateLimiterInitialRate = 2.0;
+const double rateLimiterMinRate = 0.2;
+const double rateLimiterMaxRate = 50.0;
+const double rateLimiterRateIncrease = 0.5;
+const double rateLimiterMaxWindow = 16.0;
+const double rateLimiterCongestionFactor = 2.0;
+const int rateLimiterPollInterval = 50;
+}
+
+class CTranslatorRateLimiter
+{
+    Q_DISABLE_COPY(CTranslatorRateLimiter)
+public:
+    static CTranslatorRateLimiter* instance();
+
+    int tryAcquire(CStructures::TranslationEngine engine, int parallelRequests);
+    void release(CStructures::TranslationEngine engine, qint64 latency, qint64 payloadSize,
+                 int httpStatus, qint64 retryAfter);
+    void cancel(CStructures::TranslationEngine engine);
+
+private:
+    struct EngineState {
+        double tokens { CDefaults::rateLimiterInitialRate };
+        double rate { CDefaults::rateLimiterInitialRate };
+        double window { 1.0 };
+        int inFlight { 0 };
+        qint64 lastRefill { 0L };
+        qint64 lastDecrease { 0L };
+        qint64 blockedUntil { 0L };
+        double latencyMin { -1.0 };
+        double latencyAvg { 0.0 };
+        double roundTripAvg { 0.0 };
+    };
+
+    QMutex m_mutex;
+    QElapsedTimer m_clock;
+    QHash<int,EngineState> m_engines;
+
+    CTranslatorRateLimiter();
+    ~CTranslatorRateLimiter() = default;
+
+    EngineState& engineState(CStructures::TranslationEngine engine, qint64 now, int parallelRequests = 1);
+    static void decrease(EngineState& state, qint64 now, double factor);
+
+};
+
+#endif // TRANSLATORRATELIMITER_H
@@ -1,16 +1,39 @@
 #include <QNetworkReply>
 #include <QEventLoop>
 #include <QTimer>
+#include <QPointer>
+#include <QDateTime>
+#include <QTimeZone>
+#include <QLocale>
+#include <QElapsedTimer>
 #include <QNetworkCookie>
 #include <QJsonDocument>
 #include <QJsonObject>
 
 #include "webapiabstracttranslator.h"
+#include "translatorratelimiter.h"
 #include "global/control.h"
 #include "global/network.h"
 #include "utils/genericfuncs.h"
 #include "utils/specwidgets.h"
 
+struct CWebAPIAbstractTranslator::PendingRequest
+{
+    std::function<QNetworkRequest()> requestFunc;
+    QByteArray body;
+    ReplyHandler handler;
+    StreamHandler streamHandler;
+    QByteArray streamed;
+    QPointer<QNetworkReply> reply;
+    QTimer retryTimer;
+    QElapsedTimer sent;
+    CStructures::TranslationEngine engine { CStructures::teAtlas };
+    int retries { 0 };
+    int delayFrac { 1 };
+    bool permitted { false };
+    bool streamRestarted { false };
+};
+
 CWebAPIAbstractTranslator::CWebAPIAbstractTranslator(QObject *parent, const CLangPair &lang)
     : CAbstractTranslator (parent, lang)
 {
@@ -18,6 +41,7 @@ CWebAPIAbstractTranslator::CWebAPIAbstractTranslator(QObject *parent, const CLan
 
 CWebAPIAbstractTranslator::~CWebAPIAbstractTranslator()
 {
+    dropRequests();
     deleteNAM();
 }
 
@@ -28,6 +52,13 @@ QString CWebAPIAbstractTranslator::tranStringPrivate(const QString& src)
         return QSL("ERROR:TRAN_NOT_READY");
     }
 
+    if (supportsConcurrentRequests()) {
+        const QStringList res = translateConcurrently(splitLongText(src));
+        if (!getErrorMsg().isEmpty())
+            return res.last();
+        return res.join(QString());
+    }
+
     QString res;
     for (const QString &str : splitLongText(src)) {
         QString s = tranStringInternal(str);
@@ -40,31 +71,124 @@ QString CWebAPIAbstractTranslator::tranStringPrivate(const QString& src)
     return res;
 }
 
-bool CWebAPIAbstractTranslator::waitForReply(QNetworkReply *reply, int *httpStatus)
+QStringList CWebAPIAbstractTranslator::tranStringsPrivate(const QStringList &sources)
 {
-    QEventLoop eventLoop;
-    QTimer timer;
+    if (!supportsConcurrentRequests())
+        return CAbstractTranslator::tranStringsPrivate(sources);
 
-    connect(reply, &QNetworkReply::finished, &eventLoop, &QEventLoop::quit);
-    connect(&timer, &QTimer::timeout, &eventLoop, &QEventLoop::quit);
-    timer.setSingleShot(true);
-    timer.start(CDefaults::translatorConnectionTimeout);
+    if (!isReady()) {
+        setErrorMsg(tr("ERROR: Translator not ready"));
+        return QStringList({ QSL("ERROR:TRAN_NOT_READY") });
+    }
 
-    eventLoop.exec();
+    // Chunks of all strings share one window of outstanding requests
+    QStringList chunks;
+    QVector<int> chunkOwner;
+    for (int i = 0; i < sources.count(); i++) {
+        if (sources.at(i).isEmpty()) continue;
+        for (const QString &str : splitLongText(sources.at(i))) {
+            chunks.append(str);
+            chunkOwner.append(i);
+        }
+    }
 
-    timer.stop();
+    const QStringList translated = translateConcurrently(chunks);
+    const int failedChunk = getErrorMsg().isEmpty() ? -1 : translated.count() - 1;
 
-    *httpStatus = CGenericFuncs::getHttpStatusFromReply(reply);
+    QStringList res;
+    res.reserve(sources.count());
+    int chunk = 0;
+    for (int i = 0; i < sources.count(); i++) {
+        if (sources.at(i).isEmpty()) {
+            res.append(sources.at(i));
+            continue;
+        }
+        QString str;
+        for (; chunk < chunkOwner.count() && chunkOwner.at(chunk) == i; chunk++) {
+            if (chunk == failedChunk) {
+                str = translated.at(chunk);
+                break;
+            }
+            str.append(translated.at(chunk));
+        }
+        res.append(str);
+        if (failedChunk >= 0 && chunk == failedChunk)
+            break;
+    }
+    return res;
+}
+
+QStringList CWebAPIAbstractTranslator::translateConcurrently(const QStringList &sources)
+{
+    const int count = sources.count();
+    QStringList results;
+    results.reserve(count);
+    for (int i = 0; i < count; i++)
+        results.append(QString());
+    QStringList errors = results;
+
+    int nextSource = 0;
+    int outstanding = 0;
+    bool stopped = false;
+
+    // Handlers are called in this thread from waitForRequests, so locals outlive every request
+    std::function<void()> postNext;
+    postNext = [&]() {
+        while (!stopped && !isAborted() && outstanding < CDefaults::webAPIMaxOutstandingRequests
+               && nextSource < count) {
+            const int idx = nextSource++;
+            QNetworkRequest rq;
+            QByteArray body;
+            clearErrorMsg();
+            if (!prepareTranslation(sources.at(idx),rq,body)) {
+                errors[idx] = getErrorMsg();
+                if (errors.at(idx).isEmpty())
+                    errors[idx] = tr("ERROR: Unable to prepare translator request");
+                results[idx] = QSL("ERROR:TRAN_REQUEST_ERROR");
+                stopped = true;
+                break;
+            }
+
+            outstanding++;
+            auto requestMaker = [rq]() -> QNetworkRequest {
+                return rq;
+            };
+            StreamHandler streamHandler;
+            if (isStreamingTranslation()) {
+                streamHandler = [this,idx](const QByteArray &data, bool restarted){
+                    streamTranslation(idx,data,restarted);
+                };
+            }
+            postRequest(requestMaker,body,[&,idx](const QByteArray &replyBody, int httpStatus, bool aborted){
+                outstanding--;
+                clearErrorMsg();
+                results[idx] = parseTranslation(replyBody,httpStatus,aborted);
+                if (!getErrorMsg().isEmpty()) {
+                    errors[idx] = getErrorMsg();
+                    stopped = true;
+                }
+                postNext();
+            },streamHandler);
+        }
+    };
 
-    bool queryOk = reply->isFinished() && (reply->bytesAvailable()>0) && (reply->error()==QNetworkReply::NoError);
+    postNext();
+    waitForRequests();
 
-    if (!queryOk) {
-        qCritical() << "WebAPI query failed: " << reply->url();
-        qCritical() << " --- Error: " << reply->error() << ", " << reply->errorString();
-        qCritical() << " --- HTTP status code : " << (*httpStatus);
+    clearErrorMsg();
+    for (int i = 0; i < nextSource; i++) {
+        if (!errors.at(i).isEmpty()) {
+            setErrorMsg(errors.at(i));
+            return results.mid(0,i+1);
+        }
+    }
+    if (nextSource < count) {
+        setErrorMsg(tr("ERROR: Translator aborted by user request"));
+        results = results.mid(0,nextSource);
+        results.append(QSL("ERROR:TRAN_ABORTED"));
     }
 
-    return queryOk;
+    return results;
 }
 
 void CWebAPIAbstractTranslator::initNAM()
@@ -93,79 +217,328 @@ QByteArray CWebAPIAbstractTranslator::processRequest(const std::function<QNetwor
                                                      int *httpStatus,
                                                      bool *aborted)
 {
-    const QString clName = QString::fromLatin1(metaObject()->className());
-    int retries = 0;
-    int delayFrac = 1;
-    *httpStatus = CDefaults::httpCodeClientUnknownError;
     QByteArray replyBody;
-    while (retries < getTranslatorRetryCount() && !isAborted()) {
-        QScopedPointer<QNetworkReply,QScopedPointerDeleteLater> rpl(nam()->post(requestFunc(),body));
-        Q_EMIT translatorBytesTransferred(body.size());
+    *httpStatus = CDefaults::httpCodeClientUnknownError;
+    *aborted = false;
 
-        bool replyOk = waitForReply(rpl.data(),httpStatus);
-        replyBody = rpl->readAll();
+    postRequest(requestFunc,body,[&replyBody,httpStatus,aborted]
+                (const QByteArray &rplBody, int rplStatus, bool rplAborted){
+        replyBody = rplBody;
+        *httpStatus = rplStatus;
+        *aborted = rplAborted;
+    });
+    waitForRequests();
 
-        if (!replyOk) {
-            qWarning() << QSL("%1 translator network error").arg(clName);
-        }
+    *aborted = (*aborted || isAborted());
 
-        if (*httpStatus == CDefaults::httpCodeTooManyRequests) {
-            qWarning() << QSL("%1 translator throttling, delay and retry #%2.")
-                          .arg(clName)
-                          .arg(retries);
+    return replyBody;
+}
 
-        } else if (*httpStatus == CDefaults::httpCodeClientUnknownError) {
-            qWarning() << QSL("%1 translator no HTTP status, delay and retry #%2.")
-                          .arg(clName)
-                          .arg(retries);
+void CWebAPIAbstractTranslator::postRequest(const std::function<QNetworkRequest()> &requestFunc,
+                                            const QByteArray &body, const ReplyHandler &handler,
+                                            const StreamHandler &streamHandler)
+{
+    auto request = QSharedPointer<PendingRequest>::create();
+    request->requestFunc = requestFunc;
+    request->body = body;
+    request->handler = handler;
+    request->streamHandler = streamHandler;
+    request->engine = engine();
+    request->retryTimer.setSingleShot(true);
+
+    // Retry delays are timers, so abortion never waits for a sleep to end
+    const QWeakPointer<PendingRequest> weakRequest(request);
+    connect(&(request->retryTimer),&QTimer::timeout,this,[this,weakRequest](){
+        const auto request = weakRequest.toStrongRef();
+        if (request)
+            sendRequest(request);
+    });
+
+    m_requests.append(request);
+    sendRequest(request);
+}
 
-        } else if (*httpStatus == CDefaults::httpQuotaExceeded) {
-            qWarning() << QSL("%1 translator quota exceeded, aborting. HTTP status: %2.")
-                          .arg(clName)
-                          .arg(*httpStatus);
-            break;
+void CWebAPIAbstractTranslator::sendRequest(const QSharedPointer<PendingRequest> &request)
+{
+    if (isAborted() || m_nam == nullptr) {
+        finishRequest(request,QByteArray(),CDefaults::httpCodeClientUnknownError,isAborted());
+        return;
+    }
+
+    // Engine budget is shared by all translator instances in all threads
+    const int permitDelay = CTranslatorRateLimiter::instance()->tryAcquire(
+                                request->engine,gSet->settings()->translatorParallelRequests);
+    if (permitDelay > 0) {
+        request->retryTimer.start(permitDelay);
+        return;
+    }
+    request->permitted = true;
+    request->sent.start();
+
+    QNetworkRequest rq = request->requestFunc();
+    rq.setTransferTimeout(CDefaults::translatorConnectionTimeout);
+    request->reply = m_nam->post(rq,request->body);
+    request->streamed.clear();
+    request->streamRestarted = true;
+    Q_EMIT translatorBytesTransferred(request->body.size());
+
+    const QWeakPointer<PendingRequest> weakRequest(request);
+    if (request->streamHandler) {
+        // Streamed data is passed to handler as it arrives and collected for the final reply
+        connect(request->reply.data(),&QNetworkReply::readyRead,this,[weakRequest](){
+            const auto request = weakRequest.toStrongRef();
+            if (!request || !request->reply) return;
+            const QByteArray data = request->reply->readAll();
+            request->streamed.append(data);
+            request->streamHandler(data,request->streamRestarted);
+            request->streamRestarted = false;
+        });
+    }
+    connect(request->reply.data(),&QNetworkReply::finished,this,[this,weakRequest](){
+        const auto request = weakRequest.toStrongRef();
+        if (request)
+            replyFinished(request);
+    });
+}
+
+void CWebAPIAbstractTranslator::replyFinished(const QSharedPointer<PendingRequest> &request)
+{
+    QScopedPointer<QNetworkReply,QScopedPointerDeleteLater> rpl(request->reply.data());
+    request->reply.clear();
+    if (rpl.isNull()) return;
+
+    const QString clName = QString::fromLatin1(metaObject()->className());
+    const int httpStatus = CGenericFuncs::getHttpStatusFromReply(rpl.data());
+    QByteArray replyBody = request->streamed;
+    replyBody.append(rpl->readAll());
+    request->streamed.clear();
+    const bool replyOk = !replyBody.isEmpty() && (rpl->error()==QNetworkReply::NoError);
+
+    const qint64 retryAfter = retryAfterDelay(rpl.data());
+    releasePermit(*request,httpStatus,retryAfter);
+
+    if (!replyOk) {
+        qCritical() << "WebAPI query failed: " << rpl->url();
+        qCritical() << " --- Error: " << rpl->error() << ", " << rpl->errorString();
+        qCritical() << " --- HTTP status code : " << httpStatus;
+        qWarning() << QSL("%1 translator network error").arg(clName);
+    }
 
-        } else if (*httpStatus == CDefaults::httpCodeClientError && rpl->url().toString().contains(QSL("aliyun"))) {
-            // signature error from AliCloud, try again
-            QJsonDocument doc;
-            bool noRetry = true;
-            if (!replyBody.isEmpty()) {
-                doc = QJsonDocument::fromJson(replyBody);
-                if (!doc.isEmpty()) {
-                    if (doc.object().value(QSL("Code")).toString() == QSL("SignatureDoesNotMatch")) {
-                        qWarning() << QSL("%1 translator Alibaba Cloud signature auth error, delay and retry #%2.")
-                                      .arg(clName)
-                                      .arg(retries);
-                        noRetry = false;
-                        delayFrac = CDefaults::tranAliDelayFrac;
-                    }
+    if (isAborted()) {
+        finishRequest(request,replyBody,httpStatus,true);
+        return;
+    }
+
+    bool retry = false;
+    if (httpStatus == CDefaults::httpCodeTooManyRequests) {
+        qWarning() << QSL("%1 translator throttling, delay and retry #%2.")
+                      .arg(clName)
+                      .arg(request->retries);
+        retry = true;
+
+    } else if (httpStatus == CDefaults::httpCodeClientUnknownError) {
+        qWarning() << QSL("%1 translator no HTTP status, delay and retry #%2.")
+                      .arg(clName)
+                      .arg(request->retries);
+        retry = true;
+
+    } else if (httpStatus == CDefaults::httpQuotaExceeded) {
+        qWarning() << QSL("%1 translator quota exceeded, aborting. HTTP status: %2.")
+                      .arg(clName)
+                      .arg(httpStatus);
+
+    } else if (httpStatus == CDefaults::httpCodeClientError && rpl->url().toString().contains(QSL("aliyun"))) {
+        // signature error from AliCloud, try again
+        if (!replyBody.isEmpty()) {
+            const QJsonDocument doc = QJsonDocument::fromJson(replyBody);
+            if (!doc.isEmpty()) {
+                if (doc.object().value(QSL("Code")).toString() == QSL("SignatureDoesNotMatch")) {
+                    qWarning() << QSL("%1 translator Alibaba Cloud signature auth error, delay and retry #%2.")
+                                  .arg(clName)
+                                  .arg(request->retries);
+                    retry = true;
+                    request->delayFrac = CDefaults::tranAliDelayFrac;
                 }
             }
-            if (noRetry) {
-                qWarning() << QSL("%1 translator bad request or credentials, aborting. HTTP status: %2.")
-                              .arg(clName)
-                              .arg(*httpStatus);
-                break;
-            }
-
-        } else if (*httpStatus >= CDefaults::httpCodeClientError) {
+        }
+        if (!retry) {
             qWarning() << QSL("%1 translator bad request or credentials, aborting. HTTP status: %2.")
                           .arg(clName)
-                          .arg(*httpStatus);
-            break;
+                          .arg(httpStatus);
+        }
 
-        } else if (replyOk) {
-            break;
+    } else if (httpStatus >= CDefaults::httpCodeClientError) {
+        qWarning() << QSL("%1 translator bad request or credentials, aborting. HTTP status: %2.")
+                      .arg(clName)
+                      .arg(httpStatus);
+
+    } else if (!replyOk) {
+        retry = true;
+    }
+
+    request->retries++;
+    if (!retry || request->retries >= getTranslatorRetryCount()) {
+        finishRequest(request,replyBody,httpStatus,false);
+        return;
+    }
+
+    request->retryTimer.start(retryDelay(*request,retryAfter));
+}
+
+void CWebAPIAbstractTranslator::finishRequest(const QSharedPointer<PendingRequest> &request,
+                                              const QByteArray &replyBody, int httpStatus, bool aborted)
+{
+    request->retryTimer.stop();
+    if (!m_requests.removeOne(request))
+        return;
+
+    if (request->handler)
+        request->handler(replyBody,httpStatus,aborted);
+
+    if (m_requests.isEmpty() && m_waitLoop)
+        m_waitLoop->quit();
+}
+
+qint64 CWebAPIAbstractTranslator::retryAfterDelay(QNetworkReply *reply) const
+{
+    // Retry-After holds either delay in seconds or HTTP date
+    const QByteArray retryAfter = reply->rawHeader("Retry-After").trimmed();
+    if (retryAfter.isEmpty())
+        return -1L;
+
+    bool ok = false;
+    qint64 delay = retryAfter.toLongLong(&ok) * 1000L;
+    if (!ok) {
+        const QDateTime date = QLocale::c().toDateTime(QString::fromLatin1(retryAfter),
+                                                       QSL("ddd, dd MMM yyyy hh:mm:ss 'GMT'"));
+        if (!date.isValid())
+            return -1L;
+
+        delay = QDateTime::currentDateTimeUtc().msecsTo(QDateTime(date.date(),date.time(),
+                                                                  QTimeZone::utc()));
+    }
+    return qBound(static_cast<qint64>(0),delay,static_cast<qint64>(CDefaults::tranMaxRetryAfterDelay));
+}
+
+int CWebAPIAbstractTranslator::retryDelay(const PendingRequest &request, qint64 retryAfter)
+{
+    if (retryAfter >= 0)
+        return static_cast<int>(retryAfter);
+
+    // Exponential backoff with jitter
+    const int maxShift = 5;
+    const int maxDelay = qMin(CDefaults::tranMaxRetryDelay,
+                              CDefaults::tranBaseRetryDelay << qMin(request.retries,maxShift))
+                         / request.delayFrac;
+    return static_cast<int>(getRandomDelay(maxDelay / 2, maxDelay));
+}
+
+void CWebAPIAbstractTranslator::releasePermit(PendingRequest &request, int httpStatus, qint64 retryAfter)
+{
+    if (!request.permitted)
+        return;
+
+    request.permitted = false;
+    if (httpStatus < 0) {
+        CTranslatorRateLimiter::instance()->cancel(request.engine);
+    } else {
+        CTranslatorRateLimiter::instance()->release(request.engine,request.sent.elapsed(),
+                                                    request.body.size(),httpStatus,retryAfter);
+    }
+}
+
+bool CWebAPIAbstractTranslator::waitForRequests()
+{
+    if (!m_requests.isEmpty()) {
+        QEventLoop eventLoop;
+        QTimer abortTimer;
+        connect(&abortTimer,&QTimer::timeout,this,[this](){
+            if (isAborted())
+                abortRequests();
+        });
+        abortTimer.start(CDefaults::webAPIAbortPollInterval);
+
+        QEventLoop* outerLoop = m_waitLoop;
+        m_waitLoop = &eventLoop;
+        eventLoop.exec();
+        m_waitLoop = outerLoop;
+    }
+
+    return !isAborted();
+}
+
+void CWebAPIAbstractTranslator::abortRequests()
+{
+    const auto requests = m_requests;
+    for (const auto &request : requests) {
+        request->retryTimer.stop();
+        releasePermit(*request,-1,-1L);
+        if (request->reply) {
+            QNetworkReply* reply = request->reply.data();
+            request->reply.clear();
+            reply->disconnect(this);
+            reply->abort();
+            reply->deleteLater();
         }
+        finishRequest(request,QByteArray(),CDefaults::httpCodeClientUnknownError,true);
+    }
+}
 
-        CGenericFuncs::processedMSleep(getRandomDelay(CDefaults::tranMinRetryDelay/delayFrac,
-                                                      CDefaults::tranMaxRetryDelay/delayFrac));
-        retries++;
+void CWebAPIAbstractTranslator::dropRequests()
+{
+    for (const auto &request : qAsConst(m_requests)) {
+        request->retryTimer.stop();
+        releasePermit(*request,-1,-1L);
+        if (request->reply) {
+            request->reply->disconnect(this);
+            request->reply->abort();
+            request->reply->deleteLater();
+        }
     }
+    m_requests.clear();
+}
 
-    *aborted = isAborted();
+QString CWebAPIAbstractTranslator::tranStringInternal(const QString &src)
+{
+    return translateConcurrently(QStringList(src)).value(0);
+}
 
-    return replyBody;
+bool CWebAPIAbstractTranslator::supportsConcurrentRequests() const
+{
+    return false;
+}
+
+bool CWebAPIAbstractTranslator::prepareTranslation(const QString &src, QNetworkRequest &request,
+                                                   QByteArray &body)
+{
+    Q_UNUSED(src)
+    Q_UNUSED(request)
+    Q_UNUSED(body)
+
+    setErrorMsg(tr("ERROR: Translator does not support request preparation"));
+    return false;
+}
+
+QString CWebAPIAbstractTranslator::parseTranslation(const QByteArray &replyBody, int httpStatus, bool aborted)
+{
+    Q_UNUSED(replyBody)
+    Q_UNUSED(httpStatus)
+    Q_UNUSED(aborted)
+
+    setErrorMsg(tr("ERROR: Translator does not support reply parsing"));
+    return QSL("ERROR:TRAN_REPLY_ERROR");
+}
+
+bool CWebAPIAbstractTranslator::isStreamingTranslation() const
+{
+    return false;
+}
+
+void CWebAPIAbstractTranslator::streamTranslation(int index, const QByteArray &data, bool restarted)
+{
+    Q_UNUSED(index)
+    Q_UNUSED(data)
+    Q_UNUSED(restarted)
 }
 
 void CWebAPIAbstractTranslator::clearCredentials()
@@ -183,6 +556,7 @@ void CWebAPIAbstractTranslator::doneTranPrivate(bool lazyClose)
 {
     Q_UNUSED(lazyClose)
 
+    abortRequests();
     clearCredentials();
     deleteNAM();
 }
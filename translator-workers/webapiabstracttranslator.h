@@ -1,36 +1,75 @@
 #ifndef WEBAPIABSTRACTTRANSLATOR_H
 #define WEBAPIABSTRACTTRANSLATOR_H
 
+#include <functional>
 #include <QNetworkAccessManager>
+#include <QNetworkRequest>
+#include <QSharedPointer>
 #include <QString>
 #include "abstracttranslator.h"
 
+class QEventLoop;
+
+namespace CDefaults {
+const int webAPIMaxOutstandingRequests = 6;
+const int webAPIAbortPollInterval = 100;
+const int tranBaseRetryDelay = 1000;
+const int tranMaxRetryAfterDelay = 120000;
+}
+
 class CWebAPIAbstractTranslator : public CAbstractTranslator
 {
     Q_OBJECT
 protected:
+    using ReplyHandler = std::function<void(const QByteArray &replyBody, int httpStatus, bool aborted)>;
+    using StreamHandler = std::function<void(const QByteArray &data, bool restarted)>;
+
     void initNAM();
     QNetworkAccessManager* nam() { return m_nam; }
     QByteArray processRequest(const std::function<QNetworkRequest()> &requestFunc,
                               const QByteArray &body, int *httpStatus, bool* aborted);
 
-    virtual QString tranStringInternal(const QString& src) = 0;
+    // Asynchronous request engine: handler is called in translator thread after final attempt
+    void postRequest(const std::function<QNetworkRequest()> &requestFunc, const QByteArray &body,
+                     const ReplyHandler &handler, const StreamHandler &streamHandler = StreamHandler());
+    bool waitForRequests();
+    void abortRequests();
+    QStringList translateConcurrently(const QStringList &sources);
+
+    virtual QString tranStringInternal(const QString& src);
+    virtual bool supportsConcurrentRequests() const;
+    virtual bool prepareTranslation(const QString& src, QNetworkRequest &request, QByteArray &body);
+    virtual QString parseTranslation(const QByteArray &replyBody, int httpStatus, bool aborted);
+    virtual bool isStreamingTranslation() const;
+    virtual void streamTranslation(int index, const QByteArray &data, bool restarted);
     virtual void clearCredentials();
     virtual bool isValidCredentials() = 0;
 
 private:
+    struct PendingRequest;
+
     QNetworkAccessManager *m_nam { nullptr };
+    QList<QSharedPointer<PendingRequest> > m_requests;
+    QEventLoop *m_waitLoop { nullptr };
 
     Q_DISABLE_COPY(CWebAPIAbstractTranslator)
 
     void deleteNAM();
-    bool waitForReply(QNetworkReply* reply, int *httpStatus);
+    void dropRequests();
+    void sendRequest(const QSharedPointer<PendingRequest> &request);
+    void replyFinished(const QSharedPointer<PendingRequest> &request);
+    void finishRequest(const QSharedPointer<PendingRequest> &request, const QByteArray &replyBody,
+                       int httpStatus, bool aborted);
+    qint64 retryAfterDelay(QNetworkReply *reply) const;
+    int retryDelay(const PendingRequest &request, qint64 retryAfter);
+    void releasePermit(PendingRequest &request, int httpStatus, qint64 retryAfter);
 
 public:
     CWebAPIAbstractTranslator(QObject *parent, const CLangPair &lang);
     ~CWebAPIAbstractTranslator() override;
 
     QString tranStringPrivate(const QString& src) override;
+    QStringList tranStringsPrivate(const QStringList& sources) override;
     void doneTranPrivate(bool lazyClose) override;
     bool isReady() override;
 
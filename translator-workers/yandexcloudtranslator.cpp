@@ -26,7 +26,12 @@ CStructures::TranslationEngine CYandexCloudTranslator::engine()
     return CStructures::teYandexCloud;
 }
 
-QString CYandexCloudTranslator::tranStringInternal(const QString &src)
+bool CYandexCloudTranslator::supportsConcurrentRequests() const
+{
+    return true;
+}
+
+bool CYandexCloudTranslator::prepareTranslation(const QString &src, QNetworkRequest &request, QByteArray &body)
 {
     QUrl rqurl = QUrl(QSL("https://translate.api.cloud.yandex.net/translate/v2/translate"));
 
@@ -43,25 +48,24 @@ QString CYandexCloudTranslator::tranStringInternal(const QString &src)
     QJsonArray texts({ src });
     reqtext[QSL("texts")] = texts;
     QJsonDocument doc(reqtext);
-    QByteArray body = doc.toJson(QJsonDocument::Compact);
+    body = doc.toJson(QJsonDocument::Compact);
 
-    bool aborted = false;
-    int status = CDefaults::httpCodeClientUnknownError;
-    auto requestMaker = [rq]() -> QNetworkRequest {
-        return rq;
-    };
-    QByteArray ra = processRequest(requestMaker,body,&status,&aborted);
+    request = rq;
+    return true;
+}
 
+QString CYandexCloudTranslator::parseTranslation(const QByteArray &replyBody, int httpStatus, bool aborted)
+{
     if (aborted) {
         setErrorMsg(QSL("ERROR: Yandex Cloud translator aborted by user request"));
         return QSL("ERROR:TRAN_YANDEX_CLOUD_ABORTED");
     }
-    if (ra.isEmpty() || status>=CDefaults::httpCodeClientError) {
+    if (replyBody.isEmpty() || httpStatus>=CDefaults::httpCodeClientError) {
         setErrorMsg(tr("ERROR: Yandex Cloud translator network error"));
         return QSL("ERROR:TRAN_YANDEX_CLOUD_NETWORK_ERROR");
     }
 
-    QJsonDocument jdoc = QJsonDocument::fromJson(ra);
+    QJsonDocument jdoc = QJsonDocument::fromJson(replyBody);
 
     if (jdoc.isNull() || jdoc.isEmpty()) {
         setErrorMsg(tr("ERROR: Yandex Cloud translator JSON error"));
@@ -74,19 +78,19 @@ QString CYandexCloudTranslator::tranStringInternal(const QString &src)
     if (err.isString()) {
         setErrorMsg(tr("ERROR: Yandex Cloud translator JSON error #%1: %2, HTTP status: %3")
                     .arg(errCode.toString(),err.toString())
-                    .arg(status));
+                    .arg(httpStatus));
         return QSL("ERROR:TRAN_YANDEX_CLOUD_JSON_ERROR");
     }
 
-    if (status!=CDefaults::httpCodeFound) {
-        setErrorMsg(QSL("ERROR: Yandex Cloud translator HTTP generic error, HTTP status: %1").arg(status));
+    if (httpStatus!=CDefaults::httpCodeFound) {
+        setErrorMsg(QSL("ERROR: Yandex Cloud translator HTTP generic error, HTTP status: %1").arg(httpStatus));
         return QSL("ERROR:TRAN_YANDEX_CLOUD_HTTP_ERROR");
     }
 
     const QJsonArray translations = jroot.value(QSL("translations")).toArray();
     if (translations.isEmpty()) {
         setErrorMsg(QSL("ERROR: Yandex Cloud translator 'translations' member missing from JSON response, "
-                        "HTTP status: %1").arg(status));
+                        "HTTP status: %1").arg(httpStatus));
         return QSL("ERROR:TRAN_YANDEX_CLOUD_RESPONSE_ERROR");
     }
 
@@ -4,6 +4,7 @@
 #include <QRegularExpression>
 #include "translator.h"
 #include "translatorcache.h"
+#include "translatorbatch.h"
 #include "translator-workers/atlastranslator.h"
 #include "utils/genericfuncs.h"
 #include "global/control.h"
@@ -17,6 +18,8 @@ CTranslator::CTranslator(QObject* parent, const QString& sourceHtml,
     : CAbstractThreadWorker(parent),
       m_retryCount(gSet->settings()->translatorRetryCount),
       m_tokensMaxCountCombined(gSet->settings()->tokensMaxCountCombined),
+      m_parallelRequests(gSet->settings()->translatorParallelRequests),
+      m_batchSize(gSet->settings()->translatorBatchSize),
       m_useOverrideTransFont(gSet->actions()->useOverrideTransFont()),
       m_forceFontColor(gSet->actions()->forceFontColor()),
       m_translationEngine(engine),
@@ -40,7 +43,9 @@ bool CTranslator::translateDocument(const QString &srcHtml, QString &dstHtml)
         m_tran.reset(CAbstractTranslator::translatorFactory(this, m_translationEngine, m_langPair));
     }
 
-    if (!m_tran || !m_tran->initTran()) {
+    // Batch engine initializes its own translators, m_tran only provides engine properties then
+    const bool batching = CTranslatorBatchEngine::isBatchingSupported(m_translationEngine,m_parallelRequests);
+    if (!m_tran || (!batching && !m_tran->initTran())) {
         dstHtml=tr("Unable to initialize translation engine.");
         qCritical() << tr("Unable to initialize translation engine.");
         return false;
@@ -65,6 +70,7 @@ bool CTranslator::translateDocument(const QString &srcHtml, QString &dstHtml)
         dumpPage(token,QSL("2-converted"),doc);
 
     m_translatorFailed = false;
+    m_batchError.clear();
     m_textNodesCnt=0;
     m_metaSrcUrl.clear();
     examineNode(doc,PXPreprocess);
@@ -76,7 +82,21 @@ bool CTranslator::translateDocument(const QString &srcHtml, QString &dstHtml)
         dumpPage(token,QSL("4-calculated"),doc);
 
     m_textNodesProgress=0;
+    if (batching) {
+        // Gather all text fragments first, translate them concurrently, then apply results in document order
+        m_batchSources.clear();
+        m_batchResults.clear();
+        m_batchMode = BMCollect;
+        examineNode(doc,PXTranslate);
+        if (!m_translatorFailed && !translateCollectedBatches())
+            m_translatorFailed = true;
+        m_batchMode = BMApply;
+        m_textNodesProgress=0;
+    }
     examineNode(doc,PXTranslate);
+    m_batchMode = BMDirect;
+    m_batchSources.clear();
+    m_batchResults.clear();
     if (gSet->settings()->debugDumpHtml)
         dumpPage(token,QSL("5-translated"),doc);
 
@@ -86,7 +106,8 @@ bool CTranslator::translateDocument(const QString &srcHtml, QString &dstHtml)
     if (gSet->settings()->debugDumpHtml)
         dumpPage(token,QSL("6-finalized"),dstHtml);
 
-    m_tran->doneTran();
+    if (!batching)
+        m_tran->doneTran();
 
     return !m_translatorFailed;
 }
@@ -143,6 +164,11 @@ QStringList CTranslator::getAnchorUrls() const
     return m_allAnchorUrls;
 }
 
+CAbstractThreadWorker::WorkerCategory CTranslator::workerCategory() const
+{
+    return wcTranslator;
+}
+
 QString CTranslator::workerDescription() const
 {
     if (m_tran.isNull())
@@ -359,11 +385,14 @@ bool CTranslator::translateParagraph(CHTMLNode &src, CTranslator::XMLPassMode xm
 
     bool failure = false;
 
+    const bool collectOnly = (xmlPass==PXTranslate && m_batchMode==BMCollect);
+
     int baseProgress = 0;
     if (m_textNodesCnt>0) {
         baseProgress = 100*m_textNodesProgress/m_textNodesCnt;
     }
-    Q_EMIT setProgress(baseProgress);
+    if (!collectOnly)
+        Q_EMIT setProgress(baseProgress);
 
     QString srcTemp = src.text;
     srcTemp = srcTemp.replace(QSL("\r\n"),QSL("\n"));
@@ -412,7 +441,7 @@ bool CTranslator::translateParagraph(CHTMLNode &src, CTranslator::XMLPassMode xm
                             if ((combinedTokenCount >= m_tokensMaxCountCombined) ||  // max tokens
                                     ((idx + 1) >= sourceStrings.count())) {          // or last string in the list
                                 sourceStrTemp = combineAccumulator.join(QChar('\n'));
-                                tranResult = m_tran->tranString(sourceStrTemp);
+                                tranResult = translateString(sourceStrTemp);
                                 combineAccumulator.clear();
                                 combinedTokenCount = 0;
                             }
@@ -428,13 +457,13 @@ bool CTranslator::translateParagraph(CHTMLNode &src, CTranslator::XMLPassMode xm
                                 if (!schar.isLetterOrNumber() || (j==(sourceStrTemp.length()-1))) {
                                     if (!sourceStrPart.isEmpty()) {
                                         if (schar.isLetterOrNumber()) {
-                                            tranResult += m_tran->tranString(sourceStrPart);
+                                            tranResult += translateString(sourceStrPart);
                                         } else {
                                             if (schar==questionMark || schar==fullwidthQuestionMark) {
                                                 sourceStrPart += schar;
-                                                tranResult += m_tran->tranString(sourceStrPart);
+                                                tranResult += translateString(sourceStrPart);
                                             } else {
-                                                tranResult += m_tran->tranString(sourceStrPart) + schar;
+                                                tranResult += translateString(sourceStrPart) + schar;
                                             }
                                         }
                                         sourceStrPart.clear();
@@ -448,7 +477,7 @@ bool CTranslator::translateParagraph(CHTMLNode &src, CTranslator::XMLPassMode xm
                             break;
                         }
                         case CStructures::smKeepParagraph: // Preferred mode for non-AI translators
-                            tranResult = m_tran->tranString(sourceStrTemp);
+                            tranResult = translateString(sourceStrTemp);
                             break;
                     }
                 } else {
@@ -495,7 +524,7 @@ bool CTranslator::translateParagraph(CHTMLNode &src, CTranslator::XMLPassMode xm
                 }
             }
 
-            if (m_textNodesCnt > 0 && (idx % progressUpdateFrac == 0)) {
+            if (!collectOnly && m_textNodesCnt > 0 && (idx % progressUpdateFrac == 0)) {
                 const int progress = 100*m_textNodesProgress/m_textNodesCnt;
                 Q_EMIT setProgress(progress);
             }
@@ -503,7 +532,7 @@ bool CTranslator::translateParagraph(CHTMLNode &src, CTranslator::XMLPassMode xm
         }
     }
 
-    if (xmlPass==PXTranslate && !translatedOutput.isEmpty()) {
+    if (xmlPass==PXTranslate && !collectOnly && !translatedOutput.isEmpty()) {
 
         translatedOutput = translatedOutput.replace(QSL("\n"),QSL("<br/>"));
 
@@ -519,6 +548,53 @@ bool CTranslator::translateParagraph(CHTMLNode &src, CTranslator::XMLPassMode xm
     return !failure;
 }
 
+QString CTranslator::translateString(const QString &src)
+{
+    switch (m_batchMode) {
+        case BMCollect:
+            if (!src.isEmpty() && !m_batchResults.contains(src)) {
+                m_batchResults.insert(src,QString());
+                m_batchSources.append(src);
+            }
+            return QString();
+        case BMApply:
+            return m_batchResults.value(src);
+        case BMDirect:
+            break;
+    }
+    return m_tran->tranString(src);
+}
+
+bool CTranslator::translateCollectedBatches()
+{
+    m_batchResults.clear();
+
+    CTranslatorBatchEngine engine(m_translationEngine,m_langPair,m_parallelRequests,m_batchSize);
+    const bool res = engine.translate(m_batchSources,m_batchResults,[this](){
+        return isAborted();
+    },[this](int done, int total){
+        if (total>0)
+            Q_EMIT setProgress(100*done/total);
+    },[this](qint64 size){
+        addTranslatorRequestBytes(size);
+    });
+
+    if (!res)
+        m_batchError = engine.getErrorMsg();
+
+    return res;
+}
+
+QString CTranslator::lastErrorMsg() const
+{
+    if (!m_batchError.isEmpty())
+        return m_batchError;
+    if (m_tran)
+        return m_tran->getErrorMsg();
+
+    return QString();
+}
+
 void CTranslator::dumpPage(QUuid token, const QString &suffix, const QString &page)
 {
     const QString fname = CGenericFuncs::getTmpDir() + QDir::separator() + token.toString()
@@ -595,12 +671,11 @@ void CTranslator::startMain()
                     oktrans = true;
                     break;
                 }
-                if (m_tran) {
-                    lastError = m_tran->getErrorMsg();
-                } else {
+                lastError = lastErrorMsg();
+                if (lastError.isEmpty())
                     lastError = tr("ATLAS translator failed.");
-                }
                 if (m_tran) {
+                    // Drop failed connection, next attempt performs new handshake
                     m_tran->doneTran(true);
                     QThread::msleep(m_tran->getRandomDelay(CDefaults::atlasMinRetryDelay,
                                                            CDefaults::atlasMaxRetryDelay));
@@ -616,7 +691,7 @@ void CTranslator::startMain()
         if (!translateDocument(m_sourceHtml,translatedHtml)) {
             QString lastError = tr("Translator initialization error");
             if (m_tran)
-                lastError = m_tran->getErrorMsg();
+                lastError = lastErrorMsg();
             Q_EMIT translationFinished(false,isAborted(),translatedHtml,lastError);
             Q_EMIT finished();
             return;
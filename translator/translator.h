@@ -3,6 +3,7 @@
 
 #include <QObject>
 #include <QString>
+#include <QHash>
 #include <QColor>
 #include <QFont>
 #include <QUuid>
@@ -28,10 +29,18 @@ private:
         PXPostprocess
     };
 
+    enum BatchMode {
+        BMDirect,
+        BMCollect,
+        BMApply
+    };
+
     int m_retryCount { 0 };
     int m_textNodesCnt { 0 };
     int m_textNodesProgress { 0 };
     int m_tokensMaxCountCombined { 0 };
+    int m_parallelRequests { 1 };
+    int m_batchSize { 0 };
     bool m_translatorFailed { false };
     bool m_tranInited { false };
     bool m_useOverrideTransFont { false };
@@ -39,6 +48,7 @@ private:
     CStructures::SubsentencesMode m_subsentencesMode { CStructures::smKeepParagraph };
     CStructures::TranslationEngine m_translationEngine { CStructures::teAtlas };
     CStructures::TranslationMode m_translationMode { CStructures::tmAdditive };
+    BatchMode m_batchMode { BMDirect };
 
     QScopedPointer<CAbstractTranslator,QScopedPointerDeleteLater> m_tran;
     QString m_sourceHtml;
@@ -51,11 +61,17 @@ private:
     QString m_title;
     QUrl m_origin;
     CLangPair m_langPair;
+    QStringList m_batchSources;
+    QHash<QString,QString> m_batchResults;
+    QString m_batchError;
 
     bool translateDocument(const QString& srcHtml, QString& dstHtml);
 
     void examineNode(CHTMLNode & node, XMLPassMode xmlPass);
     bool translateParagraph(CHTMLNode & src, XMLPassMode xmlPass);
+    QString translateString(const QString& src);
+    bool translateCollectedBatches();
+    QString lastErrorMsg() const;
 
     void dumpPage(QUuid token, const QString& suffix, const QString& page);
     void dumpPage(QUuid token, const QString& suffix, const CHTMLNode& page);
@@ -71,6 +87,7 @@ public:
     QStringList getImgUrls() const;
     QStringList getAnchorUrls() const;
     QString workerDescription() const override;
+    WorkerCategory workerCategory() const override;
 
 protected:
     void startMain() override;
@@ -0,0 +1,175 @@
+#include <QThreadPool>
+#include <QCoreApplication>
+#include <QEventLoop>
+#include <QTimer>
+#include <QAtomicInteger>
+#include <QMutexLocker>
+#include <memory>
+#include "translatorbatch.h"
+#include "translator-workers/abstracttranslator.h"
+
+namespace CDefaults {
+const int batchEngineProgressInterval = 50;
+}
+
+// Batch workers block on network or ATLAS socket, so they use own pool instead of global one
+Q_GLOBAL_STATIC(QThreadPool, batchWorkerPool) // NOLINT
+
+CTranslatorBatchEngine::CTranslatorBatchEngine(CStructures::TranslationEngine engine,
+                                               const CLangPair &langPair,
+                                               int parallelRequests, int batchSize)
+    : m_engine(engine),
+      m_langPair(langPair),
+      m_parallelRequests(qMax(1,parallelRequests)),
+      m_batchSize(qMax(1,batchSize))
+{
+    // Parallel requests setting is for web engines. ATLAS server is usually a single instance
+    // and its connection already keeps atlasPipelineDepth requests in flight.
+    if (m_engine == CStructures::teAtlas)
+        m_parallelRequests = 1;
+}
+
+bool CTranslatorBatchEngine::isBatchingSupported(CStructures::TranslationEngine engine, int parallelRequests)
+{
+    // ATLAS pipelines requests over one pooled connection, so batching pays off without parallel workers.
+    return ((engine == CStructures::teAtlas) || (parallelRequests > 1));
+}
+
+QVector<QPair<int,int> > CTranslatorBatchEngine::splitBatches(const QStringList &sources) const
+{
+    // Consecutive ranges (start, count) bounded by summary text length
+    QVector<QPair<int,int> > res;
+    int start = 0;
+    int length = 0;
+    for (int i=0; i<sources.count(); i++) {
+        length += sources.at(i).length();
+        if (length >= m_batchSize) {
+            res.append(qMakePair(start, i - start + 1));
+            start = i + 1;
+            length = 0;
+        }
+    }
+    if (start < sources.count())
+        res.append(qMakePair(start, sources.count() - start));
+
+    return res;
+}
+
+void CTranslatorBatchEngine::setErrorMsg(const QString &msg)
+{
+    const QMutexLocker locker(&m_mutex);
+    if (m_errorMsg.isEmpty())
+        m_errorMsg = msg;
+}
+
+QString CTranslatorBatchEngine::getErrorMsg() const
+{
+    return m_errorMsg;
+}
+
+bool CTranslatorBatchEngine::translate(const QStringList &sources, QHash<QString, QString> &results,
+                                       const AbortCallback &isAborted,
+                                       const ProgressCallback &progress,
+                                       const BytesCallback &bytesTransferred)
+{
+    m_errorMsg.clear();
+    if (sources.isEmpty()) return true;
+
+    const QVector<QPair<int,int> > batches = splitBatches(sources);
+    QVector<QString> translated(sources.count());
+    QString* translatedData = translated.data(); // each slot is written by exactly one thread
+    QAtomicInteger<int> nextBatch(0);
+    QAtomicInteger<int> doneCount(0);
+    QAtomicInteger<int> partialCount(0);
+    QAtomicInteger<bool> failed(false);
+
+    auto worker = [&](){
+        std::unique_ptr<CAbstractTranslator> tran(
+                    CAbstractTranslator::translatorFactory(nullptr,m_engine,m_langPair));
+        if (tran)
+            tran->setAbortCallback(isAborted);
+        if (!tran || !tran->initTran()) {
+            setErrorMsg(QObject::tr("Unable to initialize translation engine."));
+            failed.storeRelease(true);
+            return;
+        }
+        QObject::connect(tran.get(),&CAbstractTranslator::translatorBytesTransferred,
+                         [this,&bytesTransferred](qint64 size){
+            const QMutexLocker locker(&m_mutex);
+            bytesTransferred(size);
+        });
+        // Streaming engines report finished strings before the whole batch is done
+        int batchPartial = 0;
+        QObject::connect(tran.get(),&CAbstractTranslator::translatorStringsProgress,
+                         [&batchPartial,&partialCount](int done){
+            partialCount.fetchAndAddOrdered(done - batchPartial);
+            batchPartial = done;
+        });
+
+        int batch = -1;
+        while (!failed.loadAcquire() && !isAborted() &&
+               ((batch = nextBatch.fetchAndAddOrdered(1)) < batches.count())) {
+            const auto &range = batches.at(batch);
+            const QStringList batchResults = tran->tranStrings(sources.mid(range.first,range.second));
+            partialCount.fetchAndAddOrdered(-batchPartial);
+            batchPartial = 0;
+            if (!tran->getErrorMsg().isEmpty() || batchResults.count() != range.second) {
+                if (tran->getErrorMsg().isEmpty()) {
+                    setErrorMsg(QObject::tr("Translation engine returned incomplete batch."));
+                } else {
+                    setErrorMsg(tran->getErrorMsg());
+                }
+                failed.storeRelease(true);
+                break;
+            }
+            for (int i = 0; i < range.second; i++)
+                translatedData[range.first + i] = batchResults.at(i);
+            doneCount.fetchAndAddOrdered(range.second);
+        }
+
+        tran->doneTran();
+        tran.reset();
+
+        // Pooled thread has no event loop of its own, translator leftovers are removed here
+        QCoreApplication::sendPostedEvents(nullptr,QEvent::DeferredDelete);
+    };
+
+    // Local event loop keeps our own thread responsive to queued abort requests
+    QEventLoop loop;
+    QTimer progressTimer;
+    progressTimer.setInterval(CDefaults::batchEngineProgressInterval);
+    QObject::connect(&progressTimer,&QTimer::timeout,&loop,[&](){
+        progress(qMin(doneCount.loadAcquire() + partialCount.loadAcquire(),sources.count()),
+                 sources.count());
+    });
+
+    const int workersCount = qMin(m_parallelRequests, batches.count());
+    int runningWorkers = workersCount;
+    QThreadPool* pool = batchWorkerPool();
+    pool->setMaxThreadCount(qMax(pool->maxThreadCount(),workersCount));
+    for (int i=0; i<workersCount; i++) {
+        pool->start([&worker,&loop,&runningWorkers](){
+            worker();
+            // Last access to the caller stack, it stays alive until all workers report here
+            QMetaObject::invokeMethod(&loop,[&loop,&runningWorkers](){
+                if (--runningWorkers == 0)
+                    loop.quit();
+            },Qt::QueuedConnection);
+        });
+    }
+
+    if (workersCount > 0) {
+        progressTimer.start();
+        loop.exec();
+        progressTimer.stop();
+    }
+
+    if (failed.loadAcquire() || isAborted())
+        return false;
+
+    for (int i=0; i<sources.count(); i++)
+        results.insert(sources.at(i),translated.at(i));
+
+    progress(sources.count(),sources.count());
+    return true;
+}
@@ -0,0 +1,44 @@
+#ifndef TRANSLATORBATCH_H
+#define TRANSLATORBATCH_H
+
+#include <QObject>
+#include <QString>
+#include <QStringList>
+#include <QHash>
+#include <QMutex>
+#include <functional>
+#include "global/structures.h"
+
+class CTranslatorBatchEngine
+{
+    Q_DISABLE_COPY(CTranslatorBatchEngine)
+public:
+    using AbortCallback = std::function<bool()>;
+    using ProgressCallback = std::function<void(int done, int total)>;
+    using BytesCallback = std::function<void(qint64 size)>;
+
+    CTranslatorBatchEngine(CStructures::TranslationEngine engine, const CLangPair &langPair,
+                           int parallelRequests, int batchSize);
+    ~CTranslatorBatchEngine() = default;
+
+    static bool isBatchingSupported(CStructures::TranslationEngine engine, int parallelRequests);
+
+    bool translate(const QStringList &sources, QHash<QString,QString> &results,
+                   const AbortCallback &isAborted, const ProgressCallback &progress,
+                   const BytesCallback &bytesTransferred);
+    QString getErrorMsg() const;
+
+private:
+    CStructures::TranslationEngine m_engine { CStructures::teAtlas };
+    CLangPair m_langPair;
+    int m_parallelRequests { 1 };
+    int m_batchSize { 0 };
+    QString m_errorMsg;
+    QMutex m_mutex;
+
+    QVector<QPair<int,int> > splitBatches(const QStringList &sources) const;
+    void setErrorMsg(const QString &msg);
+
+};
+
+#endif // TRANSLATORBATCH_H
@@ -4,55 +4,74 @@
 #include <QCryptographicHash>
 #include <QJsonDocument>
 #include <QJsonObject>
+#include <QDataStream>
+#include <QDateTime>
+#include <QMutexLocker>
+#include <QSaveFile>
+#include <QRegularExpression>
 #include <QDir>
 #include "translatorcache.h"
 #include "utils/genericfuncs.h"
 #include "global/control.h"
 #include "translatorcachedialog.h"
 
+namespace CDefaults {
+const int translatorCacheShards = 16;
+const int translatorCacheMaintenanceDelay = 5000;
+const int translatorCacheKeySize = 16;
+const qint64 translatorCacheHeaderSize = 37;
+const qint64 translatorCacheMinCompactSize = 256 * 1024;
+const double translatorCacheCompactRatio = 0.5;
+const int translatorCacheEvictSlice = 512;
+const quint32 translatorCacheRecordMagic = 0x4A505443; // 'JPTC'
+const quint8 translatorCacheFlagDeleted = 0x01;
+const quint8 translatorCacheFlagCompressed = 0x02;
+}
+
 CTranslatorCache::CTranslatorCache(QObject *parent) : QObject(parent)
 {
+    m_maintenanceTimer.setSingleShot(true);
+    m_maintenanceTimer.setInterval(CDefaults::translatorCacheMaintenanceDelay);
+    connect(&m_maintenanceTimer,&QTimer::timeout,this,&CTranslatorCache::maintenance);
+}
+
+CTranslatorCache::~CTranslatorCache()
+{
+    if (m_maintenanceThread)
+        m_maintenanceThread->wait();
 
+    const QMutexLocker locker(&m_mutex);
+    closeShards();
 }
 
 void CTranslatorCache::setCachePath(const QString &path)
 {
     if (path.isEmpty()) return;
 
+    const QMutexLocker locker(&m_mutex);
+
+    closeShards();
     m_cachePath.setPath(path);
     if (!m_cachePath.exists())
         m_cachePath.mkpath(QSL("."));
+
+    openShards();
+    migrateLegacyEntries();
 }
 
 QString CTranslatorCache::cachedTranslatorResult(const QString &source,
                                                  const CLangPair &languagePair,
                                                  CStructures::TranslationEngine engine,
-                                                 CStructures::SubsentencesMode subsentencesMode) const
+                                                 CStructures::SubsentencesMode subsentencesMode)
 {
-    if (!m_cachePath.exists()) return QString();
-
-    const QString filename = getMD5(getHashSource(source,languagePair,engine,subsentencesMode));
-
-    QFile f(m_cachePath.filePath(filename));
-    if (!f.open(QIODevice::ReadOnly)) return QString();
-
-    QString result = QString::fromUtf8(f.readAll());
-    f.close();
-
-    return result;
+    const QByteArray key = getMD5(getHashSource(source,languagePair,engine,subsentencesMode));
+    return readPayload(shardForKey(key),key);
 }
 
-QString CTranslatorCache::cachedTranslatorResult(const QString &md5) const
+QString CTranslatorCache::cachedTranslatorResult(const QString &md5)
 {
-    if (!m_cachePath.exists()) return QString();
-
-    QFile f(m_cachePath.filePath(md5));
-    if (!f.open(QIODevice::ReadOnly)) return QString();
-
-    QString result = QString::fromUtf8(f.readAll());
-    f.close();
-
-    return result;
+    const QByteArray key = QByteArray::fromHex(md5.toLatin1());
+    return readPayload(shardForKey(key),key);
 }
 
 void CTranslatorCache::saveTranslatorResult(const QString &source, const QString &result,
@@ -62,15 +81,6 @@ void CTranslatorCache::saveTranslatorResult(const QString &source, const QString
                                             const QString &title,
                                             const QUrl &origin)
 {
-    if (!m_cachePath.exists()) return;
-
-    const QString filename = getMD5(getHashSource(source,languagePair,engine,subsentencesMode));
-
-    QFile f(m_cachePath.filePath(filename));
-    if (!f.open(QIODevice::WriteOnly)) return;
-    f.write(result.toUtf8());
-    f.close();
-
     QJsonObject root;
     root.insert(QSL("title"),title);
     root.insert(QSL("engine"),CStructures::translationEngines().value(engine));
@@ -78,14 +88,81 @@ void CTranslatorCache::saveTranslatorResult(const QString &source, const QString
     root.insert(QSL("length"),source.length());
     if (!(origin.toString().startsWith(QSL("data:"),Qt::CaseInsensitive)))
         root.insert(QSL("origin"),origin.toString());
-    const QJsonDocument doc(root);
+    const QByteArray info = QJsonDocument(root).toJson(QJsonDocument::Compact);
+
+    RecordHeader header;
+    header.key = getMD5(getHashSource(source,languagePair,engine,subsentencesMode));
+    header.created = QDateTime::currentMSecsSinceEpoch();
+    QByteArray payload = result.toUtf8();
+    if (gSet->settings()->translatorCacheCompression) {
+        payload = qCompress(payload);
+        header.flags |= CDefaults::translatorCacheFlagCompressed;
+    }
+    const QByteArray record = buildRecord(header,info,payload);
+
+    {
+        const QSharedPointer<Shard> shard = shardForKey(header.key);
+        if (shard.isNull()) return;
+
+        const QMutexLocker locker(&shard->mutex);
+        if (!appendRecord(shard.data(),header,record)) return;
+    }
+
+    QMetaObject::invokeMethod(this,&CTranslatorCache::scheduleMaintenance,Qt::QueuedConnection);
+}
+
+bool CTranslatorCache::appendRecord(Shard *shard, const RecordHeader &header, const QByteArray &record)
+{
+    // shard mutex must be locked
+    if (!shard->file.isOpen()) return false;
+
+    const qint64 offset = shard->file.size();
+    if (!shard->file.seek(offset) || (shard->file.write(record) != record.size())) {
+        qWarning() << "Unable to append translator cache record to " << shard->file.fileName();
+        shard->file.resize(offset);
+        return false;
+    }
+    shard->file.flush();
+
+    auto it = shard->index.find(header.key);
+    if (it != shard->index.end()) {
+        shard->deadBytes += it->size;
+        m_liveBytes.fetchAndAddOrdered(-it->size);
+    }
+
+    IndexEntry entry;
+    entry.offset = offset;
+    entry.size = record.size();
+    entry.created = header.created;
+    entry.lastAccess = header.created;
+    shard->index.insert(header.key,entry);
+    m_liveBytes.fetchAndAddOrdered(entry.size);
+    return true;
+}
 
-    QFile info(m_cachePath.filePath(QSL("%1.info").arg(filename)));
-    if (!info.open(QIODevice::WriteOnly)) return;
-    info.write(doc.toJson());
-    info.close();
+QList<QJsonObject> CTranslatorCache::cachedEntries()
+{
+    QList<QJsonObject> res;
+
+    const ShardList list = shards();
+    for (const auto &shard : list) {
+        const QMutexLocker locker(&shard->mutex);
+        if (!shard->file.isOpen()) continue;
+        for (auto it = shard->index.constBegin(), end = shard->index.constEnd(); it != end; ++it) {
+            RecordHeader header;
+            if (!shard->file.seek(it->offset) || !readHeader(shard->file,header)) continue;
+
+            const QJsonDocument doc = QJsonDocument::fromJson(shard->file.read(header.infoLength));
+            if (doc.isNull() || !doc.isObject()) continue;
 
-    cleanOldEntries();
+            QJsonObject obj = doc.object();
+            obj.insert(QSL("#filedate"),QDateTime::fromMSecsSinceEpoch(it->created).toString(Qt::ISODateWithMs));
+            obj.insert(QSL("#md5"),QString::fromLatin1(it.key().toHex()));
+            res.append(obj);
+        }
+    }
+
+    return res;
 }
 
 QDir CTranslatorCache::getCachePath() const
@@ -93,11 +170,11 @@ QDir CTranslatorCache::getCachePath() const
     return m_cachePath;
 }
 
-QString CTranslatorCache::getMD5(const QString &content) const
+QByteArray CTranslatorCache::getMD5(const QString &content) const
 {
     QCryptographicHash md5(QCryptographicHash::Md5);
     md5.addData(content.toUtf8());
-    return QString::fromLatin1(md5.result().toHex());
+    return md5.result();
 }
 
 QString CTranslatorCache::getHashSource(const QString &source,
@@ -112,34 +189,500 @@ QString CTranslatorCache::getHashSource(const QString &source,
     return content;
 }
 
-void CTranslatorCache::cleanOldEntries()
+QString CTranslatorCache::shardFileName(int shardIdx) const
+{
+    return m_cachePath.filePath(QSL("shard-%1.seg").arg(shardIdx,2,16,QChar(u'0')));
+}
+
+QString CTranslatorCache::accessFileName(const QString &shardFileName)
+{
+    QString res = shardFileName;
+    res.chop(QSL(".seg").length());
+    return QSL("%1.lru").arg(res);
+}
+
+QSharedPointer<CTranslatorCache::Shard> CTranslatorCache::shardForKey(const QByteArray &key)
 {
+    const QMutexLocker locker(&m_mutex);
+    const int idx = shardIndex(key);
+    if (idx < 0)
+        return QSharedPointer<Shard>();
+
+    return m_shards.at(idx);
+}
+
+int CTranslatorCache::shardIndex(const QByteArray &key) const
+{
+    // m_mutex must be locked
+    if (m_shards.isEmpty() || key.size() != CDefaults::translatorCacheKeySize)
+        return -1;
+
+    return static_cast<quint8>(key.at(0)) % m_shards.count();
+}
+
+CTranslatorCache::ShardList CTranslatorCache::shards()
+{
+    const QMutexLocker locker(&m_mutex);
+    return m_shards;
+}
+
+void CTranslatorCache::openShards()
+{
+    m_shards.clear();
+    m_liveBytes.storeRelease(0L);
     if (!m_cachePath.exists()) return;
 
-    QFileInfoList list = m_cachePath.entryInfoList(QDir::Files | QDir::Writable | QDir::Readable,
-                                                   QDir::Time | QDir::Reversed);
-    qint64 sumSize = 0;
-    const qint64 maxSize = gSet->settings()->translatorCacheSize * CDefaults::oneMB;
-    while (!list.isEmpty() && sumSize<maxSize) {
-        sumSize += list.takeLast().size();
+    m_shards.reserve(CDefaults::translatorCacheShards);
+    for (int i = 0; i < CDefaults::translatorCacheShards; i++) {
+        auto shard = QSharedPointer<Shard>::create();
+        shard->file.setFileName(shardFileName(i));
+        if (shard->file.open(QIODevice::ReadWrite)) {
+            scanShard(shard.data());
+            loadAccessTimes(shard.data());
+        } else {
+            qWarning() << "Unable to open translator cache shard " << shard->file.fileName();
+        }
+        m_shards.append(shard);
+    }
+}
+
+void CTranslatorCache::closeShards()
+{
+    // m_mutex must be locked
+    for (const auto &shard : qAsConst(m_shards)) {
+        const QMutexLocker locker(&shard->mutex);
+        shard->file.close();
     }
+    m_shards.clear();
+    m_liveBytes.storeRelease(0L);
+}
+
+QFileInfoList CTranslatorCache::legacyEntries() const
+{
+    // Older versions kept each result in file named by hex MD5 key, with JSON info in '.info' file
+    const QStringList mask({ QSL("????????????????????????????????"),
+                             QSL("????????????????????????????????.info") });
+    const QFileInfoList list = m_cachePath.entryInfoList(mask,QDir::Files | QDir::Writable | QDir::Readable);
+
+    static const QRegularExpression legacyRx(QSL("^[0-9a-f]{%1}(\\.info)?$")
+                                             .arg(CDefaults::translatorCacheKeySize * 2));
+    QFileInfoList res;
+    res.reserve(list.count());
+    for (const auto &item : list) {
+        if (legacyRx.match(item.fileName()).hasMatch())
+            res.append(item);
+    }
+    return res;
+}
 
-    std::for_each(std::execution::par,list.constBegin(),list.constEnd(),
+void CTranslatorCache::removeLegacyEntries(const QFileInfoList &entries)
+{
+    std::for_each(std::execution::par,entries.constBegin(),entries.constEnd(),
                    [](const QFileInfo& item){
         QFile f(item.absoluteFilePath());
         f.remove();
     });
 }
 
-void CTranslatorCache::clearCache()
+void CTranslatorCache::migrateLegacyEntries()
 {
-    if (!m_cachePath.exists()) return;
-    const QFileInfoList list = m_cachePath.entryInfoList(QDir::Files | QDir::Writable | QDir::Readable);
-    std::for_each(std::execution::par,list.constBegin(),list.constEnd(),
-                   [](const QFileInfo& item){
-        QFile f(item.absoluteFilePath());
-        f.remove();
+    // m_mutex must be locked, shards must be open
+    const QFileInfoList entries = legacyEntries();
+    if (entries.isEmpty()) return;
+
+    // Settings are not loaded yet, so migrated payloads are stored uncompressed
+    int migrated = 0;
+    bool failed = false;
+    for (const auto &item : entries) {
+        if (item.suffix() == QSL("info")) continue;
+
+        RecordHeader header;
+        header.key = QByteArray::fromHex(item.fileName().toLatin1());
+        header.created = item.lastModified().toMSecsSinceEpoch();
+        const int idx = shardIndex(header.key);
+        if (idx < 0) continue;
+
+        QFile payloadFile(item.absoluteFilePath());
+        if (!payloadFile.open(QIODevice::ReadOnly)) continue;
+        const QByteArray payload = payloadFile.readAll();
+        payloadFile.close();
+
+        QByteArray info;
+        QFile infoFile(QSL("%1.info").arg(item.absoluteFilePath()));
+        if (infoFile.open(QIODevice::ReadOnly)) {
+            const QJsonDocument doc = QJsonDocument::fromJson(infoFile.readAll());
+            infoFile.close();
+            if (doc.isObject())
+                info = QJsonDocument(doc.object()).toJson(QJsonDocument::Compact);
+        }
+        if (info.isEmpty())
+            info = QJsonDocument(QJsonObject()).toJson(QJsonDocument::Compact);
+
+        const QSharedPointer<Shard> shard = m_shards.at(idx);
+        const QMutexLocker shardLocker(&shard->mutex);
+        if (shard->index.contains(header.key)) continue;
+        if (appendRecord(shard.data(),header,buildRecord(header,info,payload))) {
+            migrated++;
+        } else {
+            failed = true;
+        }
+    }
+
+    // Legacy files are kept until all of them are in the new store, next start will retry
+    if (failed) {
+        qWarning() << QSL("Translator cache: unable to migrate per-file cache, %1 entries migrated.")
+                      .arg(migrated);
+        return;
+    }
+
+    removeLegacyEntries(entries);
+    qInfo() << QSL("Translator cache: %1 entries migrated from per-file cache, %2 legacy files removed.")
+               .arg(migrated).arg(entries.count());
+    QMetaObject::invokeMethod(this,&CTranslatorCache::scheduleMaintenance,Qt::QueuedConnection);
+}
+
+void CTranslatorCache::scanShard(Shard *shard)
+{
+    // Rebuild compact in-memory index from record headers, payloads are not read here
+    shard->index.clear();
+    shard->deadBytes = 0L;
+
+    const qint64 fileSize = shard->file.size();
+    qint64 pos = 0L;
+    while (pos < fileSize) {
+        RecordHeader header;
+        if (!shard->file.seek(pos) || !readHeader(shard->file,header)) break;
+
+        const qint64 recordSize = CDefaults::translatorCacheHeaderSize
+                                  + header.infoLength + header.payloadLength;
+        if (pos + recordSize > fileSize) break;
+
+        auto it = shard->index.find(header.key);
+        if (it != shard->index.end()) {
+            shard->deadBytes += it->size;
+            m_liveBytes.fetchAndAddOrdered(-it->size);
+            shard->index.erase(it);
+        }
+
+        if ((header.flags & CDefaults::translatorCacheFlagDeleted) != 0) {
+            shard->deadBytes += recordSize;
+        } else {
+            IndexEntry entry;
+            entry.offset = pos;
+            entry.size = recordSize;
+            entry.created = header.created;
+            entry.lastAccess = header.created;
+            shard->index.insert(header.key,entry);
+            m_liveBytes.fetchAndAddOrdered(recordSize);
+        }
+        pos += recordSize;
+    }
+
+    if (pos < fileSize) {
+        qWarning() << "Truncating damaged translator cache shard " << shard->file.fileName()
+                   << " at " << pos;
+        shard->file.resize(pos);
+    }
+}
+
+void CTranslatorCache::loadAccessTimes(Shard *shard)
+{
+    // Access times are saved by maintenance, missing or stale file just leaves creation times
+    QFile file(accessFileName(shard->file.fileName()));
+    if (!file.open(QIODevice::ReadOnly)) return;
+
+    QDataStream stream(&file);
+    quint32 count = 0;
+    stream >> count;
+    for (quint32 i = 0; i < count && stream.status() == QDataStream::Ok; i++) {
+        QByteArray key;
+        qint64 lastAccess = 0L;
+        stream >> key >> lastAccess;
+        auto it = shard->index.find(key);
+        if (it != shard->index.end())
+            it->lastAccess = qMax(it->lastAccess,lastAccess);
+    }
+}
+
+void CTranslatorCache::saveAccessTimes(Shard *shard)
+{
+    QHash<QByteArray,qint64> times;
+    QString fileName;
+    {
+        const QMutexLocker locker(&shard->mutex);
+        if (!shard->accessDirty || !shard->file.isOpen()) return;
+
+        for (auto it = shard->index.constBegin(), end = shard->index.constEnd(); it != end; ++it) {
+            if (it->lastAccess > it->created)
+                times.insert(it.key(),it->lastAccess);
+        }
+        fileName = accessFileName(shard->file.fileName());
+        shard->accessDirty = false;
+    }
+
+    QSaveFile file(fileName);
+    if (!file.open(QIODevice::WriteOnly)) {
+        qWarning() << "Unable to save translator cache access times " << fileName;
+        return;
+    }
+    QDataStream stream(&file);
+    stream << static_cast<quint32>(times.count());
+    for (auto it = times.constBegin(), end = times.constEnd(); it != end; ++it)
+        stream << it.key() << it.value();
+    if (!file.commit())
+        qWarning() << "Unable to save translator cache access times " << fileName;
+}
+
+bool CTranslatorCache::readHeader(QFile &file, RecordHeader &header) const
+{
+    const QByteArray data = file.read(CDefaults::translatorCacheHeaderSize);
+    if (data.size() != CDefaults::translatorCacheHeaderSize) return false;
+
+    QDataStream stream(data);
+    quint32 magic = 0;
+    stream >> magic;
+    if (magic != CDefaults::translatorCacheRecordMagic) return false;
+
+    header.key.resize(CDefaults::translatorCacheKeySize);
+    stream >> header.flags;
+    stream.readRawData(header.key.data(),CDefaults::translatorCacheKeySize);
+    stream >> header.created >> header.infoLength >> header.payloadLength;
+
+    return (stream.status() == QDataStream::Ok);
+}
+
+QByteArray CTranslatorCache::buildRecord(const RecordHeader &header, const QByteArray &info,
+                                         const QByteArray &payload) const
+{
+    QByteArray res;
+    res.reserve(CDefaults::translatorCacheHeaderSize + info.size() + payload.size());
+    QDataStream stream(&res,QIODevice::WriteOnly);
+    stream << CDefaults::translatorCacheRecordMagic << header.flags;
+    stream.writeRawData(header.key.constData(),CDefaults::translatorCacheKeySize);
+    stream << header.created << static_cast<quint32>(info.size())
+           << static_cast<quint32>(payload.size());
+    stream.writeRawData(info.constData(),info.size());
+    stream.writeRawData(payload.constData(),payload.size());
+    return res;
+}
+
+QString CTranslatorCache::readPayload(const QSharedPointer<Shard> &shard, const QByteArray &key)
+{
+    if (shard.isNull()) return QString();
+
+    const QMutexLocker locker(&shard->mutex);
+    if (!shard->file.isOpen()) return QString();
+
+    auto it = shard->index.find(key);
+    if (it == shard->index.end()) return QString();
+
+    RecordHeader header;
+    if (!shard->file.seek(it->offset) || !readHeader(shard->file,header) || (header.key != key))
+        return QString();
+    if (!shard->file.seek(it->offset + CDefaults::translatorCacheHeaderSize + header.infoLength))
+        return QString();
+
+    QByteArray payload = shard->file.read(header.payloadLength);
+    if (payload.size() != static_cast<int>(header.payloadLength))
+        return QString();
+    if ((header.flags & CDefaults::translatorCacheFlagCompressed) != 0)
+        payload = qUncompress(payload);
+
+    it->lastAccess = QDateTime::currentMSecsSinceEpoch();
+    shard->accessDirty = true;
+    return QString::fromUtf8(payload);
+}
+
+bool CTranslatorCache::evictEntries(const ShardList &shards, qint64 maxSize)
+{
+    if (m_liveBytes.loadAcquire() <= maxSize) return false;
+
+    struct LruItem {
+        qint64 lastAccess;
+        int shardIdx;
+        QByteArray key;
+    };
+    QVector<LruItem> items;
+    for (int i = 0; i < shards.count(); i++) {
+        const QMutexLocker locker(&shards.at(i)->mutex);
+        const Shard* shard = shards.at(i).data();
+        for (auto it = shard->index.constBegin(), end = shard->index.constEnd(); it != end; ++it)
+            items.append({ it->lastAccess, i, it.key() });
+    }
+
+    // Only a bounded slice of oldest entries per pass, the rest is left for next passes
+    const auto sliceEnd = items.begin() + qMin<qsizetype>(items.count(),CDefaults::translatorCacheEvictSlice);
+    std::partial_sort(items.begin(),sliceEnd,items.end(),[](const LruItem& a, const LruItem& b){
+        return a.lastAccess < b.lastAccess;
     });
+
+    for (auto item = items.begin(); item != sliceEnd; ++item) {
+        if (m_liveBytes.loadAcquire() <= maxSize) break;
+
+        Shard* shard = shards.at(item->shardIdx).data();
+        const QMutexLocker locker(&shard->mutex);
+        auto it = shard->index.find(item->key);
+        if (!shard->file.isOpen() || it == shard->index.end() || it->lastAccess != item->lastAccess)
+            continue; // entry was accessed or replaced meanwhile
+
+        RecordHeader header;
+        header.flags = CDefaults::translatorCacheFlagDeleted;
+        header.key = item->key;
+        header.created = QDateTime::currentMSecsSinceEpoch();
+        const QByteArray tombstone = buildRecord(header,QByteArray(),QByteArray());
+
+        const qint64 offset = shard->file.size();
+        if (!shard->file.seek(offset) || (shard->file.write(tombstone) != tombstone.size())) {
+            shard->file.resize(offset);
+            continue;
+        }
+
+        const qint64 size = it->size;
+        shard->index.erase(it);
+        shard->deadBytes += size + tombstone.size();
+        m_liveBytes.fetchAndAddOrdered(-size);
+    }
+
+    for (const auto &shard : shards) {
+        const QMutexLocker locker(&shard->mutex);
+        shard->file.flush();
+    }
+
+    return (m_liveBytes.loadAcquire() > maxSize);
+}
+
+bool CTranslatorCache::compactShard(Shard *shard)
+{
+    // Shard mutex must be locked
+    const QString fileName = shard->file.fileName();
+    QSaveFile out(fileName);
+    if (!out.open(QIODevice::WriteOnly)) {
+        qWarning() << "Unable to compact translator cache shard " << fileName;
+        return false;
+    }
+
+    QHash<QByteArray,IndexEntry> index;
+    qint64 lostBytes = 0L;
+    index.reserve(shard->index.count());
+    for (auto it = shard->index.constBegin(), end = shard->index.constEnd(); it != end; ++it) {
+        if (!shard->file.seek(it->offset)) continue;
+        const QByteArray record = shard->file.read(it->size);
+        if (record.size() != it->size) {
+            lostBytes += it->size;
+            continue;
+        }
+
+        IndexEntry entry = it.value();
+        entry.offset = out.pos();
+        if (out.write(record) != record.size()) {
+            out.cancelWriting();
+            return false;
+        }
+        index.insert(it.key(),entry);
+    }
+
+    // Old shard stays in place until new one is completely written
+    shard->file.close();
+    const bool committed = out.commit();
+    if (!committed)
+        qWarning() << "Unable to replace translator cache shard " << fileName;
+
+    if (!shard->file.open(QIODevice::ReadWrite)) {
+        qWarning() << "Unable to reopen translator cache shard " << fileName;
+        for (const auto &entry : qAsConst(shard->index))
+            m_liveBytes.fetchAndAddOrdered(-entry.size);
+        shard->index.clear();
+        shard->deadBytes = 0L;
+        return false;
+    }
+    if (!committed)
+        return false; // old shard and its index are still valid
+
+    m_liveBytes.fetchAndAddOrdered(-lostBytes);
+    shard->index = index;
+    shard->deadBytes = 0L;
+
+    return true;
+}
+
+bool CTranslatorCache::maintenanceStep(qint64 maxSize)
+{
+    const ShardList list = shards();
+    bool moreWork = evictEntries(list,maxSize);
+
+    // Compact one most fragmented shard per pass, only its own lookups wait for it
+    Shard* candidate = nullptr;
+    int candidatesCount = 0;
+    qint64 maxDead = 0L;
+    for (const auto &shard : list) {
+        const QMutexLocker locker(&shard->mutex);
+        if (!shard->file.isOpen()) continue;
+        if ((shard->deadBytes >= CDefaults::translatorCacheMinCompactSize) &&
+                (shard->deadBytes > shard->file.size() * CDefaults::translatorCacheCompactRatio)) {
+            candidatesCount++;
+            if (shard->deadBytes > maxDead) {
+                maxDead = shard->deadBytes;
+                candidate = shard.data();
+            }
+        }
+    }
+
+    if (candidate) {
+        const QMutexLocker locker(&candidate->mutex);
+        if (candidate->file.isOpen())
+            compactShard(candidate);
+    }
+
+    for (const auto &shard : list)
+        saveAccessTimes(shard.data());
+
+    return (moreWork || candidatesCount > 1);
+}
+
+void CTranslatorCache::scheduleMaintenance()
+{
+    if (!m_maintenanceTimer.isActive() && !m_maintenanceThread)
+        m_maintenanceTimer.start();
+}
+
+void CTranslatorCache::maintenance()
+{
+    if (m_maintenanceThread) return;
+
+    const qint64 maxSize = gSet->settings()->translatorCacheSize * CDefaults::oneMB;
+    auto moreWork = QSharedPointer<QAtomicInteger<bool> >::create(false);
+
+    QThread* th = QThread::create([this,maxSize,moreWork](){
+        moreWork->storeRelease(maintenanceStep(maxSize));
+    });
+    m_maintenanceThread = th;
+    connect(th,&QThread::finished,this,[this,moreWork](){
+        m_maintenanceThread.clear();
+        if (moreWork->loadAcquire())
+            m_maintenanceTimer.start();
+    });
+    connect(th,&QThread::finished,th,&QObject::deleteLater);
+    th->setObjectName(QSL("TRAN_CACHE_maint"));
+    th->start();
+}
+
+void CTranslatorCache::clearCache()
+{
+    const QMutexLocker locker(&m_mutex);
+
+    for (const auto &shard : qAsConst(m_shards)) {
+        const QMutexLocker shardLocker(&shard->mutex);
+        if (shard->file.isOpen()) {
+            shard->file.resize(0);
+            QFile::remove(accessFileName(shard->file.fileName()));
+        }
+        shard->index.clear();
+        shard->deadBytes = 0L;
+        shard->accessDirty = false;
+    }
+    m_liveBytes.storeRelease(0L);
+
+    removeLegacyEntries(legacyEntries());
 }
 
 void CTranslatorCache::showDialog()
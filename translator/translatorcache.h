@@ -4,6 +4,15 @@
 #include <QObject>
 #include <QString>
 #include <QDir>
+#include <QFile>
+#include <QHash>
+#include <QMutex>
+#include <QTimer>
+#include <QThread>
+#include <QPointer>
+#include <QAtomicInteger>
+#include <QJsonObject>
+#include <QSharedPointer>
 #include "global/structures.h"
 
 class CTranslatorCache : public QObject
@@ -11,32 +20,89 @@ class CTranslatorCache : public QObject
     Q_OBJECT
 public:
     explicit CTranslatorCache(QObject *parent = nullptr);
+    ~CTranslatorCache() override;
     void setCachePath(const QString& path);
     QDir getCachePath() const;
     QString cachedTranslatorResult(const QString& source, const CLangPair& languagePair,
                                    CStructures::TranslationEngine engine,
-                                   CStructures::SubsentencesMode subsentencesMode) const;
-    QString cachedTranslatorResult(const QString& md5) const;
+                                   CStructures::SubsentencesMode subsentencesMode);
+    QString cachedTranslatorResult(const QString& md5);
     void saveTranslatorResult(const QString& source, const QString& result,
                               const CLangPair& languagePair,
                               CStructures::TranslationEngine engine,
                               CStructures::SubsentencesMode subsentencesMode,
                               const QString &title,
                               const QUrl &origin);
-
+    QList<QJsonObject> cachedEntries();
 
 private:
+    struct IndexEntry {
+        qint64 offset { 0L };
+        qint64 size { 0L };
+        qint64 created { 0L };
+        qint64 lastAccess { 0L };
+    };
+
+    struct RecordHeader {
+        quint8 flags { 0 };
+        QByteArray key;
+        qint64 created { 0L };
+        quint32 infoLength { 0 };
+        quint32 payloadLength { 0 };
+    };
+
+    // Shard data is guarded by its own mutex, m_mutex guards only shard list and cache path
+    struct Shard {
+        QMutex mutex;
+        QFile file;
+        QHash<QByteArray,IndexEntry> index;
+        qint64 deadBytes { 0L };
+        bool accessDirty { false };
+    };
+    using ShardList = QVector<QSharedPointer<Shard> >;
+
     QDir m_cachePath;
+    QMutex m_mutex;
+    QTimer m_maintenanceTimer;
+    QPointer<QThread> m_maintenanceThread;
+    ShardList m_shards;
+    QAtomicInteger<qint64> m_liveBytes { 0L };
 
-    void cleanOldEntries();
-    QString getMD5(const QString& content) const;
+    QByteArray getMD5(const QString& content) const;
     QString getHashSource(const QString& source, const CLangPair& languagePair,
                                 CStructures::TranslationEngine engine,
                                 CStructures::SubsentencesMode subsentencesMode) const;
+
+    QString shardFileName(int shardIdx) const;
+    static QString accessFileName(const QString& shardFileName);
+    QSharedPointer<Shard> shardForKey(const QByteArray& key);
+    ShardList shards();
+    void openShards();
+    void closeShards();
+    QFileInfoList legacyEntries() const;
+    static void removeLegacyEntries(const QFileInfoList &entries);
+    void migrateLegacyEntries();
+    bool appendRecord(Shard* shard, const RecordHeader &header, const QByteArray &record);
+    int shardIndex(const QByteArray& key) const;
+    void scanShard(Shard* shard);
+    void loadAccessTimes(Shard* shard);
+    void saveAccessTimes(Shard* shard);
+    bool readHeader(QFile &file, RecordHeader &header) const;
+    QByteArray buildRecord(const RecordHeader &header, const QByteArray &info,
+                           const QByteArray &payload) const;
+    QString readPayload(const QSharedPointer<Shard>& shard, const QByteArray &key);
+    bool evictEntries(const ShardList &shards, qint64 maxSize);
+    bool compactShard(Shard* shard);
+    bool maintenanceStep(qint64 maxSize);
+
 public Q_SLOTS:
     void clearCache();
     void showDialog();
 
+private Q_SLOTS:
+    void scheduleMaintenance();
+    void maintenance();
+
 };
 
 #endif // TRANSLATORCACHE_H
@@ -1,4 +1,3 @@
-#include <QJsonDocument>
 #include <QJsonObject>
 
 #include "translatorcachedialog.h"
@@ -38,25 +37,7 @@ void CTranslatorCacheDialog::updateCacheList()
     ui->table->clear();
     ui->labelCount->clear();
 
-    const QDir cachePath = gSet->translatorCache()->getCachePath();
-    if (!cachePath.exists()) return;
-    const QFileInfoList list = cachePath.entryInfoList(
-                                   { QSL("*.info") },
-                                   QDir::Files | QDir::Writable | QDir::Readable);
-    QList<QJsonObject> infoList;
-    infoList.reserve(list.count());
-    for (const auto &file : list) {
-        QFile f(file.absoluteFilePath());
-        if (f.open(QIODevice::ReadOnly)) {
-            QJsonDocument doc = QJsonDocument::fromJson(f.readAll());
-            if (!doc.isNull() && doc.isObject()) {
-                QJsonObject obj = doc.object();
-                obj.insert(QSL("#filedate"),file.lastModified().toString(Qt::ISODateWithMs));
-                obj.insert(QSL("#md5"),file.baseName());
-                infoList.append(obj);
-            }
-        }
-    }
+    const QList<QJsonObject> infoList = gSet->translatorCache()->cachedEntries();
 
     ui->table->setRowCount(infoList.count());
     ui->table->setColumnCount(tableHeaders.count());
@@ -0,0 +1,254 @@
+#include <QHash>
+#include <QDebug>
+#include <vector>
+#include "contentdetector.h"
+#include "global/structures.h"
+
+#include <unicode/utypes.h>
+#include <unicode/ucsdet.h>
+#include <unicode/ucnv.h>
+
+extern "C" {
+#include <magic.h>
+}
+
+namespace CDefaults {
+const int contentDetectorMaxConverters = 16;
+}
+
+namespace {
+
+/* Per-thread detection state. Loading the magic database and opening ICU objects
+ * is much more expensive than the detection itself, so they live until thread exit. */
+class CContentDetectorState
+{
+public:
+    CContentDetectorState() = default;
+    ~CContentDetectorState()
+    {
+        if (m_magic)
+            magic_close(m_magic);
+        if (m_charsetDetector)
+            ucsdet_close(m_charsetDetector);
+        for (auto *conv : qAsConst(m_converters))
+            ucnv_close(conv);
+    }
+
+    magic_t magic()
+    {
+        if (m_magic == nullptr && !m_magicFailed) {
+            m_magic = magic_open(MAGIC_ERROR|MAGIC_MIME_TYPE); // NOLINT
+            if (m_magic == nullptr || magic_load(m_magic,nullptr) != 0) {
+                if (m_magic) {
+                    qCritical() << "libmagic error: " << magic_errno(m_magic)
+                                << QString::fromUtf8(magic_error(m_magic));
+                    magic_close(m_magic);
+                }
+                m_magic = nullptr;
+                m_magicFailed = true;
+            }
+        }
+        return m_magic;
+    }
+
+    UCharsetDetector* charsetDetector()
+    {
+        if (m_charsetDetector == nullptr) {
+            UErrorCode status = U_ZERO_ERROR;
+            m_charsetDetector = ucsdet_open(&status);
+            if (!U_SUCCESS(status)) {
+                if (m_charsetDetector)
+                    ucsdet_close(m_charsetDetector);
+                m_charsetDetector = nullptr;
+            }
+        }
+        return m_charsetDetector;
+    }
+
+    UConverter* converter(const QString &encoding)
+    {
+        const QByteArray name = encoding.toUtf8();
+        UConverter* conv = m_converters.value(name);
+        if (conv) {
+            ucnv_reset(conv);
+            return conv;
+        }
+
+        UErrorCode status = U_ZERO_ERROR;
+        conv = ucnv_open(name.constData(),&status);
+        if (!U_SUCCESS(status) && (conv == nullptr))
+            return nullptr;
+
+        if (m_converters.count() >= CDefaults::contentDetectorMaxConverters) {
+            for (auto *oldConv : qAsConst(m_converters))
+                ucnv_close(oldConv);
+            m_converters.clear();
+        }
+        m_converters.insert(name,conv);
+        return conv;
+    }
+
+private:
+    magic_t m_magic { nullptr };
+    bool m_magicFailed { false };
+    UCharsetDetector* m_charsetDetector { nullptr };
+    QHash<QByteArray,UConverter*> m_converters;
+
+    Q_DISABLE_COPY(CContentDetectorState)
+};
+
+CContentDetectorState& localState()
+{
+    thread_local CContentDetectorState state;
+    return state;
+}
+
+QString mimeFromMagicResult(magic_t magic, const char* result)
+{
+    if (result == nullptr) {
+        if (magic) {
+            qCritical() << "libmagic error: " << magic_errno(magic)
+                        << QString::fromUtf8(magic_error(magic));
+        }
+        return QSL("text/plain");
+    }
+    return QString::fromLatin1(result);
+}
+
+}
+
+QString CContentDetector::mimeType(const QByteArray &buf)
+{
+    magic_t magic = localState().magic();
+    if (magic == nullptr)
+        return QSL("text/plain");
+
+    return mimeFromMagicResult(magic,magic_buffer(magic,buf.constData(),static_cast<size_t>(buf.length())));
+}
+
+QString CContentDetector::mimeTypeForFile(const QString &filename)
+{
+    magic_t magic = localState().magic();
+    if (magic == nullptr)
+        return QSL("text/plain");
+
+    const QByteArray name = filename.toUtf8();
+    return mimeFromMagicResult(magic,magic_file(magic,name.constData()));
+}
+
+QString CContentDetector::encodingName(const QByteArray &content)
+{
+    QString res;
+    UCharsetDetector* csd = localState().charsetDetector();
+    if (csd == nullptr)
+        return res;
+
+    UErrorCode status = U_ZERO_ERROR;
+    ucsdet_setText(csd, content.constData(), content.length(), &status);
+    const UCharsetMatch *ucm = ucsdet_detect(csd, &status);
+    if (U_SUCCESS(status) && (ucm != nullptr)) {
+        const char* cname = ucsdet_getName(ucm,&status);
+        if (U_SUCCESS(status) && (cname != nullptr))
+            res = QString::fromUtf8(cname);
+    }
+
+    if (res.contains(QSL("x-sjis"),Qt::CaseInsensitive))
+        res = QSL("SJIS");
+
+    return res;
+}
+
+QString CContentDetector::decodeToUnicode(const QByteArray &content)
+{
+    if (content.isEmpty())
+        return QString();
+
+    return decodeToUnicode(content,encodingName(content));
+}
+
+QString CContentDetector::decodeToUnicode(const QByteArray &content, const QString &encoding)
+{
+    if (content.isEmpty())
+        return QString();
+
+    if (encoding.isEmpty())
+        return QString::fromUtf8(content); // fallback
+
+    UConverter *conv = localState().converter(encoding);
+    if (conv == nullptr)
+        return QString::fromUtf8(content);
+
+    UErrorCode status = U_ZERO_ERROR;
+    std::vector<UChar> targetBuf(content.length() / static_cast<uint8_t>(ucnv_getMinCharSize(conv)));
+    int len = ucnv_toUChars(conv,targetBuf.data(),targetBuf.size(),content.constData(),content.length(),&status);
+    if (!U_SUCCESS(status))
+        return QString::fromUtf8(content);
+
+    return QString::fromUtf16(targetBuf.data(),len);
+}
+
+QByteArray CContentDetector::encodeForByteSearch(const QString &text, const QString &encoding)
+{
+    // Empty result means that byte-level prefiltering is not reliable for this encoding
+    if (text.isEmpty() || encoding.isEmpty())
+        return QByteArray();
+
+    UConverter *conv = localState().converter(encoding);
+    if (conv == nullptr)
+        return QByteArray();
+
+    // Stateful and wide encodings can represent same text with different byte sequences
+    const UConverterType type = ucnv_getType(conv);
+    if (ucnv_getMinCharSize(conv) != 1 || type == UCNV_ISO_2022 || type == UCNV_UTF7 ||
+            type == UCNV_HZ || type == UCNV_SCSU || type == UCNV_BOCU1) {
+        return QByteArray();
+    }
+
+    // Substitution characters would never match file content, so unmappable text fails here
+    UErrorCode status = U_ZERO_ERROR;
+    UConverterFromUCallback oldAction = nullptr;
+    const void* oldContext = nullptr;
+    ucnv_setFromUCallBack(conv,UCNV_FROM_U_CALLBACK_STOP,nullptr,&oldAction,&oldContext,&status);
+    if (!U_SUCCESS(status))
+        return QByteArray();
+
+    QByteArray res(text.length() * ucnv_getMaxCharSize(conv),'\0');
+    const int len = ucnv_fromUChars(conv,res.data(),res.size(),
+                                    reinterpret_cast<const UChar *>(text.utf16()),text.length(),&status);
+
+    UErrorCode restoreStatus = U_ZERO_ERROR;
+    ucnv_setFromUCallBack(conv,oldAction,oldContext,nullptr,nullptr,&restoreStatus);
+    if (!U_SUCCESS(status))
+        return QByteArray();
+
+    res.truncate(len);
+    return res;
+}
+
+QByteArray CContentDetector::decodeToUtf8(const QByteArray &content)
+{
+    if (content.isEmpty())
+        return QByteArray();
+
+    const QString encoding = encodingName(content);
+    if (encoding.toLower() == QSL("utf-8"))
+        return content;
+
+    if (encoding.isEmpty())
+        return QByteArray();
+
+    UConverter *conv = localState().converter(encoding);
+    if (conv == nullptr)
+        return QByteArray();
+
+    UErrorCode status = U_ZERO_ERROR;
+    int utf16len = content.length() / static_cast<uint8_t>(ucnv_getMinCharSize(conv));
+    QByteArray targetBuf(utf16len*4,'\0');
+    int len = ucnv_fromAlgorithmic(conv,UCNV_UTF8,targetBuf.data(),targetBuf.size(),content.constData(),content.length(),&status);
+    if (!U_SUCCESS(status))
+        return QByteArray();
+
+    targetBuf.truncate(len);
+
+    return targetBuf;
+}
@@ -0,0 +1,23 @@
+#ifndef CONTENTDETECTOR_H
+#define CONTENTDETECTOR_H
+
+#include <QString>
+#include <QByteArray>
+
+class CContentDetector
+{
+    Q_DISABLE_COPY(CContentDetector)
+public:
+    CContentDetector() = delete;
+    ~CContentDetector() = delete;
+
+    static QString mimeType(const QByteArray &buf);
+    static QString mimeTypeForFile(const QString &filename);
+    static QString encodingName(const QByteArray &content);
+    static QString decodeToUnicode(const QByteArray &content);
+    static QString decodeToUnicode(const QByteArray &content, const QString &encoding);
+    static QByteArray decodeToUtf8(const QByteArray &content);
+    static QByteArray encodeForByteSearch(const QString &text, const QString &encoding);
+};
+
+#endif // CONTENTDETECTOR_H
@@ -15,6 +15,7 @@
 #include <cstdio>
 #include <cstdlib>
 #include "genericfuncs.h"
+#include "contentdetector.h"
 #include "global/control.h"
 #include "global/control_p.h"
 #include "global/ui.h"
@@ -22,12 +23,10 @@
 #include <unicode/utypes.h>
 #include <unicode/localpointer.h>
 #include <unicode/uenum.h>
-#include <unicode/ucsdet.h>
 #include <unicode/ucnv.h>
 
 extern "C" {
 #include <unistd.h>
-#include <magic.h>
 #include <openssl/rsa.h>
 #include <openssl/pem.h>
 #include <openssl/bio.h>
@@ -72,119 +71,27 @@ bool CGenericFuncs::checkAndUnpackUrl(QUrl& url)
 
 QString CGenericFuncs::detectMIME(const QString &filename)
 {
-    magic_t myt = magic_open(MAGIC_ERROR|MAGIC_MIME_TYPE); // NOLINT
-    magic_load(myt,nullptr);
-    QByteArray bma = filename.toUtf8();
-    const char* bm = bma.data();
-    const char* mg = magic_file(myt,bm);
-    if (mg==nullptr) {
-        qCritical() << "libmagic error: " << magic_errno(myt) << QString::fromUtf8(magic_error(myt));
-        return QSL("text/plain");
-    }
-    QString mag = QString::fromLatin1(mg);
-    magic_close(myt);
-    return mag;
+    return CContentDetector::mimeTypeForFile(filename);
 }
 
 QString CGenericFuncs::detectMIME(const QByteArray &buf)
 {
-    magic_t myt = magic_open(MAGIC_ERROR|MAGIC_MIME_TYPE); // NOLINT
-    magic_load(myt,nullptr);
-    const char* mg = magic_buffer(myt,buf.data(),static_cast<size_t>(buf.length()));
-    if (mg==nullptr) {
-        qCritical() << "libmagic error: " << magic_errno(myt) << QString::fromUtf8(magic_error(myt));
-        return QSL("text/plain");
-    }
-    QString mag = QString::fromLatin1(mg);
-    magic_close(myt);
-    return mag;
+    return CContentDetector::mimeType(buf);
 }
 
 QString CGenericFuncs::detectEncodingName(const QByteArray& content)
 {
-    QString res;
-    QByteArray icu_enc;
-    UErrorCode status = U_ZERO_ERROR;
-    UCharsetDetector* csd = ucsdet_open(&status);
-    ucsdet_setText(csd, content.constData(), content.length(), &status);
-    const UCharsetMatch *ucm = ucsdet_detect(csd, &status);
-    if (U_SUCCESS(status) && (ucm != nullptr)) {
-        const char* cname = ucsdet_getName(ucm,&status);
-        if (U_SUCCESS(status))
-            icu_enc = QByteArray(cname);
-    }
-    if (!icu_enc.isEmpty())
-        res = QString::fromUtf8(icu_enc);
-    ucsdet_close(csd);
-
-    if (res.contains(QSL("x-sjis"),Qt::CaseInsensitive))
-        res = QSL("SJIS");
-
-    return res;
+    return CContentDetector::encodingName(content);
 }
 
 QString CGenericFuncs::detectDecodeToUnicode(const QByteArray& content)
 {
-    if (content.isEmpty())
-        return QString();
-
-    UErrorCode status = U_ZERO_ERROR;
-    UConverter *conv = nullptr;
-
-    auto cleanup = qScopeGuard([&conv]{
-        if (conv)
-            ucnv_close(conv);
-    });
-
-    const QString encoding = detectEncodingName(content);
-    if (encoding.isEmpty())
-        return QString::fromUtf8(content); // fallback
-
-    conv = ucnv_open(encoding.toUtf8().constData(),&status);
-    if (!U_SUCCESS(status) && (conv == nullptr))
-        return QString::fromUtf8(content);
-
-    std::vector<UChar> targetBuf(content.length() / static_cast<uint8_t>(ucnv_getMinCharSize(conv)));
-    int len = ucnv_toUChars(conv,targetBuf.data(),targetBuf.size(),content.constData(),content.length(),&status);
-    if (!U_SUCCESS(status))
-        return QString::fromUtf8(content);
-
-    return QString::fromUtf16(targetBuf.data(),len);
+    return CContentDetector::decodeToUnicode(content);
 }
 
 QByteArray CGenericFuncs::detectDecodeToUtf8(const QByteArray& content)
 {
-    if (content.isEmpty())
-        return QByteArray();
-
-    UErrorCode status = U_ZERO_ERROR;
-    UConverter *conv = nullptr;
-
-    auto cleanup = qScopeGuard([&conv]{
-        if (conv)
-            ucnv_close(conv);
-    });
-
-    const QString encoding = detectEncodingName(content);
-    if (encoding.toLower() == QSL("utf-8"))
-        return content;
-
-    if (encoding.isEmpty())
-        return QByteArray();
-
-    conv = ucnv_open(encoding.toUtf8().constData(),&status);
-    if (!U_SUCCESS(status) && (conv == nullptr))
-        return QByteArray();
-
-    int utf16len = content.length() / static_cast<uint8_t>(ucnv_getMinCharSize(conv));
-    QByteArray targetBuf(utf16len*4,'\0');
-    int len = ucnv_fromAlgorithmic(conv,UCNV_UTF8,targetBuf.data(),targetBuf.size(),content.constData(),content.length(),&status);
-    if (!U_SUCCESS(status))
-        return QByteArray();
-
-    targetBuf.truncate(len);
-
-    return targetBuf;
+    return CContentDetector::decodeToUtf8(content);
 }
 
 QList<QByteArray> CGenericFuncs::availableICUCodecs()
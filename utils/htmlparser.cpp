@@ -6,10 +6,8 @@ CHTMLParser::CHTMLParser() = default;
 
 CHTMLNode CHTMLParser::parseHTML(const QString &src)
 {
-    HTML::ParserDom parser;
-    parser.parse(src);
-    const CHTMLNode res(parser.getTree());
-    return res;
+    const CHTMLDocument doc(src);
+    return doc.toNode();
 }
 
 void CHTMLParser::generateHTML(const CHTMLNode &src, QString &html, bool reformat, int depth)
@@ -117,3 +115,413 @@ bool CHTMLNode::isTextNode() const
 {
     return (!isTag && !isComment);
 }
+
+class CHTMLDocument::Builder : public HTML::ParserSax
+{
+public:
+    explicit Builder(CHTMLDocument *doc)
+        : m_doc(doc)
+    {
+    }
+
+protected:
+    void beginParsing() override
+    {
+        CHTMLDocument::Node root;
+        root.isTag = true;
+        m_doc->m_nodes.push_back(root);
+        m_current = m_doc->root();
+    }
+
+    void foundText(const HTML::Node &node) override
+    {
+        CHTMLDocument::Node res;
+        res.text = { static_cast<int>(node.offset()), static_cast<int>(node.length()) };
+        res.tagName = res.text;
+        m_doc->appendNode(m_current,res);
+    }
+
+    void foundComment(const HTML::Node &node) override
+    {
+        CHTMLDocument::Node res;
+        res.text = { static_cast<int>(node.offset()), static_cast<int>(node.length()) };
+        res.tagName = res.text;
+        res.isComment = true;
+        m_doc->appendNode(m_current,res);
+    }
+
+    void foundTag(const HTML::Node &node, bool isEnd) override
+    {
+        const CHTMLDocument::Span text { static_cast<int>(node.offset()), static_cast<int>(node.length()) };
+        const int nameLength = static_cast<int>(node.tagName().length());
+
+        if (!isEnd) {
+            CHTMLDocument::Node res;
+            res.text = text;
+            res.tagName = { text.offset + 1, nameLength };
+            res.tagAtom = m_doc->internLower(res.tagName);
+            res.isTag = true;
+            m_doc->parseAttributes(res);
+            m_current = m_doc->appendNode(m_current,res);
+            return;
+        }
+
+        // Close nearest pending tag with the same name, unclosed tags on the way lose their children
+        QVector<int> path;
+        int idx = m_current;
+        while (idx != m_doc->root()) {
+            const auto &pending = m_doc->m_nodes[static_cast<size_t>(idx)];
+            if (m_doc->view(pending.tagName).compare(node.tagName(),Qt::CaseInsensitive) == 0) {
+                m_doc->m_nodes[static_cast<size_t>(idx)].closingText = text;
+                m_current = pending.parent;
+                for (const int unclosed : qAsConst(path))
+                    m_doc->flatten(unclosed);
+                return;
+            }
+            path.append(idx);
+            idx = pending.parent;
+        }
+
+        // Unmatched closing tag, treat as comment
+        CHTMLDocument::Node res;
+        res.text = text;
+        res.tagName = { text.offset + 2, nameLength };
+        res.isComment = true;
+        m_doc->appendNode(m_current,res);
+    }
+
+private:
+    CHTMLDocument *m_doc;
+    int m_current { 0 };
+};
+
+CHTMLDocument::CHTMLDocument(const QString &source)
+    : m_source(source)
+{
+    Builder builder(this);
+    builder.parse(m_source);
+}
+
+int CHTMLDocument::nodeCount() const
+{
+    return static_cast<int>(m_nodes.size());
+}
+
+int CHTMLDocument::parent(int node) const
+{
+    return m_nodes.at(static_cast<size_t>(node)).parent;
+}
+
+int CHTMLDocument::firstChild(int node) const
+{
+    return m_nodes.at(static_cast<size_t>(node)).firstChild;
+}
+
+int CHTMLDocument::nextSibling(int node) const
+{
+    return m_nodes.at(static_cast<size_t>(node)).nextSibling;
+}
+
+bool CHTMLDocument::isTag(int node) const
+{
+    return m_nodes.at(static_cast<size_t>(node)).isTag;
+}
+
+bool CHTMLDocument::isComment(int node) const
+{
+    return m_nodes.at(static_cast<size_t>(node)).isComment;
+}
+
+bool CHTMLDocument::isTextNode(int node) const
+{
+    const auto &n = m_nodes.at(static_cast<size_t>(node));
+    return (!n.isTag && !n.isComment);
+}
+
+QStringView CHTMLDocument::text(int node) const
+{
+    return view(m_nodes.at(static_cast<size_t>(node)).text);
+}
+
+QStringView CHTMLDocument::closingText(int node) const
+{
+    return view(m_nodes.at(static_cast<size_t>(node)).closingText);
+}
+
+QStringView CHTMLDocument::tagName(int node) const
+{
+    return view(m_nodes.at(static_cast<size_t>(node)).tagName);
+}
+
+int CHTMLDocument::tagAtom(int node) const
+{
+    return m_nodes.at(static_cast<size_t>(node)).tagAtom;
+}
+
+int CHTMLDocument::attributesCount(int node) const
+{
+    return m_nodes.at(static_cast<size_t>(node)).attributesCount;
+}
+
+QString CHTMLDocument::attributeName(int node, int idx) const
+{
+    const auto &n = m_nodes.at(static_cast<size_t>(node));
+    Q_ASSERT(idx >= 0 && idx < n.attributesCount);
+    return m_atoms.at(m_attributes.at(static_cast<size_t>(n.attributesBegin + idx)).name);
+}
+
+QStringView CHTMLDocument::attributeValue(int node, int idx) const
+{
+    const auto &n = m_nodes.at(static_cast<size_t>(node));
+    Q_ASSERT(idx >= 0 && idx < n.attributesCount);
+    return view(m_attributes.at(static_cast<size_t>(n.attributesBegin + idx)).value);
+}
+
+QStringView CHTMLDocument::attributeValue(int node, const QString &lowerName) const
+{
+    const int name = atom(lowerName);
+    if (name == invalidAtom)
+        return QStringView();
+
+    // Last value wins for duplicated attributes, same as in CHTMLNode hash
+    const auto &n = m_nodes.at(static_cast<size_t>(node));
+    for (int i = n.attributesCount - 1; i >= 0; i--) {
+        const auto &attr = m_attributes.at(static_cast<size_t>(n.attributesBegin + i));
+        if (attr.name == name)
+            return view(attr.value);
+    }
+    return QStringView();
+}
+
+int CHTMLDocument::atom(const QString &lowerName) const
+{
+    return m_atomIndex.value(lowerName,invalidAtom);
+}
+
+QString CHTMLDocument::atomName(int atom) const
+{
+    if (atom < 0 || atom >= m_atoms.count())
+        return QString();
+    return m_atoms.at(atom);
+}
+
+QStringView CHTMLDocument::view(const Span &span) const
+{
+    return QStringView(m_source).mid(span.offset,span.length);
+}
+
+int CHTMLDocument::internLower(const Span &span)
+{
+    // Scratch buffer keeps its capacity, so lookups of known atoms do not allocate
+    m_atomScratch.resize(span.length);
+    const QChar* src = m_source.constData() + span.offset;
+    for (int i = 0; i < span.length; i++)
+        m_atomScratch[i] = src[i].toLower();
+
+    auto it = m_atomIndex.constFind(m_atomScratch);
+    if (it != m_atomIndex.constEnd())
+        return it.value();
+
+    const int res = m_atoms.count();
+    const QString name(m_atomScratch.constData(),m_atomScratch.length());
+    m_atoms.append(name);
+    m_atomIndex.insert(name,res);
+    return res;
+}
+
+int CHTMLDocument::appendNode(int parent, const Node &node)
+{
+    const int idx = static_cast<int>(m_nodes.size());
+    m_nodes.push_back(node);
+    m_nodes.back().parent = parent;
+
+    auto &p = m_nodes[static_cast<size_t>(parent)];
+    if (p.lastChild == invalidNode) {
+        p.firstChild = idx;
+    } else {
+        m_nodes[static_cast<size_t>(p.lastChild)].nextSibling = idx;
+    }
+    p.lastChild = idx;
+    return idx;
+}
+
+void CHTMLDocument::flatten(int node)
+{
+    // Move children to be next siblings of the node
+    auto &n = m_nodes[static_cast<size_t>(node)];
+    if (n.firstChild == invalidNode) return;
+
+    const int first = n.firstChild;
+    const int last = n.lastChild;
+    for (int child = first; child != invalidNode; child = m_nodes[static_cast<size_t>(child)].nextSibling)
+        m_nodes[static_cast<size_t>(child)].parent = n.parent;
+
+    m_nodes[static_cast<size_t>(last)].nextSibling = n.nextSibling;
+    n.nextSibling = first;
+    n.firstChild = invalidNode;
+    n.lastChild = invalidNode;
+
+    auto &p = m_nodes[static_cast<size_t>(n.parent)];
+    if (p.lastChild == node)
+        p.lastChild = last;
+}
+
+void CHTMLDocument::parseAttributes(Node &node)
+{
+    // Same grammar as htmlcxx::HTML::Node::parseAttributes, but produces spans in the source
+    node.attributesBegin = static_cast<int>(m_attributes.size());
+    node.attributesCount = 0;
+
+    const QChar* s = m_source.constData() + node.text.offset;
+    const int n = node.text.length;
+    const auto addAttribute = [this,&node](const Span& key, const Span& value) {
+        Attribute attr;
+        attr.name = internLower(key);
+        attr.value = value;
+        m_attributes.push_back(attr);
+        node.attributesCount++;
+    };
+    const auto indexOf = [s,n](int from, QChar ch) {
+        for (int i = from; i < n; i++) {
+            if (s[i] == ch)
+                return i;
+        }
+        return -1;
+    };
+
+    int ptr = indexOf(0,u'<');
+    if (ptr < 0) return;
+    ptr++;
+
+    while (ptr < n && s[ptr].isSpace()) ptr++;
+    if (ptr >= n || !s[ptr].isLetter()) return;
+    while (ptr < n && !s[ptr].isSpace()) ptr++;
+    while (ptr < n && s[ptr].isSpace()) ptr++;
+
+    while (ptr < n && s[ptr] != u'>') {
+        while (ptr < n && !s[ptr].isLetterOrNumber() && !s[ptr].isSpace()) ptr++;
+        while (ptr < n && s[ptr].isSpace()) ptr++;
+
+        int end = ptr;
+        while (end < n && (s[end].isLetterOrNumber() || s[end] == u'-')) end++;
+        const Span key { node.text.offset + ptr, end - ptr };
+        ptr = end;
+
+        while (ptr < n && s[ptr].isSpace()) ptr++;
+
+        if (ptr >= n || s[ptr] != u'=') {
+            addAttribute(key,Span());
+            continue;
+        }
+
+        ptr++;
+        while (ptr < n && s[ptr].isSpace()) ptr++;
+        if (ptr < n && (s[ptr] == u'"' || s[ptr] == u'\'')) {
+            end = indexOf(ptr + 1,s[ptr]);
+            if (end < 0) {
+                const int end1 = indexOf(ptr + 1,u' ');
+                const int end2 = indexOf(ptr + 1,u'>');
+                if (end1 >= 0 && end1 < end2) {
+                    end = end1;
+                } else if (end2 >= 0) {
+                    end = end2;
+                } else {
+                    return;
+                }
+            }
+            int begin = ptr + 1;
+            while (begin < end && s[begin].isSpace()) begin++;
+            int trimmedEnd = end - 1;
+            while (trimmedEnd >= begin && s[trimmedEnd].isSpace()) trimmedEnd--;
+            addAttribute(key,{ node.text.offset + begin, trimmedEnd - begin + 1 });
+            ptr = end + 1;
+        } else {
+            end = ptr;
+            while (end < n && !s[end].isSpace() && s[end] != u'>') end++;
+            addAttribute(key,{ node.text.offset + ptr, end - ptr });
+            ptr = end;
+        }
+    }
+}
+
+CHTMLNode CHTMLDocument::toNode(int node) const
+{
+    const auto &n = m_nodes.at(static_cast<size_t>(node));
+
+    CHTMLNode res;
+    res.text = view(n.text).toString();
+    res.tagName = view(n.tagName).toString();
+    res.closingText = view(n.closingText).toString();
+    res.isTag = n.isTag;
+    res.isComment = n.isComment;
+    for (int i = 0; i < n.attributesCount; i++) {
+        const auto &attr = m_attributes.at(static_cast<size_t>(n.attributesBegin + i));
+        const QString &name = m_atoms.at(attr.name);
+        res.attributes.insert(name,view(attr.value).toString());
+        res.attributesOrder.append(name);
+    }
+
+    for (int child = n.firstChild; child != invalidNode; child = m_nodes.at(static_cast<size_t>(child)).nextSibling)
+        res.children.append(toNode(child));
+
+    return res;
+}
+
+void CHTMLDocument::generateHTML(QString &html, bool reformat) const
+{
+    html.reserve(html.length() + m_source.length());
+
+    // Iterative pre-order walk, same output as CHTMLParser::generateHTML
+    int node = root();
+    for (;;) {
+        const auto &n = m_nodes.at(static_cast<size_t>(node));
+        if (n.isTag && n.tagName.length > 0) {
+            html.append(u'<');
+            html.append(view(n.tagName));
+            for (int i = 0; i < n.attributesCount; i++) {
+                const auto &attr = m_attributes.at(static_cast<size_t>(n.attributesBegin + i));
+                const QStringView val = attributeValue(node,m_atoms.at(attr.name));
+                const QChar quote = val.contains(u'"') ? u'\'' : u'"';
+                html.append(u' ');
+                html.append(m_atoms.at(attr.name));
+                html.append(u'=');
+                html.append(quote);
+                html.append(val);
+                html.append(quote);
+            }
+            html.append(u'>');
+        } else {
+            html.append(view(n.text));
+        }
+
+        if (n.firstChild != invalidNode) {
+            node = n.firstChild;
+            continue;
+        }
+
+        for (;;) {
+            const auto &closing = m_nodes.at(static_cast<size_t>(node));
+            html.append(view(closing.closingText));
+            if (reformat)
+                html.append(u'\n');
+            if (node == root())
+                return;
+            if (closing.nextSibling != invalidNode) {
+                node = closing.nextSibling;
+                break;
+            }
+            node = closing.parent;
+        }
+    }
+}
+
+void CHTMLDocument::generatePlainText(QString &text) const
+{
+    // Nodes are stored in document order, flattening of unclosed tags preserves it
+    for (const auto &n : m_nodes) {
+        if (!n.isTag && !n.isComment) {
+            text.append(view(n.text));
+            text.append(u'\n');
+        }
+    }
+}
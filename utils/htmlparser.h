@@ -5,7 +5,9 @@
 #include <QVector>
 #include <QHash>
 #include <QStringList>
+#include <QStringView>
 #include <QUrl>
+#include <vector>
 
 #include "html/ParserDom.h"
 
@@ -36,6 +38,89 @@ public:
 
 Q_DECLARE_METATYPE(CHTMLNode)
 
+/* Read-mostly arena DOM. All nodes live in one contiguous buffer and refer to each other
+ * by index, text is kept as spans of the shared source string, tag and attribute names
+ * are interned as integer atoms. */
+class CHTMLDocument
+{
+public:
+    static const int invalidNode = -1;
+    static const int invalidAtom = -1;
+
+    explicit CHTMLDocument(const QString& source);
+    ~CHTMLDocument() = default;
+
+    int root() const { return 0; }
+    int nodeCount() const;
+    int parent(int node) const;
+    int firstChild(int node) const;
+    int nextSibling(int node) const;
+
+    bool isTag(int node) const;
+    bool isComment(int node) const;
+    bool isTextNode(int node) const;
+    QStringView text(int node) const;
+    QStringView closingText(int node) const;
+    QStringView tagName(int node) const;
+    int tagAtom(int node) const;
+
+    int attributesCount(int node) const;
+    QString attributeName(int node, int idx) const;
+    QStringView attributeValue(int node, int idx) const;
+    QStringView attributeValue(int node, const QString& lowerName) const;
+
+    int atom(const QString& lowerName) const;
+    QString atomName(int atom) const;
+
+    CHTMLNode toNode(int node = 0) const;
+    void generateHTML(QString &html, bool reformat = false) const;
+    void generatePlainText(QString &text) const;
+
+private:
+    struct Span {
+        int offset { 0 };
+        int length { 0 };
+    };
+
+    struct Attribute {
+        int name { invalidAtom };
+        Span value;
+    };
+
+    struct Node {
+        int parent { invalidNode };
+        int firstChild { invalidNode };
+        int lastChild { invalidNode };
+        int nextSibling { invalidNode };
+        Span text;
+        Span closingText;
+        Span tagName;
+        int tagAtom { invalidAtom };
+        int attributesBegin { 0 };
+        int attributesCount { 0 };
+        bool isTag { false };
+        bool isComment { false };
+    };
+
+    class Builder;
+    friend class Builder;
+
+    QString m_source;
+    std::vector<Node> m_nodes;
+    std::vector<Attribute> m_attributes;
+    QHash<QString,int> m_atomIndex;
+    QStringList m_atoms;
+    QString m_atomScratch;
+
+    Q_DISABLE_COPY(CHTMLDocument)
+
+    QStringView view(const Span& span) const;
+    int internLower(const Span& span);
+    int appendNode(int parent, const Node& node);
+    void flatten(int node);
+    void parseAttributes(Node& node);
+};
+
 class CHTMLParser
 {
 public:
@@ -35,6 +35,7 @@
  * ========================================================================*/
 
 #include <QDebug>
+#include <QFileInfo>
 #include "pdftotext.h"
 #include "pdfworkerprivate.h"
 
@@ -42,28 +43,32 @@
 #include <GlobalParams.h>
 #endif
 
-CPDFWorker::CPDFWorker(QObject *parent)
-    : QObject(parent),
-      dptr(new CPDFWorkerPrivate(this))
+CPDFWorker::CPDFWorker(const QString &filename, QObject *parent)
+    : CAbstractThreadWorker(parent),
+      dptr(new CPDFWorkerPrivate(this)),
+      m_filename(filename)
 {
 
 }
 
 CPDFWorker::~CPDFWorker() = default;
 
-void CPDFWorker::pdfToText(const QString &filename)
+QString CPDFWorker::workerDescription() const
 {
-#ifndef WITH_POPPLER
-    Q_UNUSED(filename)
+    return tr("PDF parser (%1)").arg(QFileInfo(m_filename).fileName());
+}
 
-    m_text = tr("pdfToText unavailable, JPReader compiled without poppler support.");
-    qCritical() << m_text;
-    Q_EMIT error(m_text);
+void CPDFWorker::startMain()
+{
+#ifndef WITH_POPPLER
+    const QString message = tr("pdfToText unavailable, JPReader compiled without poppler support.");
+    qCritical() << message;
+    Q_EMIT error(message);
 #else
     Q_D(CPDFWorker);
 
     bool err = false;
-    QString result = d->pdfToText(&err,filename);
+    QString result = d->pdfToText(&err,m_filename);
 
     if (err) {
         Q_EMIT error(result);
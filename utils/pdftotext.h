@@ -4,31 +4,33 @@
 #include <QObject>
 #include <QString>
 #include "global/structures.h"
+#include "abstractthreadworker.h"
 
 class CPDFWorkerPrivate;
 
-class CPDFWorker : public QObject
+class CPDFWorker : public CAbstractThreadWorker
 {
     Q_OBJECT
 public:
-    explicit CPDFWorker(QObject* parent = nullptr);
+    explicit CPDFWorker(const QString &filename, QObject* parent = nullptr);
     ~CPDFWorker() override;
     static void initPdfToText();
     static void freePdfToText();
+    QString workerDescription() const override;
 
 private:
     QScopedPointer<CPDFWorkerPrivate> dptr;
+    QString m_filename;
 
     Q_DISABLE_COPY(CPDFWorker)
     Q_DECLARE_PRIVATE_D(dptr,CPDFWorker)
 
-public Q_SLOTS:
-    void pdfToText(const QString &filename);
+protected:
+    void startMain() override;
 
 Q_SIGNALS:
     void gotText(const QString& result);
     void error(const QString& message);
-    void finished();
 
 };
 
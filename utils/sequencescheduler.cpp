@@ -28,6 +28,11 @@ int CSequenceScheduler::workerWeight()
     return -1;
 }
 
+CAbstractThreadWorker::WorkerCategory CSequenceScheduler::workerCategory() const
+{
+    return wcScheduler;
+}
+
 void CSequenceScheduler::startMain()
 {
     takeNextWorker();
@@ -21,6 +21,7 @@ public:
     QString workerDescription() const override;
     void setParams(const QList<QPointer<CAbstractThreadWorker> > &workers);
     int workerWeight() override;
+    WorkerCategory workerCategory() const override;
 
 protected:
     void startMain() override;
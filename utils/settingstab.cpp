@@ -226,6 +226,7 @@ void CSettingsTab::loadFromGlobal()
     updateAtlCertLabel();
     ui->tranRetryCnt->setValue(gSet->m_settings->translatorRetryCount);
     ui->domWorkerRetryTimeoutSec->setValue(gSet->m_settings->domWorkerReplyTimeoutSec);
+    ui->spinDomWorkerPoolSize->setValue(gSet->m_settings->domWorkerPoolSize);
 
     ui->editBingKey->setText(gSet->m_settings->bingKey);
     ui->editYandexKey->setText(gSet->m_settings->yandexKey);
@@ -271,8 +272,13 @@ void CSettingsTab::loadFromGlobal()
     ui->spinOpenAITopP->setValue(gSet->m_settings->openaiTopP);
     ui->spinOpenAIPresencePenalty->setValue(gSet->m_settings->openaiPresencePenalty);
     ui->spinOpenAIFrequencyPenalty->setValue(gSet->m_settings->openaiFrequencyPenalty);
+    ui->editOpenAIBaseUrl->setText(gSet->m_settings->openaiBaseUrl);
+    ui->checkOpenAIBatchParagraphs->setChecked(gSet->m_settings->openaiBatchParagraphs);
+    ui->checkOpenAIStreaming->setChecked(gSet->m_settings->openaiStreaming);
 
     ui->spinTokensMaxCountCombined->setValue(gSet->m_settings->tokensMaxCountCombined);
+    ui->spinTranslatorParallelRequests->setValue(gSet->m_settings->translatorParallelRequests);
+    ui->spinTranslatorBatchSize->setValue(gSet->m_settings->translatorBatchSize);
 
     ui->checkEmptyRestore->setChecked(gSet->m_settings->emptyRestore);
     ui->checkJSLogConsole->setChecked(gSet->m_settings->jsLogConsole);
@@ -359,6 +365,7 @@ void CSettingsTab::loadFromGlobal()
 
     ui->checkTranslatorCacheEnabled->setChecked(gSet->m_settings->translatorCacheEnabled);
     ui->spinTranslatorCacheSize->setValue(gSet->m_settings->translatorCacheSize);
+    ui->checkTranslatorCacheCompression->setChecked(gSet->m_settings->translatorCacheCompression);
 
     // flip proxy use check, for updating controls enabling logic
     ui->checkUseProxy->setChecked(true);
@@ -372,11 +379,16 @@ void CSettingsTab::loadFromGlobal()
     }
     ui->comboXapianStemmerLang->setCurrentIndex(stemIdx);
     ui->spinXapianStartDelay->setValue(gSet->m_settings->getXapianTimerInterval());
+    ui->spinXapianCommitBatchSize->setValue(gSet->m_settings->xapianCommitBatchSize);
     ui->listXapianIndexDirs->clear();
     ui->listXapianIndexDirs->addItems(gSet->m_settings->xapianIndexDirList);
 
     ui->spinMangaBlur->setValue(gSet->m_settings->mangaResizeBlur);
     ui->spinMangaCacheWidth->setValue(gSet->m_settings->mangaCacheWidth);
+    ui->spinMangaCacheMemory->setValue(gSet->m_settings->mangaCacheMemory);
+    ui->spinMangaCacheSpillMemory->setValue(gSet->m_settings->mangaCacheSpillMemory);
+    ui->spinMangaFetchConcurrency->setValue(gSet->m_settings->mangaFetchConcurrency);
+    ui->spinMangaFetchPerHost->setValue(gSet->m_settings->mangaFetchPerHost);
     ui->spinMangaMagnify->setValue(gSet->m_settings->mangaMagnifySize);
     ui->spinMangaScrollDelta->setValue(gSet->m_settings->mangaScrollDelta);
     ui->spinMangaScrollFactor->setValue(gSet->m_settings->mangaScrollFactor);
@@ -559,6 +571,10 @@ void CSettingsTab::setupSettingsObservers()
         if (m_loadingInterlock) return;
         gSet->m_settings->domWorkerReplyTimeoutSec=val;
     });
+    connect(ui->spinDomWorkerPoolSize,qOverload<int>(&QSpinBox::valueChanged),this,[this](int val){
+        if (m_loadingInterlock) return;
+        gSet->m_settings->domWorkerPoolSize=val;
+    });
     connect(ui->atlToken,&QLineEdit::textChanged,this,[this](const QString& val){
         if (m_loadingInterlock) return;
         gSet->m_settings->atlToken=val;
@@ -672,11 +688,31 @@ void CSettingsTab::setupSettingsObservers()
         if (m_loadingInterlock) return;
         gSet->m_settings->openaiFrequencyPenalty=val;
     });
+    connect(ui->editOpenAIBaseUrl,&QLineEdit::textChanged,this,[this](const QString& val){
+        if (m_loadingInterlock) return;
+        gSet->m_settings->openaiBaseUrl=val;
+    });
+    connect(ui->checkOpenAIBatchParagraphs,&QCheckBox::toggled,this,[this](bool val){
+        if (m_loadingInterlock) return;
+        gSet->m_settings->openaiBatchParagraphs=val;
+    });
+    connect(ui->checkOpenAIStreaming,&QCheckBox::toggled,this,[this](bool val){
+        if (m_loadingInterlock) return;
+        gSet->m_settings->openaiStreaming=val;
+    });
 
     connect(ui->spinTokensMaxCountCombined,qOverload<int>(&QSpinBox::valueChanged),this,[this](int val){
         if (m_loadingInterlock) return;
         gSet->m_settings->tokensMaxCountCombined=val;
     });
+    connect(ui->spinTranslatorParallelRequests,qOverload<int>(&QSpinBox::valueChanged),this,[this](int val){
+        if (m_loadingInterlock) return;
+        gSet->m_settings->translatorParallelRequests=val;
+    });
+    connect(ui->spinTranslatorBatchSize,qOverload<int>(&QSpinBox::valueChanged),this,[this](int val){
+        if (m_loadingInterlock) return;
+        gSet->m_settings->translatorBatchSize=val;
+    });
 
     connect(ui->checkEmptyRestore,&QCheckBox::toggled,this,[this](bool val){
         if (m_loadingInterlock) return;
@@ -846,6 +882,10 @@ void CSettingsTab::setupSettingsObservers()
         if (m_loadingInterlock) return;
         gSet->m_settings->translatorCacheEnabled = val;
     });
+    connect(ui->checkTranslatorCacheCompression,&QCheckBox::toggled,this,[this](bool val){
+        if (m_loadingInterlock) return;
+        gSet->m_settings->translatorCacheCompression = val;
+    });
     connect(ui->spinTranslatorCacheSize,qOverload<int>(&QSpinBox::valueChanged),this,[this](int val){
         if (m_loadingInterlock) return;
         gSet->m_settings->translatorCacheSize = val;
@@ -873,6 +913,10 @@ void CSettingsTab::setupSettingsObservers()
         if (m_loadingInterlock) return;
         gSet->m_settings->setupXapianTimerInterval(gSet,val);
     });
+    connect(ui->spinXapianCommitBatchSize,qOverload<int>(&QSpinBox::valueChanged),this,[this](int val){
+        if (m_loadingInterlock) return;
+        gSet->m_settings->xapianCommitBatchSize = val;
+    });
     connect(ui->comboXapianStemmerLang,qOverload<int>(&QComboBox::currentIndexChanged),this,[this](int val){
         Q_UNUSED(val)
         if (m_loadingInterlock) return;
@@ -930,6 +974,24 @@ void CSettingsTab::setupSettingsObservers()
         gSet->m_settings->mangaCacheWidth=val;
         Q_EMIT gSet->m_settings->mangaViewerSettingsUpdated();
     });
+    connect(ui->spinMangaCacheMemory,qOverload<int>(&QSpinBox::valueChanged),this,[this](int val){
+        if (m_loadingInterlock) return;
+        gSet->m_settings->mangaCacheMemory=val;
+        Q_EMIT gSet->m_settings->mangaViewerSettingsUpdated();
+    });
+    connect(ui->spinMangaCacheSpillMemory,qOverload<int>(&QSpinBox::valueChanged),this,[this](int val){
+        if (m_loadingInterlock) return;
+        gSet->m_settings->mangaCacheSpillMemory=val;
+        Q_EMIT gSet->m_settings->mangaViewerSettingsUpdated();
+    });
+    connect(ui->spinMangaFetchConcurrency,qOverload<int>(&QSpinBox::valueChanged),this,[this](int val){
+        if (m_loadingInterlock) return;
+        gSet->m_settings->mangaFetchConcurrency=val;
+    });
+    connect(ui->spinMangaFetchPerHost,qOverload<int>(&QSpinBox::valueChanged),this,[this](int val){
+        if (m_loadingInterlock) return;
+        gSet->m_settings->mangaFetchPerHost=val;
+    });
     connect(ui->spinMangaMagnify,qOverload<int>(&QSpinBox::valueChanged),this,[this](int val){
         if (m_loadingInterlock) return;
         gSet->m_settings->mangaMagnifySize=val;
@@ -45,9 +45,9 @@ CSourceViewer::~CSourceViewer()
 
 QString CSourceViewer::reformatSource(const QString& html)
 {
-    CHTMLNode doc = CHTMLParser::parseHTML(html);
+    const CHTMLDocument doc(html);
     QString dst;
-    CHTMLParser::generateHTML(doc,dst,true,0);
+    doc.generateHTML(dst,true);
     return dst;
 }
 
@@ -9,7 +9,7 @@
 #include "utils/genericfuncs.h"
 
 namespace CDefaults {
-const int workerMonitorColumnCount = 3;
+const int workerMonitorColumnCount = 4;
 const int workerMonitorUpdateTimeMS = 5000;
 }
 
@@ -43,6 +43,11 @@ void CWorkerMonitor::workerStarted(CAbstractThreadWorker *worker)
     m_model->workerStarted(worker);
 }
 
+void CWorkerMonitor::workerDispatched(CAbstractThreadWorker *worker)
+{
+    m_model->workerDispatched(worker);
+}
+
 void CWorkerMonitor::workerAboutToFinished(CAbstractThreadWorker *worker)
 {
     m_model->workerAboutToFinished(worker);
@@ -130,7 +135,8 @@ QVariant CWorkerMonitorModel::data(const QModelIndex &index, int role) const
             case 1: return QSL("%1 / %2 requests")
                         .arg(CGenericFuncs::formatFileSize(t.loadedTotalSize))
                         .arg(t.loadedRequestCount);
-            case 2: {
+            case 2: return (t.queued ? tr("Queued") : tr("Running"));
+            case 3: {
                 const QDateTime now = QDateTime::currentDateTime();
                 return QSL("%1 (since %2)")
                         .arg(CGenericFuncs::secsToString(t.started.secsTo(now)),
@@ -149,7 +155,8 @@ QVariant CWorkerMonitorModel::headerData(int section, Qt::Orientation orientatio
         switch (section) {
             case 0: return tr("Description");
             case 1: return tr("Data transfer");
-            case 2: return tr("Processing time");
+            case 2: return tr("Status");
+            case 3: return tr("Processing time");
             default: return QVariant();
         }
     }
@@ -196,6 +203,16 @@ void CWorkerMonitorModel::workerStarted(CAbstractThreadWorker *worker)
     endInsertRows();
 }
 
+void CWorkerMonitorModel::workerDispatched(CAbstractThreadWorker *worker)
+{
+    int row = m_data.indexOf(CWorkerMonitorItem(worker,false));
+    if (row<0) return;
+
+    m_data[row].queued = false;
+    m_data[row].started = QDateTime::currentDateTime();
+    Q_EMIT dataChanged(index(row,0),index(row,CDefaults::workerMonitorColumnCount-1));
+}
+
 void CWorkerMonitorModel::workerAboutToFinished(CAbstractThreadWorker *worker)
 {
     int row = m_data.indexOf(CWorkerMonitorItem(worker,false));
@@ -219,7 +236,7 @@ void CWorkerMonitorModel::abortWorker(const QModelIndex &index)
 
 void CWorkerMonitorModel::updateAllWorkerTimes()
 {
-    const int timeColumn = 2;
+    const int timeColumn = 3;
     Q_EMIT dataChanged(index(0,timeColumn),
                        index(m_data.count()-1,timeColumn));
 }
@@ -247,6 +264,7 @@ CWorkerMonitorItem::CWorkerMonitorItem(CAbstractThreadWorker *w, bool fullInit)
         description = worker->workerDescription();
         started = QDateTime::currentDateTime();
         weight = worker->workerWeight();
+        queued = worker->isQueued();
     }
 }
 
@@ -12,6 +12,7 @@ class CWorkerMonitorItem
 {
 public:
     int weight { 0 };
+    bool queued { false };
     QString description;
     qint64 loadedTotalSize { 0L };
     qint64 loadedRequestCount { 0L };
@@ -43,6 +44,7 @@ public:
     explicit CWorkerMonitor(QWidget *parent = nullptr);
     ~CWorkerMonitor() override;
     void workerStarted(CAbstractThreadWorker *worker);
+    void workerDispatched(CAbstractThreadWorker *worker);
     void workerAboutToFinished(CAbstractThreadWorker *worker);
 
 private:
@@ -86,6 +88,7 @@ public:
     int columnCount(const QModelIndex &parent) const override;
 
     void workerStarted(CAbstractThreadWorker *worker);
+    void workerDispatched(CAbstractThreadWorker *worker);
     void workerAboutToFinished(CAbstractThreadWorker *worker);
     void abortWorker(const QModelIndex& index);
     void updateAllWorkerTimes();